@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -25,6 +26,15 @@
 
 namespace CryptoNote {
 
+// Read-only view of the data base as it was at the moment of its creation. Can be read from any thread.
+class IDataBaseSnapshot {
+public:
+  virtual ~IDataBaseSnapshot() {
+  }
+
+  virtual std::error_code read(IReadBatch& batch) = 0;
+};
+
 class IDataBase {
 public:
   virtual ~IDataBase() {
@@ -34,5 +44,14 @@ public:
   virtual std::error_code writeSync(IWriteBatch& batch) = 0;
 
   virtual std::error_code read(IReadBatch& batch) = 0;
+
+  // Between these calls writes may be buffered in memory and applied without write-ahead log,
+  // reads still see them. endBulkWrite makes everything written so far durable.
+  virtual void beginBulkWrite() = 0;
+  virtual std::error_code endBulkWrite() = 0;
+
+  // Thread-safe. Returns nullptr if a consistent snapshot can't be taken right now.
+  // A snapshot must be destroyed before the data base is shut down.
+  virtual std::unique_ptr<IDataBaseSnapshot> createSnapshot() = 0;
 };
 }
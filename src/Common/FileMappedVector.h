@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include <boost/filesystem.hpp>
@@ -279,6 +281,10 @@ public:
   bool getAutoFlush() const;
   void setAutoFlush(bool autoFlush);
 
+  // 0 means growing by copying the file. Otherwise the file is extended in place by growthStep elements at once
+  uint64_t getGrowthStep() const;
+  void setGrowthStep(uint64_t growthStep);
+
   void flush();
 
   const uint8_t* prefix() const;
@@ -303,6 +309,7 @@ private:
   uint64_t m_prefixSize;
   uint64_t m_suffixSize;
   bool m_autoFlush;
+  uint64_t m_growthStep;
 
 private:
   template<class F>
@@ -312,6 +319,7 @@ private:
 
   void open(const std::string& path, uint64_t prefixSize);
   void create(const std::string& path, uint64_t initialCapacity, uint64_t prefixSize, uint64_t suffixSize);
+  void growInPlace(uint64_t newCapacity);
 
   uint8_t* prefixPtr();
   const uint8_t* prefixPtr() const;
@@ -334,13 +342,15 @@ private:
 
 template<class T>
 FileMappedVector<T>::FileMappedVector() :
-  m_autoFlush(true)
+  m_autoFlush(true),
+  m_growthStep(0)
 {
 }
 
 template<class T>
 FileMappedVector<T>::FileMappedVector(const std::string& path, FileMappedVectorOpenMode mode, uint64_t prefixSize) :
-  m_autoFlush(true)
+  m_autoFlush(true),
+  m_growthStep(0)
 {
   open(path, mode, prefixSize);
 }
@@ -432,6 +442,11 @@ void FileMappedVector<T>::reserve(uint64_t n) {
   assert(isOpened());
 
   if (n > capacity()) {
+    if (m_growthStep != 0) {
+      growInPlace(n);
+      return;
+    }
+
     atomicUpdate(size(), n, prefixSize(), suffixSize(), [this](value_type* target) {
       std::copy(cbegin(), cend(), target);
     });
@@ -590,6 +605,13 @@ typename FileMappedVector<T>::iterator FileMappedVector<T>::erase(const_iterator
 
   uint64_t newSize = size() - std::distance(first, last);
 
+  if (last == cend()) {
+    // nothing has to be moved, the size is the only thing to update
+    *sizePtr() = newSize;
+    flushSize();
+    return iterator(this, first.index());
+  }
+
   atomicUpdate(newSize, capacity(), prefixSize(), suffixSize(), [this, first, last](value_type* target) {
     std::copy(cbegin(), first, target);
     std::copy(last, cend(), target + std::distance(cbegin(), first));
@@ -611,6 +633,23 @@ typename FileMappedVector<T>::iterator FileMappedVector<T>::insert(const_iterato
   assert(isOpened());
 
   uint64_t newSize = size() + static_cast<uint64_t>(std::distance(first, last));
+  if (position == cend() && newSize > capacity() && m_growthStep != 0) {
+    reserve(std::max(nextCapacity(), newSize));
+  }
+
+  if (position == cend() && newSize <= capacity()) {
+    // appended elements are written past the end, they become visible only when the size is updated
+    std::copy(first, last, vectorDataPtr() + size());
+    if (m_autoFlush) {
+      m_file.flush(reinterpret_cast<uint8_t*>(vectorDataPtr() + size()), (newSize - size()) * valueSize);
+    }
+
+    uint64_t index = size();
+    *sizePtr() = newSize;
+    flushSize();
+    return iterator(this, index);
+  }
+
   uint64_t newCapacity;
   if (newSize > capacity()) {
     newCapacity = nextCapacity();
@@ -671,6 +710,16 @@ void FileMappedVector<T>::setAutoFlush(bool autoFlush) {
   m_autoFlush = autoFlush;
 }
 
+template<class T>
+uint64_t FileMappedVector<T>::getGrowthStep() const {
+  return m_growthStep;
+}
+
+template<class T>
+void FileMappedVector<T>::setGrowthStep(uint64_t growthStep) {
+  m_growthStep = growthStep;
+}
+
 template<class T>
 void FileMappedVector<T>::flush() {
   assert(isOpened());
@@ -860,6 +909,27 @@ void FileMappedVector<T>::create(const std::string& path, uint64_t initialCapaci
   m_file.flush(reinterpret_cast<uint8_t*>(sizePtr()), metadataSize);
 }
 
+// The file is extended first and the suffix is moved to its new end, the capacity is written last.
+// A crash before that leaves the old capacity, the old suffix is then followed by the added bytes
+template<class T>
+void FileMappedVector<T>::growInPlace(uint64_t newCapacity) {
+  if (m_file.path() != m_path) {
+    throw std::runtime_error("Vector is mapped to a .bak file due to earlier errors");
+  }
+
+  uint64_t suffixOffset = static_cast<uint64_t>(suffixPtr() - prefixPtr());
+  uint64_t newSuffixOffset = m_prefixSize + metadataSize + newCapacity * valueSize;
+  m_file.resize(newSuffixOffset + m_suffixSize);
+
+  if (m_suffixSize != 0) {
+    std::memmove(prefixPtr() + newSuffixOffset, prefixPtr() + suffixOffset, static_cast<size_t>(m_suffixSize));
+    m_file.flush(prefixPtr() + newSuffixOffset, m_suffixSize);
+  }
+
+  *capacityPtr() = newCapacity;
+  m_file.flush(reinterpret_cast<uint8_t*>(capacityPtr()), sizeof(uint64_t));
+}
+
 template<class T>
 uint8_t* FileMappedVector<T>::prefixPtr() {
   return m_file.data();
@@ -917,6 +987,10 @@ uint64_t FileMappedVector<T>::vectorDataSize() {
 
 template<class T>
 uint64_t FileMappedVector<T>::nextCapacity() {
+  if (m_growthStep != 0) {
+    return capacity() + m_growthStep;
+  }
+
   return capacity() + capacity() / 2 + 1;
 }
 
@@ -0,0 +1,121 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <set>
+#include <utility>
+
+namespace Common {
+
+// Median of the last windowSize pushed values, updated in O(log n) per push.
+// Returns the same value as medianValue() called on the window contents.
+template <class T>
+class RollingMedian {
+public:
+  explicit RollingMedian(size_t windowSize) : windowSize(windowSize), nextSequence(0) {
+    assert(windowSize > 0);
+  }
+
+  RollingMedian(const RollingMedian&) = delete;
+  RollingMedian& operator=(const RollingMedian&) = delete;
+
+  void push(T value) {
+    if (order.size() == windowSize) {
+      erase(order.front());
+      order.pop_front();
+    }
+
+    order.push_back(insert(std::make_pair(value, nextSequence++)));
+  }
+
+  void clear() {
+    order.clear();
+    values.clear();
+  }
+
+  size_t size() const {
+    return order.size();
+  }
+
+  size_t getWindowSize() const {
+    return windowSize;
+  }
+
+  T median() const {
+    if (values.empty()) {
+      return T();
+    }
+
+    if (values.size() % 2) {
+      return middle->first;
+    }
+
+    return (std::prev(middle)->first + middle->first) / 2;
+  }
+
+private:
+  // sequence number makes every element unique, so that elements equal by value are still ordered
+  typedef std::set<std::pair<T, uint64_t>> Values;
+
+  // middle points to the element with index size / 2 in sorted order
+  typename Values::iterator insert(const typename Values::value_type& value) {
+    auto it = values.insert(value).first;
+    if (values.size() == 1) {
+      middle = it;
+    } else if (value < *middle) {
+      if (values.size() % 2) {
+        --middle;
+      }
+    } else if (values.size() % 2 == 0) {
+      ++middle;
+    }
+
+    return it;
+  }
+
+  void erase(typename Values::iterator it) {
+    if (it == middle) {
+      if (values.size() % 2) {
+        ++middle;
+      } else {
+        --middle;
+      }
+    } else if (*it < *middle) {
+      if (values.size() % 2) {
+        ++middle;
+      }
+    } else if (values.size() % 2 == 0) {
+      --middle;
+    }
+
+    values.erase(it);
+  }
+
+  const size_t windowSize;
+  uint64_t nextSequence;
+  Values values;
+  std::deque<typename Values::iterator> order;
+  typename Values::iterator middle;
+};
+
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WorkerPool.h"
+
+#include <cassert>
+
+namespace Common {
+
+WorkerPool::WorkerPool(size_t threadCount) :
+  currentJob(nullptr),
+  currentJobCount(0),
+  nextJobIndex(0),
+  failed(false),
+  busyWorkers(0),
+  generation(0),
+  stopped(false) {
+
+  threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(std::bind(&WorkerPool::workerProcedure, this));
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped = true;
+    haveWork.notify_all();
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+size_t WorkerPool::getThreadCount() const {
+  return threads.size();
+}
+
+bool WorkerPool::run(size_t jobCount, const std::function<bool(size_t)>& job) {
+  if (threads.empty() || jobCount < 2) {
+    for (size_t i = 0; i < jobCount; ++i) {
+      if (!job(i)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    assert(currentJob == nullptr);
+
+    currentJob = &job;
+    currentJobCount = jobCount;
+    nextJobIndex = 0;
+    failed = false;
+    jobException = nullptr;
+    busyWorkers = threads.size();
+    ++generation;
+    haveWork.notify_all();
+  }
+
+  processJobs();
+
+  std::exception_ptr exception;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return busyWorkers == 0; });
+    currentJob = nullptr;
+    exception = jobException;
+    jobException = nullptr;
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return !failed;
+}
+
+void WorkerPool::workerProcedure() {
+  uint64_t processedGeneration = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      haveWork.wait(lock, [&] { return stopped || generation != processedGeneration; });
+      if (stopped) {
+        return;
+      }
+
+      processedGeneration = generation;
+    }
+
+    processJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (--busyWorkers == 0) {
+      workDone.notify_all();
+    }
+  }
+}
+
+void WorkerPool::processJobs() {
+  while (!failed) {
+    size_t index = nextJobIndex++;
+    if (index >= currentJobCount) {
+      break;
+    }
+
+    try {
+      if (!(*currentJob)(index)) {
+        failed = true;
+      }
+    } catch (...) {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!jobException) {
+        jobException = std::current_exception();
+      }
+
+      failed = true;
+    }
+  }
+}
+
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+// Fixed set of threads executing indexed jobs on behalf of a single caller.
+// The calling thread takes part in the work, so a pool with zero threads runs jobs serially.
+class WorkerPool {
+public:
+  explicit WorkerPool(size_t threadCount);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t getThreadCount() const;
+
+  // Calls job(i) for every i in [0, jobCount) and blocks until all started jobs are finished.
+  // Returns false as soon as any job returns false, jobs which weren't started yet are skipped.
+  // An exception thrown by a job is rethrown to the caller. Not reentrant.
+  bool run(size_t jobCount, const std::function<bool(size_t)>& job);
+
+private:
+  void workerProcedure();
+  void processJobs();
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable haveWork;
+  std::condition_variable workDone;
+
+  const std::function<bool(size_t)>* currentJob;
+  size_t currentJobCount;
+  std::atomic<size_t> nextJobIndex;
+  std::atomic<bool> failed;
+  std::exception_ptr jobException;
+  size_t busyWorkers;
+  uint64_t generation;
+  bool stopped;
+};
+
+}
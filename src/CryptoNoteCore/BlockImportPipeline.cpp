@@ -0,0 +1,149 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "BlockImportPipeline.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t BLOCKS_IN_FLIGHT_PER_THREAD = 32;
+
+}
+
+BlockImportPipeline::BlockImportPipeline(const IMainChainStorage& storage, uint32_t startIndex, uint32_t endIndex, size_t threadCount,
+                                         PrepareFunction prepare) :
+  storage(storage),
+  startIndex(startIndex),
+  endIndex(endIndex),
+  maxBlocksInFlight(std::max<size_t>(threadCount, 1) * BLOCKS_IN_FLIGHT_PER_THREAD),
+  prepare(std::move(prepare)),
+  readBlocks(maxBlocksInFlight),
+  preparedBlocks(maxBlocksInFlight),
+  nextIndex(startIndex),
+  blocksInFlight(0),
+  stopped(false) {
+
+  assert(startIndex <= endIndex);
+
+  reader = std::thread(std::bind(&BlockImportPipeline::readerProcedure, this));
+  for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i) {
+    workers.emplace_back(std::bind(&BlockImportPipeline::workerProcedure, this));
+  }
+}
+
+BlockImportPipeline::~BlockImportPipeline() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped = true;
+    blockTaken.notify_all();
+  }
+
+  readBlocks.close();
+
+  reader.join();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+std::unique_ptr<PreparedBlock> BlockImportPipeline::next() {
+  assert(nextIndex < endIndex);
+
+  std::unique_ptr<PreparedBlock> block;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto& slot = preparedBlocks[(nextIndex - startIndex) % maxBlocksInFlight];
+    blockPrepared.wait(lock, [&slot] { return slot != nullptr; });
+
+    block = std::move(slot);
+    ++nextIndex;
+    --blocksInFlight;
+    blockTaken.notify_one();
+  }
+
+  assert(block->index == nextIndex - 1);
+  if (block->error) {
+    std::rethrow_exception(block->error);
+  }
+
+  return block;
+}
+
+void BlockImportPipeline::readerProcedure() {
+  for (uint32_t index = startIndex; index < endIndex; ++index) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      blockTaken.wait(lock, [this] { return stopped || blocksInFlight < maxBlocksInFlight; });
+      if (stopped) {
+        break;
+      }
+
+      ++blocksInFlight;
+    }
+
+    std::unique_ptr<PreparedBlock> block(new PreparedBlock());
+    block->index = index;
+    block->cumulativeSize = 0;
+    block->cumulativeFee = 0;
+    block->transactionsExtracted = false;
+
+    try {
+      block->rawBlock = storage.getBlockByIndex(index);
+    } catch (...) {
+      block->error = std::current_exception();
+      setPrepared(std::move(block));
+      continue;
+    }
+
+    if (!readBlocks.push(std::move(block))) {
+      break;
+    }
+  }
+
+  readBlocks.close();
+}
+
+void BlockImportPipeline::workerProcedure() {
+  std::unique_ptr<PreparedBlock> block;
+  while (readBlocks.pop(block)) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (stopped) {
+        break;
+      }
+    }
+
+    try {
+      prepare(*block);
+    } catch (...) {
+      block->error = std::current_exception();
+    }
+
+    setPrepared(std::move(block));
+  }
+}
+
+void BlockImportPipeline::setPrepared(std::unique_ptr<PreparedBlock>&& block) {
+  std::unique_lock<std::mutex> lock(mutex);
+  preparedBlocks[(block->index - startIndex) % maxBlocksInFlight] = std::move(block);
+  blockPrepared.notify_all();
+}
+
+}
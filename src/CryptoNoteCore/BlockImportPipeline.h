@@ -0,0 +1,90 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Common/BlockingQueue.h>
+
+#include "CachedBlock.h"
+#include "CachedTransaction.h"
+#include "IMainChainStorage.h"
+#include "TransactionValidatiorState.h"
+
+namespace CryptoNote {
+
+struct PreparedBlock {
+  uint32_t index;
+  RawBlock rawBlock;
+  BlockTemplate blockTemplate;
+  std::unique_ptr<CachedBlock> cachedBlock; //refers to blockTemplate
+  std::vector<CachedTransaction> transactions;
+  TransactionValidatorState spentOutputs;
+  uint64_t cumulativeSize;
+  uint64_t cumulativeFee;
+  bool transactionsExtracted;
+  std::exception_ptr error;
+};
+
+// Reads blocks [startIndex, endIndex) from the storage in a separate thread, prepares them
+// on worker threads and hands them out in storage order.
+// Storage must not be used by anybody else while the pipeline exists.
+class BlockImportPipeline {
+public:
+  typedef std::function<void(PreparedBlock&)> PrepareFunction;
+
+  BlockImportPipeline(const IMainChainStorage& storage, uint32_t startIndex, uint32_t endIndex, size_t threadCount, PrepareFunction prepare);
+  ~BlockImportPipeline();
+
+  BlockImportPipeline(const BlockImportPipeline&) = delete;
+  BlockImportPipeline& operator=(const BlockImportPipeline&) = delete;
+
+  // Blocks until the next block is prepared. Rethrows an error occurred while the block was read or prepared.
+  std::unique_ptr<PreparedBlock> next();
+
+private:
+  void readerProcedure();
+  void workerProcedure();
+  void setPrepared(std::unique_ptr<PreparedBlock>&& block);
+
+  const IMainChainStorage& storage;
+  const uint32_t startIndex;
+  const uint32_t endIndex;
+  const size_t maxBlocksInFlight;
+  PrepareFunction prepare;
+
+  BlockingQueue<std::unique_ptr<PreparedBlock>> readBlocks;
+  std::vector<std::unique_ptr<PreparedBlock>> preparedBlocks;
+  uint32_t nextIndex;
+  size_t blocksInFlight;
+  bool stopped;
+  std::mutex mutex;
+  std::condition_variable blockPrepared;
+  std::condition_variable blockTaken;
+
+  std::thread reader;
+  std::vector<std::thread> workers;
+};
+
+}
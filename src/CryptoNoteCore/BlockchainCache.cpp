@@ -111,7 +111,8 @@ bool serialize(PackedOutIndex& value, Common::StringView name, CryptoNote::ISeri
 
 BlockchainCache::BlockchainCache(const std::string& filename, const Currency& currency, Logging::ILogger& logger_,
                                  IBlockchainCache* parent, uint32_t splitBlockIndex)
-    : filename(filename), currency(currency), logger(logger_, "BlockchainCache"), parent(parent), storage(new BlockchainStorage(100)) {
+    : filename(filename), currency(currency), logger(logger_, "BlockchainCache"), parent(parent), storage(new BlockchainStorage(100)),
+      difficultyCache(currency) {
   if (parent == nullptr) {
     startIndex = 0;
 
@@ -191,6 +192,8 @@ void BlockchainCache::doPushBlock(const CachedBlock& cachedBlock,
   auto blockIndex = cachedBlock.getBlockIndex();
   assert(blockIndex == blockInfos.size() + startIndex - 1);
 
+  difficultyCache.push(blockIndex, cachedBlock.getBlock().timestamp, cumulativeDifficulty);
+
   for (const auto& keyImage : validatorState.spentKeyImages) {
     addSpentKeyImage(keyImage, blockIndex);
   }
@@ -271,10 +274,30 @@ std::unique_ptr<IBlockchainCache> BlockchainCache::split(uint32_t splitBlockInde
   newCache->children = children;
   children = { newCache.get() };
 
+  difficultyCache.reset();
+
   logger(Logging::DEBUGGING) << "Split successfully completed";
   return std::move(newCache);
 }
 
+void BlockchainCache::truncate(uint32_t startIndex) {
+  assert(children.empty());
+
+  auto tail = split(startIndex);
+  deleteChild(tail.get());
+}
+
+// blocks of a segment are in memory while it is an alternative chain, only the root segment drops transactions
+void BlockchainCache::pruneBlocks(uint32_t endIndex) {
+  if (parent != nullptr) {
+    parent->pruneBlocks(std::min(endIndex, startIndex));
+  }
+}
+
+uint32_t BlockchainCache::getPrunedBlockCount() const {
+  return parent != nullptr ? parent->getPrunedBlockCount() : 0;
+}
+
 void BlockchainCache::splitSpentKeyImages(BlockchainCache& newCache, uint32_t splitBlockIndex) {
   //Key images with blockIndex == splitBlockIndex remain in upper segment
   auto& imagesIndex = spentKeyImages.get<BlockIndexTag>();
@@ -436,6 +459,13 @@ bool BlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage) const {
   return parent != nullptr && parent->checkIfSpent(keyImage);
 }
 
+// segment data is in memory, only the root segment may need to read storage
+void BlockchainCache::prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const {
+  if (parent != nullptr) {
+    parent->prefetchKeyInputs(inputs);
+  }
+}
+
 uint32_t BlockchainCache::getBlockCount() const {
   return static_cast<uint32_t>(blockInfos.size());
 }
@@ -686,6 +716,7 @@ void BlockchainCache::load() {
   CryptoNote::BinaryInputStreamSerializer s(stream);
 
   serialize(s);
+  difficultyCache.reset();
 }
 
 bool BlockchainCache::isTransactionSpendTimeUnlocked(uint64_t unlockTime) const {
@@ -947,10 +978,19 @@ Difficulty BlockchainCache::getDifficultyForNextBlock() const {
 
 Difficulty BlockchainCache::getDifficultyForNextBlock(uint32_t blockIndex) const {
   assert(blockIndex <= getTopBlockIndex());
+  if (difficultyCache.isLoaded(blockIndex)) {
+    return difficultyCache.getNextDifficulty();
+  }
+
   auto timestamps = getLastTimestamps(currency.difficultyBlocksCount(), blockIndex, skipGenesisBlock);
   auto commulativeDifficulties =
       getLastCumulativeDifficulties(currency.difficultyBlocksCount(), blockIndex, skipGenesisBlock);
-  return currency.nextDifficulty(std::move(timestamps), std::move(commulativeDifficulties));
+  if (blockIndex != getTopBlockIndex()) {
+    return currency.nextDifficulty(std::move(timestamps), std::move(commulativeDifficulties));
+  }
+
+  difficultyCache.load(blockIndex, timestamps, commulativeDifficulties);
+  return difficultyCache.getNextDifficulty();
 }
 
 Difficulty BlockchainCache::getCurrentCumulativeDifficulty() const {
@@ -32,6 +32,7 @@
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "Difficulty.h"
+#include "DifficultyCache.h"
 #include "IBlockchainCache.h"
 
 namespace CryptoNote {
@@ -96,6 +97,9 @@ public:
   //Returns upper part of segment. [this] remains lower part.
   //All of indexes on blockIndex == splitBlockIndex belong to upper part
   std::unique_ptr<IBlockchainCache> split(uint32_t splitBlockIndex) override;
+  void truncate(uint32_t startIndex) override;
+  void pruneBlocks(uint32_t endIndex) override;
+  uint32_t getPrunedBlockCount() const override;
   virtual void pushBlock(const CachedBlock& cachedBlock,
     const std::vector<CachedTransaction>& cachedTransactions,
     const TransactionValidatorState& validatorState,
@@ -107,6 +111,7 @@ public:
   virtual PushedBlockInfo getPushedBlockInfo(uint32_t index) const override;
   bool checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const override;
   bool checkIfSpent(const Crypto::KeyImage& keyImage) const override;
+  void prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const override;
 
   bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const override;
   bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const override;
@@ -283,6 +288,7 @@ private:
   std::unique_ptr<BlockchainStorage> storage;
 
   std::vector<IBlockchainCache*> children;
+  mutable DifficultyCache difficultyCache;
 
   void serialize(ISerializer& s);
 
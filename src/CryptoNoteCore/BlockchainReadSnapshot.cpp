@@ -0,0 +1,105 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockchainReadSnapshot.h"
+
+#include <stdexcept>
+#include <system_error>
+
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+
+namespace CryptoNote {
+
+BlockchainReadSnapshot::BlockchainReadSnapshot(std::unique_ptr<IDataBaseSnapshot>&& snapshot, uint32_t topBlockIndex) :
+  snapshot(std::move(snapshot)), topBlockIndex(topBlockIndex) {
+  auto indexBatch = BlockchainReadBatch().requestLastBlockIndex();
+  auto lastBlockIndex = read(indexBatch).getLastBlockIndex();
+  if (!lastBlockIndex.second || lastBlockIndex.first < topBlockIndex) {
+    throw std::runtime_error("Top block index does not exist in database");
+  }
+
+  auto blockBatch = BlockchainReadBatch().requestCachedBlock(topBlockIndex);
+  topBlockHash = read(blockBatch).getCachedBlocks().at(topBlockIndex).blockHash;
+}
+
+uint32_t BlockchainReadSnapshot::getTopBlockIndex() const {
+  return topBlockIndex;
+}
+
+const Crypto::Hash& BlockchainReadSnapshot::getTopBlockHash() const {
+  return topBlockHash;
+}
+
+void BlockchainReadSnapshot::getRawTransactions(const std::vector<Crypto::Hash>& transactions,
+                                                std::vector<BinaryArray>& foundTransactions,
+                                                std::vector<Crypto::Hash>& missedTransactions) const {
+  BlockchainReadBatch transactionsBatch;
+  for (auto& hash : transactions) {
+    transactionsBatch.requestCachedTransaction(hash);
+  }
+
+  auto transactionsResult = read(transactionsBatch);
+  auto& transactionInfos = transactionsResult.getCachedTransactions();
+
+  BlockchainReadBatch blocksBatch;
+  for (auto& transactionInfo : transactionInfos) {
+    if (transactionInfo.second.blockIndex <= topBlockIndex) {
+      blocksBatch.requestRawBlock(transactionInfo.second.blockIndex);
+    }
+  }
+
+  auto blocksResult = read(blocksBatch);
+  auto& blocks = blocksResult.getRawBlocks();
+
+  foundTransactions.reserve(foundTransactions.size() + transactions.size());
+  for (auto& hash : transactions) {
+    auto transactionIt = transactionInfos.find(hash);
+    if (transactionIt == transactionInfos.end() || transactionIt->second.blockIndex > topBlockIndex) {
+      missedTransactions.push_back(hash);
+      continue;
+    }
+
+    auto blockIt = blocks.find(transactionIt->second.blockIndex);
+    if (blockIt == blocks.end()) {
+      missedTransactions.push_back(hash);
+      continue;
+    }
+
+    auto transactionIndex = transactionIt->second.transactionIndex;
+    if (transactionIndex == 0) {
+      auto block = fromBinaryArray<BlockTemplate>(blockIt->second.block);
+      foundTransactions.emplace_back(toBinaryArray(block.baseTransaction));
+    } else if (transactionIndex - 1 < blockIt->second.transactions.size()) {
+      foundTransactions.emplace_back(blockIt->second.transactions[transactionIndex - 1]);
+    } else {
+      // pruned blocks keep their base transactions only
+      missedTransactions.push_back(hash);
+    }
+  }
+}
+
+BlockchainReadResult BlockchainReadSnapshot::read(BlockchainReadBatch& batch) const {
+  auto error = snapshot->read(batch);
+  if (error) {
+    throw std::system_error(error);
+  }
+
+  return batch.extractResult();
+}
+
+}
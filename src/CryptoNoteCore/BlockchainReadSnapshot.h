@@ -0,0 +1,52 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "IDataBase.h"
+
+namespace CryptoNote {
+
+class BlockchainReadBatch;
+class BlockchainReadResult;
+
+// Main chain transactions stored in the data base as they were at the moment of creation. Unlike blockchain caches
+// it may be read from any thread, so readers don't hold up the dispatcher which keeps adding blocks meanwhile.
+// Transactions of blocks above topBlockIndex are left out.
+class BlockchainReadSnapshot {
+public:
+  BlockchainReadSnapshot(std::unique_ptr<IDataBaseSnapshot>&& snapshot, uint32_t topBlockIndex);
+
+  uint32_t getTopBlockIndex() const;
+  const Crypto::Hash& getTopBlockHash() const;
+
+  void getRawTransactions(const std::vector<Crypto::Hash>& transactions, std::vector<BinaryArray>& foundTransactions,
+                          std::vector<Crypto::Hash>& missedTransactions) const;
+
+private:
+  BlockchainReadResult read(BlockchainReadBatch& batch) const;
+
+  std::unique_ptr<IDataBaseSnapshot> snapshot;
+  uint32_t topBlockIndex;
+  Crypto::Hash topBlockHash;
+};
+
+}
@@ -16,12 +16,14 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
+#include <chrono>
 #include <numeric>
 #include <set>
 #include <unordered_set>
 
 #include "Core.h"
 #include "Common/ShuffleGenerator.h"
+#include "Common/int-util.h"
 #include "Common/Math.h"
 #include "Common/MemoryInputStream.h"
 #include "CryptoNoteTools.h"
@@ -55,37 +57,30 @@ std::vector<T> preallocateVector(size_t elements) {
   return vect;
 }
 UseGenesis addGenesisBlock = UseGenesis(true);
+UseGenesis skipGenesisBlock = UseGenesis(false);
 
-class TransactionSpentInputsChecker {
-public:
-  bool haveSpentInputs(const Transaction& transaction) {
-    for (const auto& input : transaction.inputs) {
-      if (input.type() == typeid(KeyInput)) {
-        auto inserted = alreadSpentKeyImages.insert(boost::get<KeyInput>(input).keyImage);
-        if (!inserted.second) {
-          return true;
-        }
-      }
-    }
+// fee / size > otherFee / otherSize, compared the same way the pool orders transactions
+bool paysMorePerByte(uint64_t fee, size_t size, uint64_t otherFee, size_t otherSize) {
+  uint64_t hi, lo = mul128(fee, otherSize, &hi);
+  uint64_t otherHi, otherLo = mul128(otherFee, size, &otherHi);
+  return hi > otherHi || (hi == otherHi && lo > otherLo);
+}
 
-    return false;
+// Marks key images of the transaction as spent unless one of them is already spent
+bool haveSpentInputs(const Transaction& transaction, std::unordered_set<Crypto::KeyImage>& spentKeyImages) {
+  for (const auto& input : transaction.inputs) {
+    if (input.type() == typeid(KeyInput) && spentKeyImages.count(boost::get<KeyInput>(input).keyImage) != 0) {
+      return true;
+    }
   }
 
-private:
-  std::unordered_set<Crypto::KeyImage> alreadSpentKeyImages;
-};
-
-inline IBlockchainCache* findIndexInChain(IBlockchainCache* blockSegment, const Crypto::Hash& blockHash) {
-  assert(blockSegment != nullptr);
-  while (blockSegment != nullptr) {
-    if (blockSegment->hasBlock(blockHash)) {
-      return blockSegment;
+  for (const auto& input : transaction.inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      spentKeyImages.insert(boost::get<KeyInput>(input).keyImage);
     }
-
-    blockSegment = blockSegment->getParent();
   }
 
-  return nullptr;
+  return false;
 }
 
 inline IBlockchainCache* findIndexInChain(IBlockchainCache* blockSegment, uint32_t blockIndex) {
@@ -117,6 +112,14 @@ BlockTemplate extractBlockTemplate(const RawBlock& block) {
   return blockTemplate;
 }
 
+std::vector<Crypto::Hash> getBlockTransactionHashes(const BlockTemplate& block) {
+  std::vector<Crypto::Hash> hashes;
+  hashes.reserve(block.transactionHashes.size() + 1);
+  hashes.push_back(getObjectHash(block.baseTransaction));
+  hashes.insert(hashes.end(), block.transactionHashes.begin(), block.transactionHashes.end());
+  return hashes;
+}
+
 Crypto::Hash getBlockHash(const RawBlock& block) {
   BlockTemplate blockTemplate = extractBlockTemplate(block);
   return CachedBlock(blockTemplate).getBlockHash();
@@ -149,6 +152,14 @@ TransactionValidatorState extractSpentOutputs(const std::vector<CachedTransactio
   return resultOutputs;
 }
 
+void appendKeyInputs(const CachedTransaction& transaction, std::vector<const KeyInput*>& keyInputs) {
+  for (const auto& input : transaction.getTransaction().inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      keyInputs.push_back(&boost::get<KeyInput>(input));
+    }
+  }
+}
+
 int64_t getEmissionChange(const Currency& currency, IBlockchainCache& segment, uint32_t previousBlockIndex,
                           const CachedBlock& cachedBlock, uint64_t cumulativeSize, uint64_t cumulativeFee) {
 
@@ -169,9 +180,10 @@ uint32_t findCommonRoot(IMainChainStorage& storage, IBlockchainCache& rootSegmen
   assert(storage.getBlockCount());
   assert(rootSegment.getBlockCount());
   assert(rootSegment.getStartBlockIndex() == 0);
-  assert(getBlockHash(storage.getBlockByIndex(0)) == rootSegment.getBlockHash(0));
+  assert(storage.getPrunedBlockCount() > 0 || getBlockHash(storage.getBlockByIndex(0)) == rootSegment.getBlockHash(0));
 
-  uint32_t left = 0;
+  // pruned blocks are too deep to differ
+  uint32_t left = storage.getPrunedBlockCount() > 0 ? storage.getPrunedBlockCount() - 1 : 0;
   uint32_t right = std::min(storage.getBlockCount() - 1, rootSegment.getBlockCount() - 1);
   while (left != right) {
     assert(right >= left);
@@ -186,18 +198,31 @@ uint32_t findCommonRoot(IMainChainStorage& storage, IBlockchainCache& rootSegmen
   return left;
 }
 
+// pruning rewrites the blockchain storage file, so it is done once this many blocks can be dropped
+const uint32_t PRUNE_STEP = 1000;
+
 const std::chrono::seconds OUTDATED_TRANSACTION_POLLING_INTERVAL = std::chrono::seconds(60);
+const size_t VERIFIED_TRANSACTIONS_CACHE_SIZE = 10000;
+const size_t POOL_REVALIDATION_BATCH_SIZE = 1000;
 
 }
 
 Core::Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& checkpoints, System::Dispatcher& dispatcher,
-           std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage)
-    : currency(currency), dispatcher(dispatcher), contextGroup(dispatcher), logger(logger, "Core"), checkpoints(std::move(checkpoints)),
+           std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage,
+           const CoreConfig& config)
+    : currency(currency), config(config), dispatcher(dispatcher), contextGroup(dispatcher), logger(logger, "Core"), checkpoints(std::move(checkpoints)),
       upgradeManager(new UpgradeManager()), blockchainCacheFactory(std::move(blockchainCacheFactory)),
-      mainChainStorage(std::move(mainchainStorage)), initialized(false) {
+      mainChainStorage(std::move(mainchainStorage)), initialized(false), lastBlocksSizes(currency.rewardBlocksWindow()),
+      lastBlocksTimestamps(currency.timestampCheckWindow()), windowsTopBlockHash(NULL_HASH), windowsTopBlockIndex(0),
+      blockTemplateTransactions{NULL_HASH, 0, 0, {}, {}, 0, 0, 0, 0},
+      verifiedTransactions(VERIFIED_TRANSACTIONS_CACHE_SIZE),
+      verifiedTransactionCacheHits(0), verifiedTransactionCacheMisses(0), admissionStatistics{0, 0, 0, 0, 0, 0, 0} {
+
+  auto concurrency = std::thread::hardware_concurrency();
+  workerPool.reset(new Common::WorkerPool(concurrency > 1 ? concurrency - 1 : 0));
 
   transactionPool = std::unique_ptr<ITransactionPoolCleanWrapper>(new TransactionPoolCleanWrapper(
-    std::unique_ptr<ITransactionPool>(new TransactionPool(logger)),
+    std::unique_ptr<ITransactionPool>(new TransactionPool(logger, config.getPoolMaxSize())),
     std::unique_ptr<ITimeProvider>(new RealTimeProvider()),
     logger,
     currency.mempoolTxLiveTime()));
@@ -268,6 +293,12 @@ uint64_t Core::getBlockTimestampByIndex(uint32_t blockIndex) const {
   return timestamps[0];
 }
 
+uint32_t Core::getPrunedBlockCount() const {
+  assert(!chainsLeaves.empty());
+
+  return chainsLeaves[0]->getPrunedBlockCount();
+}
+
 bool Core::hasBlock(const Crypto::Hash& blockHash) const {
   throwIfNotInitialized();
   return findSegmentContainingBlock(blockHash) != nullptr;
@@ -352,6 +383,10 @@ void Core::getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<R
     } else {
       uint32_t blockIndex = blockchainSegment->getBlockIndex(hash);
       assert(blockIndex <= blockchainSegment->getTopBlockIndex());
+      if (blockIndex < blockchainSegment->getPrunedBlockCount()) {
+        missedHashes.push_back(hash);
+        continue;
+      }
 
       blocks.push_back(blockchainSegment->getBlockByIndex(blockIndex));
     }
@@ -363,12 +398,12 @@ void Core::copyTransactionsToPool(IBlockchainCache* alt) {
   while (alt != nullptr) {
     if (mainChainSet.count(alt) != 0)
       break;
-    auto transactions = alt->getRawTransactions(alt->getTransactionHashes());
-    for (auto& transaction : transactions) {
-      if (addTransactionToPool(std::move(transaction))) {
-        // TODO: send notification
-      }
+    auto hashes = alt->getTransactionHashes();
+    for (size_t start = 0; start < hashes.size(); start += POOL_REVALIDATION_BATCH_SIZE) {
+      auto end = hashes.begin() + std::min(hashes.size(), start + POOL_REVALIDATION_BATCH_SIZE);
+      addTransactionsToPool(alt->getRawTransactions({hashes.begin() + start, end}), nullptr);
     }
+
     alt = alt->getParent();
   }
 }
@@ -445,38 +480,37 @@ void Core::getTransactions(const std::vector<Crypto::Hash>& transactionHashes, s
   assert(!chainsStorage.empty());
   throwIfNotInitialized();
 
-  IBlockchainCache* segment = chainsLeaves[0];
-  assert(segment != nullptr);
-
-  std::vector<Crypto::Hash> leftTransactions = transactionHashes;
+  std::unordered_map<IBlockchainCache*, std::vector<Crypto::Hash>> segmentTransactions;
+  std::vector<Crypto::Hash> rootTransactions;
 
   // find in main chain
-  do {
-    std::vector<Crypto::Hash> missedTransactions;
-    segment->getRawTransactions(leftTransactions, transactions, missedTransactions);
-
-    leftTransactions = std::move(missedTransactions);
-    segment = segment->getParent();
-  } while (segment != nullptr && !leftTransactions.empty());
+  for (const auto& transactionHash : transactionHashes) {
+    IBlockchainCache* segment = findIndexedSegmentContainingTransaction(transactionHash, true);
+    if (segment != nullptr) {
+      segmentTransactions[segment].push_back(transactionHash);
+    } else {
+      rootTransactions.push_back(transactionHash);
+    }
+  }
 
-  if (leftTransactions.empty()) {
-    return;
+  std::vector<Crypto::Hash> leftTransactions;
+  if (!rootTransactions.empty()) {
+    getRootSegment()->getRawTransactions(rootTransactions, transactions, leftTransactions);
   }
 
   // find in alternative chains
-  for (size_t chain = 1; chain < chainsLeaves.size(); ++chain) {
-    segment = chainsLeaves[chain];
-
-    while (mainChainSet.count(segment) == 0 && !leftTransactions.empty()) {
-      std::vector<Crypto::Hash> missedTransactions;
-      segment->getRawTransactions(leftTransactions, transactions, missedTransactions);
-
-      leftTransactions = std::move(missedTransactions);
-      segment = segment->getParent();
+  for (const auto& transactionHash : leftTransactions) {
+    IBlockchainCache* segment = findIndexedSegmentContainingTransaction(transactionHash, false);
+    if (segment != nullptr) {
+      segmentTransactions[segment].push_back(transactionHash);
+    } else {
+      missedHashes.push_back(transactionHash);
     }
   }
 
-  missedHashes.insert(missedHashes.end(), leftTransactions.begin(), leftTransactions.end());
+  for (const auto& segmentAndHashes : segmentTransactions) {
+    segmentAndHashes.first->getRawTransactions(segmentAndHashes.second, transactions, missedHashes);
+  }
 }
 
 Difficulty Core::getBlockDifficulty(uint32_t blockIndex) const {
@@ -491,19 +525,9 @@ Difficulty Core::getBlockDifficulty(uint32_t blockIndex) const {
   return difficulties[0];
 }
 
-// TODO: just use mainChain->getDifficultyForNextBlock() ?
 Difficulty Core::getDifficultyForNextBlock() const {
   throwIfNotInitialized();
-  IBlockchainCache* mainChain = chainsLeaves[0];
-
-  uint32_t topBlockIndex = mainChain->getTopBlockIndex();
-
-  size_t blocksCount = std::min(static_cast<size_t>(topBlockIndex), currency.difficultyBlocksCount());
-
-  auto timestamps = mainChain->getLastTimestamps(blocksCount);
-  auto difficulties = mainChain->getLastCumulativeDifficulties(blocksCount);
-
-  return currency.nextDifficulty(timestamps, difficulties);
+  return chainsLeaves[0]->getDifficultyForNextBlock();
 }
 
 std::vector<Crypto::Hash> Core::findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds,
@@ -552,6 +576,10 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   TransactionValidatorState validatorState;
 
   auto previousBlockIndex = cache->getBlockIndex(previousBlockHash);
+  if (previousBlockIndex + 1 < cache->getPrunedBlockCount()) {
+    logger(Logging::WARNING) << "Block " << cachedBlock.getBlockHash() << " rejected as orphaned: its parent " << previousBlockIndex << " is pruned";
+    return error::AddBlockErrorCode::REJECTED_AS_ORPHANED;
+  }
 
   bool addOnTop = cache->getTopBlockIndex() == previousBlockIndex;
   auto maxBlockCumulativeSize = currency.maxBlockCumulativeSize(previousBlockIndex + 1);
@@ -573,23 +601,38 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
     return error::BlockValidationError::DIFFICULTY_OVERHEAD;
   }
 
+  // inputs of all block transactions are read from storage at once
+  if (!checkpoints.isInCheckpointZone(previousBlockIndex + 1)) {
+    std::vector<const KeyInput*> keyInputs;
+    for (const auto& transaction : transactions) {
+      appendKeyInputs(transaction, keyInputs);
+    }
+
+    cache->prefetchKeyInputs(keyInputs);
+  }
+
   uint64_t cumulativeFee = 0;
+  std::vector<RingSignatureCheck> signatureChecks;
   for (const auto& transaction : transactions) {
     uint64_t fee = 0;
-    auto transactionValidationResult = validateTransaction(transaction, validatorState, cache, fee, previousBlockIndex);
+    size_t firstCheck = signatureChecks.size();
+    auto transactionValidationResult = validateTransactionInputs(transaction, validatorState, cache, fee, previousBlockIndex, signatureChecks);
     if (transactionValidationResult) {
       logger(Logging::DEBUGGING) << "Failed to validate transaction " << transaction.getTransactionHash() << ": " << transactionValidationResult.message();
       return transactionValidationResult;
     }
 
+    if (isTransactionVerified(transaction, signatureChecks, firstCheck)) {
+      signatureChecks.erase(signatureChecks.begin() + firstCheck, signatureChecks.end());
+    }
+
     cumulativeFee += fee;
   }
 
   uint64_t reward = 0;
   int64_t emissionChange = 0;
   auto alreadyGeneratedCoins = cache->getAlreadyGeneratedCoins(previousBlockIndex);
-  auto lastBlocksSizes = cache->getLastBlocksSizes(currency.rewardBlocksWindow(), previousBlockIndex, addGenesisBlock);
-  auto blocksSizeMedian = Common::medianValue(lastBlocksSizes);
+  auto blocksSizeMedian = getLastBlocksSizesMedian(cache, previousBlockIndex, addGenesisBlock);
 
   if (!currency.getBlockReward(previousBlockIndex + 1, blocksSizeMedian,
                                cumulativeBlockSize, alreadyGeneratedCoins, cumulativeFee, reward, emissionChange)) {
@@ -617,6 +660,12 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
     return error::BlockValidationError::PROOF_OF_WORK_TOO_WEAK;
   }
 
+  // ring signatures are the most expensive part of validation, so they are checked last and in parallel
+  if (!checkRingSignatures(signatureChecks)) {
+    logger(Logging::DEBUGGING) << "Block " << cachedBlock.getBlockHash() << " contains transaction with invalid ring signature";
+    return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+  }
+
   auto ret = error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE;
 
   if (addOnTop) {
@@ -629,9 +678,11 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
         mainChainStorage->pushBlock(rawBlock);
 
         cache->pushBlock(cachedBlock, transactions, validatorState, cumulativeBlockSize, emissionChange, currentDifficulty, std::move(rawBlock));
+        indexBlock(cache, cachedBlock);
 
         updateBlockMedianSize();
         actualizePoolTransactionsLite(validatorState);
+        pruneMainChain();
 
         ret = error::AddBlockErrorCode::ADDED_TO_MAIN;
         logger(Logging::DEBUGGING) << "Block " << cachedBlock.getBlockHash() << " added to main chain. Index: " << (previousBlockIndex + 1);
@@ -642,6 +693,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
         notifyObservers(makeDelTransactionMessage(std::move(hashes), Messages::DeleteTransaction::Reason::InBlock));
       } else {
         cache->pushBlock(cachedBlock, transactions, validatorState, cumulativeBlockSize, emissionChange, currentDifficulty, std::move(rawBlock));
+        indexBlock(cache, cachedBlock);
         logger(Logging::WARNING) << "Block " << cachedBlock.getBlockHash() << " added to alternative chain. Index: " << (previousBlockIndex + 1);
 
         auto mainChainCache = chainsLeaves[0];
@@ -650,6 +702,8 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
               std::distance(chainsLeaves.begin(), std::find(chainsLeaves.begin(), chainsLeaves.end(), cache));
           assert(endpointIndex != chainsStorage.size());
           assert(endpointIndex != 0);
+
+          // verified transactions stay cached, their ring members are compared with the new main chain on every lookup
           std::swap(chainsLeaves[0], chainsLeaves[endpointIndex]);
           updateMainChainSet();
           updateBlockMedianSize();
@@ -677,6 +731,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
       newlyForkedChainPtr->pushBlock(cachedBlock, transactions, validatorState, cumulativeBlockSize, emissionChange,
                                      currentDifficulty, std::move(rawBlock));
+      indexBlock(newlyForkedChainPtr, cachedBlock);
 
       updateMainChainSet();
       updateBlockMedianSize();
@@ -687,6 +742,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
     auto upperSegment = cache->split(previousBlockIndex + 1);
     //[cache] is lower segment now
+    indexSegment(upperSegment.get(), cache);
 
     assert(upperSegment->getBlockCount() > 0);
     assert(cache->getBlockCount() > 0);
@@ -711,6 +767,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
     newlyForkedChainPtr->pushBlock(cachedBlock, transactions, validatorState, cumulativeBlockSize, emissionChange,
       currentDifficulty, std::move(rawBlock));
+    indexBlock(newlyForkedChainPtr, cachedBlock);
 
     updateMainChainSet();
   }
@@ -721,18 +778,43 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   return ret;
 }
 
+// Pool transactions are checked in place against the new main chain, a reorg may spend their key images, drop or lock
+// their ring members. Ring signatures don't depend on the chain, so the verified transactions cache spares them unless
+// ring members changed, and the rest are verified in parallel.
 void Core::actualizePoolTransactions() {
   auto& pool = *transactionPool;
   auto hashes = pool.getTransactionHashes();
 
-  for (auto& hash : hashes) {
-    auto tx = pool.getTransaction(hash);
-    pool.removeTransaction(hash);
+  std::vector<Crypto::Hash> deletedTransactions;
+  for (size_t start = 0; start < hashes.size(); start += POOL_REVALIDATION_BATCH_SIZE) {
+    size_t count = std::min(hashes.size() - start, POOL_REVALIDATION_BATCH_SIZE);
+    std::vector<const CachedTransaction*> transactions;
+    transactions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      transactions.push_back(&pool.getTransaction(hashes[start + i]));
+    }
 
-    if (!addTransactionToPool(std::move(tx))) {
-      notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
+    std::vector<TransactionValidatorState> validatorStates(count);
+    std::vector<std::vector<RingSignatureCheck>> signatureChecks(count);
+    std::vector<size_t> unverifiedTransactions;
+    auto valid = checkPoolTransactionInputs(transactions, validatorStates, signatureChecks, unverifiedTransactions);
+    checkPoolTransactionSignatures(transactions, signatureChecks, unverifiedTransactions, valid);
+
+    for (size_t i = 0; i < count; ++i) {
+      if (!valid[i]) {
+        deletedTransactions.push_back(hashes[start + i]);
+      }
     }
   }
+
+  for (const auto& hash : deletedTransactions) {
+    pool.removeTransaction(hash);
+  }
+
+  logger(Logging::DEBUGGING) << deletedTransactions.size() << " of " << hashes.size() << " pool transactions are not actual after chain switch";
+  if (!deletedTransactions.empty()) {
+    notifyObservers(makeDelTransactionMessage(std::move(deletedTransactions), Messages::DeleteTransaction::Reason::NotActual));
+  }
 }
 
 void Core::actualizePoolTransactionsLite(const TransactionValidatorState& validatorState) {
@@ -908,6 +990,183 @@ bool Core::addTransactionToPool(const BinaryArray& transactionBinaryArray) {
   return true;
 }
 
+std::vector<bool> Core::addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) {
+  throwIfNotInitialized();
+
+  return addTransactionsToPool(transactionBinaryArrays, &admissionStatistics);
+}
+
+// Relayed transactions come in bursts, so the independent work is spread over the worker pool: parsing with hashing first,
+// then ring signatures. Inputs are looked up in between on this thread, since the chain may only be read here, and the
+// transactions are pushed in arrival order, so the pool resolves key image conflicts as if they were added one by one.
+// Transactions taken back from abandoned chains are added without statistics, so they don't skew the relayed ones
+std::vector<bool> Core::addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays,
+                                              TransactionAdmissionStatistics* statistics) {
+  auto startTime = std::chrono::steady_clock::now();
+  std::vector<boost::optional<CachedTransaction>> transactions(transactionBinaryArrays.size());
+  workerPool->run(transactions.size(), [&transactionBinaryArrays, &transactions] (size_t i) {
+    Transaction transaction;
+    if (fromBinaryArray<Transaction>(transaction, transactionBinaryArrays[i])) {
+      // CachedTransaction computes hashes lazily, the other stages only read them
+      transactions[i] = CachedTransaction(std::move(transaction));
+      transactions[i]->getTransactionHash();
+      transactions[i]->getTransactionPrefixHash();
+    }
+
+    return true;
+  });
+
+  auto parsedTime = std::chrono::steady_clock::now();
+  std::vector<const CachedTransaction*> candidates(transactions.size(), nullptr);
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (!transactions[i]) {
+      logger(Logging::WARNING) << "Couldn't add transaction to pool due to deserialization error";
+    } else if (transactionPool->checkIfTransactionPresent(transactions[i]->getTransactionHash())) {
+      logger(Logging::DEBUGGING) << "Transaction " << transactions[i]->getTransactionHash() << " is already in pool";
+    } else {
+      candidates[i] = &*transactions[i];
+    }
+  }
+
+  std::vector<TransactionValidatorState> validatorStates(transactions.size());
+  std::vector<std::vector<RingSignatureCheck>> signatureChecks(transactions.size());
+  std::vector<size_t> unverifiedTransactions;
+  auto valid = checkPoolTransactionInputs(candidates, validatorStates, signatureChecks, unverifiedTransactions);
+
+  auto inputsTime = std::chrono::steady_clock::now();
+  checkPoolTransactionSignatures(candidates, signatureChecks, unverifiedTransactions, valid);
+
+  auto signaturesTime = std::chrono::steady_clock::now();
+  std::vector<bool> added(transactions.size(), false);
+  std::vector<Crypto::Hash> transactionHashes(transactions.size());
+  std::vector<Crypto::Hash> evictedTransactions;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (valid[i]) {
+      transactionHashes[i] = transactions[i]->getTransactionHash();
+      added[i] = pushTransactionToPool(std::move(*transactions[i]), std::move(validatorStates[i]), evictedTransactions);
+    }
+  }
+
+  // a transaction evicted by a later one of the same batch is reported as not added, it has never been announced
+  std::unordered_multiset<Crypto::Hash> evictedHashes(evictedTransactions.begin(), evictedTransactions.end());
+  std::vector<Crypto::Hash> addedHashes;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (added[i]) {
+      auto it = evictedHashes.find(transactionHashes[i]);
+      if (it != evictedHashes.end()) {
+        evictedHashes.erase(it);
+        added[i] = false;
+      } else {
+        addedHashes.push_back(transactionHashes[i]);
+      }
+    }
+  }
+
+  evictedTransactions.erase(std::remove_if(evictedTransactions.begin(), evictedTransactions.end(),
+    [&evictedHashes] (const Crypto::Hash& hash) { return evictedHashes.count(hash) == 0; }), evictedTransactions.end());
+
+  auto insertionTime = std::chrono::steady_clock::now();
+  auto microseconds = [] (std::chrono::steady_clock::duration duration) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  };
+
+  if (statistics != nullptr) {
+    ++statistics->batchCount;
+    statistics->transactionCount += transactions.size();
+    statistics->maxBatchSize = std::max<uint64_t>(statistics->maxBatchSize, transactions.size());
+    statistics->parseTime += microseconds(parsedTime - startTime);
+    statistics->inputsTime += microseconds(inputsTime - parsedTime);
+    statistics->signaturesTime += microseconds(signaturesTime - inputsTime);
+    statistics->insertionTime += microseconds(insertionTime - signaturesTime);
+  }
+
+  logger(Logging::DEBUGGING) << addedHashes.size() << " of " << transactions.size() << " transactions added to pool in "
+    << microseconds(insertionTime - startTime) << " us, parsing " << microseconds(parsedTime - startTime) << " us, inputs "
+    << microseconds(inputsTime - parsedTime) << " us, signatures " << microseconds(signaturesTime - inputsTime) << " us";
+
+  if (!evictedTransactions.empty()) {
+    notifyObservers(makeDelTransactionMessage(std::move(evictedTransactions), Messages::DeleteTransaction::Reason::Evicted));
+  }
+
+  if (!addedHashes.empty()) {
+    notifyObservers(makeAddTransactionMessage(std::move(addedHashes)));
+  }
+
+  return added;
+}
+
+// Checks inputs, size and fee of the transactions against the main chain, null transactions are skipped.
+// Transactions which ring signatures aren't in the verified transactions cache are appended to unverifiedTransactions.
+std::vector<char> Core::checkPoolTransactionInputs(const std::vector<const CachedTransaction*>& transactions,
+                                                   std::vector<TransactionValidatorState>& validatorStates,
+                                                   std::vector<std::vector<RingSignatureCheck>>& signatureChecks,
+                                                   std::vector<size_t>& unverifiedTransactions) {
+  IBlockchainCache* cache = chainsLeaves[0];
+  uint32_t blockIndex = getTopBlockIndex();
+  if (!checkpoints.isInCheckpointZone(blockIndex + 1)) {
+    std::vector<const KeyInput*> keyInputs;
+    for (const auto transaction : transactions) {
+      if (transaction != nullptr) {
+        appendKeyInputs(*transaction, keyInputs);
+      }
+    }
+
+    cache->prefetchKeyInputs(keyInputs);
+  }
+
+  std::vector<char> valid(transactions.size(), 0);
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (transactions[i] == nullptr) {
+      continue;
+    }
+
+    const CachedTransaction& transaction = *transactions[i];
+    uint64_t fee = 0;
+    if (auto validationResult = validateTransactionInputs(transaction, validatorStates[i], cache, fee, blockIndex, signatureChecks[i])) {
+      logger(Logging::WARNING) << "Transaction " << transaction.getTransactionHash() << " is not valid. Reason: " << validationResult.message();
+      continue;
+    }
+
+    if (!checkTransactionSizeAndFee(transaction, fee)) {
+      continue;
+    }
+
+    if (!isTransactionVerified(transaction, signatureChecks[i], 0)) {
+      unverifiedTransactions.push_back(i);
+    }
+
+    valid[i] = 1;
+  }
+
+  return valid;
+}
+
+// Verifies ring signatures of the unverified transactions on the worker pool, one job per transaction
+void Core::checkPoolTransactionSignatures(const std::vector<const CachedTransaction*>& transactions,
+                                          const std::vector<std::vector<RingSignatureCheck>>& signatureChecks,
+                                          const std::vector<size_t>& unverifiedTransactions, std::vector<char>& valid) {
+  if (unverifiedTransactions.size() == 1) {
+    // a single transaction is still split by inputs
+    size_t i = unverifiedTransactions.front();
+    valid[i] = checkRingSignatures(signatureChecks[i]);
+  } else {
+    workerPool->run(unverifiedTransactions.size(), [&unverifiedTransactions, &signatureChecks, &valid] (size_t job) {
+      size_t i = unverifiedTransactions[job];
+      valid[i] = checkRingSignatureRange(signatureChecks[i], 0, signatureChecks[i].size());
+      return true;
+    });
+  }
+
+  for (size_t i : unverifiedTransactions) {
+    if (valid[i]) {
+      addVerifiedTransaction(*transactions[i], signatureChecks[i], 0);
+    } else {
+      logger(Logging::WARNING) << "Transaction " << transactions[i]->getTransactionHash() << " is not valid. Reason: "
+        << make_error_code(error::TransactionValidationError::INPUT_INVALID_SIGNATURES).message();
+    }
+  }
+}
+
 bool Core::addTransactionToPool(CachedTransaction&& cachedTransaction) {
   TransactionValidatorState validatorState;
 
@@ -915,12 +1174,44 @@ bool Core::addTransactionToPool(CachedTransaction&& cachedTransaction) {
     return false;
   }
 
+  std::vector<Crypto::Hash> evictedTransactions;
+  if (!pushTransactionToPool(std::move(cachedTransaction), std::move(validatorState), evictedTransactions)) {
+    return false;
+  }
+
+  if (!evictedTransactions.empty()) {
+    notifyObservers(makeDelTransactionMessage(std::move(evictedTransactions), Messages::DeleteTransaction::Reason::Evicted));
+  }
+
+  return true;
+}
+
+// Hashes of the transactions evicted to make room are appended to evictedTransactions, the caller notifies about them
+bool Core::pushTransactionToPool(CachedTransaction&& cachedTransaction, TransactionValidatorState&& validatorState,
+                                 std::vector<Crypto::Hash>& evictedTransactions) {
   auto transactionHash = cachedTransaction.getTransactionHash();
-  if (!transactionPool->pushTransaction(std::move(cachedTransaction), std::move(validatorState))) {
-    logger(Logging::DEBUGGING) << "Failed to push transaction " << transactionHash << " to pool, already exists";
+  size_t evictedCount = evictedTransactions.size();
+  if (!transactionPool->pushTransaction(std::move(cachedTransaction), std::move(validatorState), evictedTransactions)) {
+    logger(Logging::DEBUGGING) << "Failed to push transaction " << transactionHash << " to pool, already exists or pool is full";
     return false;
   }
 
+  if (evictedTransactions.size() > evictedCount) {
+    logger(Logging::DEBUGGING) << evictedTransactions.size() - evictedCount << " transactions evicted from pool by transaction "
+      << transactionHash;
+  }
+
+  auto& templateTransactions = blockTemplateTransactions;
+  if (templateTransactions.topBlockHash == chainsLeaves[0]->getTopBlockHash()) {
+    const CachedTransaction& transaction = transactionPool->getTransaction(transactionHash);
+    if (!addToBlockTemplate(templateTransactions, transaction) && templateTransactions.cheapestTransactionSize != 0 &&
+        paysMorePerByte(transaction.getTransactionFee(), transaction.getTransactionBinaryArray().size(),
+          templateTransactions.cheapestTransactionFee, templateTransactions.cheapestTransactionSize)) {
+      // the transaction would take place of cheaper ones, so they are chosen from the whole pool again
+      templateTransactions.topBlockHash = NULL_HASH;
+    }
+  }
+
   logger(Logging::DEBUGGING) << "Transaction " << transactionHash << " has been added to pool";
   return true;
 }
@@ -934,6 +1225,10 @@ bool Core::isTransactionValidForPool(const CachedTransaction& cachedTransaction,
     return false;
   }
 
+  return checkTransactionSizeAndFee(cachedTransaction, fee);
+}
+
+bool Core::checkTransactionSizeAndFee(const CachedTransaction& cachedTransaction, uint64_t fee) const {
   auto maxTransactionSize = getMaximumTransactionAllowedSize(blockMedianSize, currency);
   if (cachedTransaction.getTransactionBinaryArray().size() > maxTransactionSize) {
     logger(Logging::WARNING) << "Transaction " << cachedTransaction.getTransactionHash()
@@ -984,11 +1279,29 @@ bool Core::getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vect
 
   addedTransactions.reserve(newTransactions.size());
   for (const auto& hash : newTransactions) {
-    TransactionPrefixInfo transactionPrefixInfo;
-    transactionPrefixInfo.txHash = hash;
-    transactionPrefixInfo.txPrefix =
-        static_cast<const TransactionPrefix&>(transactionPool->getTransaction(hash).getTransaction());
-    addedTransactions.emplace_back(std::move(transactionPrefixInfo));
+    addedTransactions.emplace_back(getPoolTransactionPrefixInfo(hash));
+  }
+
+  return getTopBlockHash() == lastBlockHash;
+}
+
+bool Core::getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t& sequence,
+                               std::vector<TransactionPrefixInfo>& addedTransactions,
+                               std::vector<Crypto::Hash>& deletedTransactions, bool& fullResync) const {
+  throwIfNotInitialized();
+
+  std::vector<Crypto::Hash> newTransactions;
+  fullResync = !transactionPool->getChangesSince(sequence, newTransactions, deletedTransactions);
+  if (fullResync) {
+    newTransactions = transactionPool->getTransactionHashes();
+    deletedTransactions.clear();
+  }
+
+  sequence = transactionPool->getChangeSequence();
+
+  addedTransactions.reserve(newTransactions.size());
+  for (const auto& hash : newTransactions) {
+    addedTransactions.emplace_back(getPoolTransactionPrefixInfo(hash));
   }
 
   return getTopBlockHash() == lastBlockHash;
@@ -1017,9 +1330,10 @@ bool Core::getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, c
   assert(!chainsLeaves.empty());
   uint64_t alreadyGeneratedCoins = chainsLeaves[0]->getAlreadyGeneratedCoins();
 
-  size_t transactionsSize;
-  uint64_t fee;
-  fillBlockTemplate(b, medianSize, currency.maxBlockCumulativeSize(height), transactionsSize, fee);
+  const auto& transactions = getBlockTemplateTransactions(medianSize, currency.maxBlockCumulativeSize(height));
+  b.transactionHashes = transactions.transactionHashes;
+  size_t transactionsSize = transactions.transactionsSize;
+  uint64_t fee = transactions.fee;
 
   /*
      two-phase miner transaction generation: we don't know exact block size until we prepare block, but we don't know
@@ -1095,10 +1409,23 @@ bool Core::getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, c
 }
 
 CoreStatistics Core::getCoreStatistics() const {
-  // TODO: implement it
-  assert(false);
+  throwIfNotInitialized();
+
   CoreStatistics result;
-  std::fill(reinterpret_cast<uint8_t*>(&result), reinterpret_cast<uint8_t*>(&result) + sizeof(result), 0);
+  result.transactionPoolSize = transactionPool->getTransactionCount();
+  result.blockchainHeight = getTopBlockIndex() + 1;
+  result.miningSpeed = 0;
+  result.alternativeBlockCount = getAlternativeBlockCount();
+  result.topBlockHashString = Common::podToHex(getTopBlockHash());
+  result.verifiedTransactionCacheHits = verifiedTransactionCacheHits;
+  result.verifiedTransactionCacheMisses = verifiedTransactionCacheMisses;
+  result.admittedTransactionBatches = admissionStatistics.batchCount;
+  result.admittedTransactions = admissionStatistics.transactionCount;
+  result.maxAdmissionBatchSize = admissionStatistics.maxBatchSize;
+  result.admissionParseTime = admissionStatistics.parseTime;
+  result.admissionInputsTime = admissionStatistics.inputsTime;
+  result.admissionSignaturesTime = admissionStatistics.signaturesTime;
+  result.admissionInsertionTime = admissionStatistics.insertionTime;
   return result;
 }
 
@@ -1177,7 +1504,26 @@ bool Core::extractTransactions(const std::vector<BinaryArray>& rawTransactions,
 
 std::error_code Core::validateTransaction(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
                                           IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex) {
-  // TransactionValidatorState currentState;
+  std::vector<RingSignatureCheck> signatureChecks;
+  auto error = validateTransactionInputs(cachedTransaction, state, cache, fee, blockIndex, signatureChecks);
+  if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
+    return error;
+  }
+
+  if (!isTransactionVerified(cachedTransaction, signatureChecks, 0)) {
+    if (!checkRingSignatures(signatureChecks)) {
+      return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+    }
+
+    addVerifiedTransaction(cachedTransaction, signatureChecks, 0);
+  }
+
+  return error::TransactionValidationError::VALIDATION_SUCCESS;
+}
+
+std::error_code Core::validateTransactionInputs(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
+                                                IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex,
+                                                std::vector<RingSignatureCheck>& signatureChecks) {
   const auto& transaction = cachedTransaction.getTransaction();
   auto error = validateSemantic(transaction, fee);
   if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
@@ -1215,14 +1561,9 @@ std::error_code Core::validateTransaction(const CachedTransaction& cachedTransac
           return error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
         }
 
-        std::vector<const Crypto::PublicKey*> outputKeyPointers;
-        outputKeyPointers.reserve(outputKeys.size());
-        std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers] (const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
-        if (!Crypto::check_ring_signature(cachedTransaction.getTransactionPrefixHash(), in.keyImage, outputKeyPointers.data(),
-                                          outputKeyPointers.size(), transaction.signatures[inputIndex].data(),
-                                          blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX)) {
-          return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
-        }
+        // CachedTransaction computes hashes lazily, so the prefix hash is taken here rather than in the worker threads
+        signatureChecks.push_back({ &transaction, cachedTransaction.getTransactionPrefixHash(), inputIndex, std::move(outputKeys),
+                                    blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX });
       }
     } else {
       assert(false);
@@ -1235,6 +1576,69 @@ std::error_code Core::validateTransaction(const CachedTransaction& cachedTransac
   return error::TransactionValidationError::VALIDATION_SUCCESS;
 }
 
+bool Core::checkRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks) {
+  // Several chunks per thread keep the load balanced, while each chunk still benefits from batch verification.
+  const size_t chunkCount = std::min(signatureChecks.size(), 4 * (workerPool->getThreadCount() + 1));
+  return workerPool->run(chunkCount, [&signatureChecks, chunkCount] (size_t chunkIndex) {
+    return checkRingSignatureRange(signatureChecks, signatureChecks.size() * chunkIndex / chunkCount,
+                                   signatureChecks.size() * (chunkIndex + 1) / chunkCount);
+  });
+}
+
+bool Core::checkRingSignatureRange(const std::vector<RingSignatureCheck>& signatureChecks, size_t begin, size_t end) {
+  std::vector<std::vector<const Crypto::PublicKey*>> outputKeyPointers(end - begin);
+  std::vector<Crypto::RingSignatureEntry> entries;
+  entries.reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    const RingSignatureCheck& check = signatureChecks[i];
+    const KeyInput& in = boost::get<KeyInput>(check.transaction->inputs[check.inputIndex]);
+
+    auto& pointers = outputKeyPointers[i - begin];
+    pointers.reserve(check.outputKeys.size());
+    std::for_each(check.outputKeys.begin(), check.outputKeys.end(), [&pointers] (const Crypto::PublicKey& key) { pointers.push_back(&key); });
+    entries.push_back({ &check.prefixHash, &in.keyImage, pointers.data(), pointers.size(),
+                        check.transaction->signatures[check.inputIndex].data(), check.checkKeyImage });
+  }
+
+  return Crypto::check_ring_signatures(entries.data(), entries.size());
+}
+
+bool Core::isTransactionVerified(const CachedTransaction& transaction, const std::vector<RingSignatureCheck>& signatureChecks, size_t firstCheck) {
+  if (firstCheck == signatureChecks.size()) {
+    return true;
+  }
+
+  // transaction hash covers the prefix and the signatures, so only the ring members have to match
+  const VerifiedTransaction* verified = verifiedTransactions.find(transaction.getTransactionHash());
+  bool result = verified != nullptr && std::all_of(signatureChecks.begin() + firstCheck, signatureChecks.end(), [verified] (const RingSignatureCheck& check) {
+    return (verified->keyImagesChecked || !check.checkKeyImage) && check.inputIndex < verified->outputKeys.size() &&
+           verified->outputKeys[check.inputIndex] == check.outputKeys;
+  });
+
+  if (result) {
+    ++verifiedTransactionCacheHits;
+  } else {
+    ++verifiedTransactionCacheMisses;
+  }
+
+  return result;
+}
+
+void Core::addVerifiedTransaction(const CachedTransaction& transaction, const std::vector<RingSignatureCheck>& signatureChecks, size_t firstCheck) {
+  if (firstCheck == signatureChecks.size()) {
+    return;
+  }
+
+  VerifiedTransaction verified;
+  verified.keyImagesChecked = signatureChecks[firstCheck].checkKeyImage;
+  verified.outputKeys.resize(transaction.getTransaction().inputs.size());
+  for (auto it = signatureChecks.begin() + firstCheck; it != signatureChecks.end(); ++it) {
+    verified.outputKeys[it->inputIndex] = it->outputKeys;
+  }
+
+  verifiedTransactions.add(transaction.getTransactionHash(), std::move(verified));
+}
+
 std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t& fee) {
   if (transaction.inputs.empty()) {
     return error::TransactionValidationError::EMPTY_INPUTS;
@@ -1333,12 +1737,9 @@ std::error_code Core::validateBlock(const CachedBlock& cachedBlock, IBlockchainC
     return error::BlockValidationError::TIMESTAMP_TOO_FAR_IN_FUTURE;
   }
 
-  auto timestamps = cache->getLastTimestamps(currency.timestampCheckWindow(), previousBlockIndex, addGenesisBlock);
-  if (timestamps.size() >= currency.timestampCheckWindow()) {
-    auto median_ts = Common::medianValue(timestamps);
-    if (block.timestamp < median_ts) {
-      return error::BlockValidationError::TIMESTAMP_TOO_FAR_IN_PAST;
-    }
+  uint64_t median_ts;
+  if (getLastTimestampsMedian(cache, previousBlockIndex, median_ts) && block.timestamp < median_ts) {
+    return error::BlockValidationError::TIMESTAMP_TOO_FAR_IN_PAST;
   }
 
   if (block.baseTransaction.inputs.size() != 1) {
@@ -1388,6 +1789,15 @@ const Currency& Core::getCurrency() const {
   return currency;
 }
 
+std::unique_ptr<BlockchainReadSnapshot> Core::createReadSnapshot() const {
+  if (!initialized) {
+    return nullptr;
+  }
+
+  // root segment hides blocks of split off segments it still keeps in data base
+  return blockchainCacheFactory->createReadSnapshot(chainsStorage[0]->getTopBlockIndex());
+}
+
 void Core::save() {
   throwIfNotInitialized();
 
@@ -1406,6 +1816,13 @@ void Core::load() {
 
   assert(storageBlocksCount != 0); //we assume the storage has at least genesis block
 
+  if (mainChainStorage->getPrunedBlockCount() > chainsLeaves[0]->getPrunedBlockCount()) {
+    logger(Logging::ERROR) << "Blockchain storage is pruned up to block index " << mainChainStorage->getPrunedBlockCount()
+                           << ", but DB has transactions of blocks from index " << chainsLeaves[0]->getPrunedBlockCount()
+                           << ". DB can't be rebuilt from a pruned storage, resynchronize your daemon please.";
+    throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+  }
+
   if (storageBlocksCount > dbBlocksCount) {
     logger(Logging::INFO) << "Importing blocks from blockchain storage";
     importBlocksFromStorage();
@@ -1424,6 +1841,10 @@ void Core::load() {
     logger(Logging::DEBUGGING) << "Blockchain storage and root segment are on the same height and chain";
   }
 
+  // the storage could have been left unpruned if the daemon stopped right after DB was pruned
+  mainChainStorage->pruneBlocks(chainsLeaves[0]->getPrunedBlockCount());
+  pruneMainChain();
+
   initialized = true;
 }
 
@@ -1448,44 +1869,77 @@ void Core::importBlocksFromStorage() {
 
   cutSegment(*chainsLeaves[0], commonIndex + 1);
 
-  auto previousBlockHash = getBlockHash(mainChainStorage->getBlockByIndex(commonIndex));
+  auto previousBlockHash = chainsLeaves[0]->getBlockHash(commonIndex);
   auto blockCount = mainChainStorage->getBlockCount();
+
+  size_t threadCount = config.getImportThreadsCount();
+  if (threadCount == 0) {
+    threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  logger(Logging::INFO) << "Importing blocks " << (commonIndex + 1) << " - " << (blockCount - 1) << " using " << threadCount << " threads";
+
+  // Deserialization and hashing run on the pipeline threads, blocks are pushed to the cache strictly in order here.
+  BlockImportPipeline pipeline(*mainChainStorage, commonIndex + 1, blockCount, threadCount,
+                               std::bind(&Core::prepareImportedBlock, this, std::placeholders::_1));
+
+  auto startTime = std::chrono::steady_clock::now();
+  auto reportTime = startTime;
+  uint32_t reportIndex = commonIndex;
   for (uint32_t i = commonIndex + 1; i < blockCount; ++i) {
-    RawBlock rawBlock = mainChainStorage->getBlockByIndex(i);
-    auto blockTemplate = extractBlockTemplate(rawBlock);
-    CachedBlock cachedBlock(blockTemplate);
+    std::unique_ptr<PreparedBlock> block = pipeline.next();
+    const CachedBlock& cachedBlock = *block->cachedBlock;
 
-    if (blockTemplate.previousBlockHash != previousBlockHash) {
+    if (block->blockTemplate.previousBlockHash != previousBlockHash) {
       logger(Logging::ERROR) << "Corrupted blockchain. Block with index " << i << " and hash " << cachedBlock.getBlockHash()
-                             << " has previous block hash " << blockTemplate.previousBlockHash << ", but parent has hash " << previousBlockHash
+                             << " has previous block hash " << block->blockTemplate.previousBlockHash << ", but parent has hash " << previousBlockHash
                              << ". Resynchronize your daemon please.";
       throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
     }
 
     previousBlockHash = cachedBlock.getBlockHash();
 
-    std::vector<CachedTransaction> transactions;
-    uint64_t cumulativeSize = 0;
-    if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
+    if (!block->transactionsExtracted) {
       logger(Logging::ERROR) << "Couldn't deserialize raw block transactions in block " << cachedBlock.getBlockHash();
       throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
     }
 
-    cumulativeSize += getObjectBinarySize(blockTemplate.baseTransaction);
-    TransactionValidatorState spentOutputs = extractSpentOutputs(transactions);
     auto currentDifficulty = chainsLeaves[0]->getDifficultyForNextBlock(i - 1);
-
-    uint64_t cumulativeFee = std::accumulate(transactions.begin(), transactions.end(), UINT64_C(0), [] (uint64_t fee, const CachedTransaction& transaction) {
-      return fee + transaction.getTransactionFee();
-    });
-
-    int64_t emissionChange = getEmissionChange(currency, *chainsLeaves[0], i - 1, cachedBlock, cumulativeSize, cumulativeFee);
-    chainsLeaves[0]->pushBlock(cachedBlock, transactions, spentOutputs, cumulativeSize, emissionChange, currentDifficulty, std::move(rawBlock));
+    int64_t emissionChange = getEmissionChange(currency, *chainsLeaves[0], i - 1, cachedBlock, block->cumulativeSize, block->cumulativeFee);
+    chainsLeaves[0]->pushBlock(cachedBlock, block->transactions, block->spentOutputs, block->cumulativeSize, emissionChange, currentDifficulty,
+                               std::move(block->rawBlock));
 
     if (i % 1000 == 0) {
-      logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1);
+      auto now = std::chrono::steady_clock::now();
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - reportTime).count();
+      logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1)
+                            << ", " << (i - reportIndex) * 1000 / std::max<int64_t>(elapsed, 1) << " blocks/s";
+      reportTime = now;
+      reportIndex = i;
     }
   }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+  logger(Logging::INFO) << "Imported " << (blockCount - 1 - commonIndex) << " blocks in " << elapsed / 1000 << " s, "
+                        << static_cast<int64_t>(blockCount - 1 - commonIndex) * 1000 / std::max<int64_t>(elapsed, 1) << " blocks/s";
+}
+
+void Core::prepareImportedBlock(PreparedBlock& block) {
+  block.blockTemplate = extractBlockTemplate(block.rawBlock);
+  block.cachedBlock.reset(new CachedBlock(block.blockTemplate));
+  block.cachedBlock->getBlockHash();
+
+  block.transactionsExtracted = extractTransactions(block.rawBlock.transactions, block.transactions, block.cumulativeSize);
+  if (!block.transactionsExtracted) {
+    return;
+  }
+
+  block.cumulativeSize += getObjectBinarySize(block.blockTemplate.baseTransaction);
+  block.spentOutputs = extractSpentOutputs(block.transactions);
+  for (const auto& transaction : block.transactions) {
+    transaction.getTransactionHash();
+    block.cumulativeFee += transaction.getTransactionFee();
+  }
 }
 
 void Core::cutSegment(IBlockchainCache& segment, uint32_t startIndex) {
@@ -1494,8 +1948,30 @@ void Core::cutSegment(IBlockchainCache& segment, uint32_t startIndex) {
   }
 
   logger(Logging::INFO) << "Cutting root segment from index " << startIndex;
-  auto childCache = segment.split(startIndex);
-  segment.deleteChild(childCache.get());
+  segment.truncate(startIndex);
+}
+
+void Core::pruneMainChain() {
+  uint32_t pruneDepth = config.getPruneDepth();
+  if (pruneDepth == 0 || chainsLeaves[0]->getTopBlockIndex() < pruneDepth) {
+    return;
+  }
+
+  // alternative chains must stay switchable, so blocks they are split off after are kept
+  uint32_t endIndex = chainsLeaves[0]->getTopBlockIndex() + 1 - pruneDepth;
+  for (const auto& segment : chainsStorage) {
+    if (segment->getParent() != nullptr) {
+      endIndex = std::min(endIndex, segment->getStartBlockIndex());
+    }
+  }
+
+  if (endIndex < chainsLeaves[0]->getPrunedBlockCount() + PRUNE_STEP) {
+    return;
+  }
+
+  chainsLeaves[0]->pruneBlocks(endIndex);
+  mainChainStorage->pruneBlocks(chainsLeaves[0]->getPrunedBlockCount());
+  logger(Logging::INFO) << "Pruned transactions of blocks below index " << chainsLeaves[0]->getPrunedBlockCount();
 }
 
 void Core::updateMainChainSet() {
@@ -1511,25 +1987,32 @@ void Core::updateMainChainSet() {
 IBlockchainCache* Core::findSegmentContainingBlock(const Crypto::Hash& blockHash) const {
   assert(chainsLeaves.size() > 0);
 
-  // first search in main chain
-  auto blockSegment = findMainChainSegmentContainingBlock(blockHash);
-  if (blockSegment != nullptr) {
-    return blockSegment;
+  // segments never share blocks, so a block is either in the index or in the root segment
+  auto it = blockSegments.find(blockHash);
+  if (it != blockSegments.end()) {
+    return it->second;
   }
 
-  // than search in alternative chains
-  return findAlternativeSegmentContainingBlock(blockHash);
+  IBlockchainCache* rootSegment = getRootSegment();
+  return rootSegment->hasBlock(blockHash) ? rootSegment : nullptr;
 }
 
 IBlockchainCache* Core::findAlternativeSegmentContainingBlock(const Crypto::Hash& blockHash) const {
-  IBlockchainCache* cache = nullptr;
-  std::find_if(++chainsLeaves.begin(), chainsLeaves.end(),
-               [&](IBlockchainCache* chain) { return cache = findIndexInChain(chain, blockHash); });
-  return cache;
+  auto it = blockSegments.find(blockHash);
+  if (it == blockSegments.end() || mainChainSet.count(it->second) != 0) {
+    return nullptr;
+  }
+
+  return it->second;
 }
 
 IBlockchainCache* Core::findMainChainSegmentContainingBlock(const Crypto::Hash& blockHash) const {
-  return findIndexInChain(chainsLeaves[0], blockHash);
+  IBlockchainCache* segment = findSegmentContainingBlock(blockHash);
+  if (segment == nullptr || mainChainSet.count(segment) == 0) {
+    return nullptr;
+  }
+
+  return segment;
 }
 
 IBlockchainCache* Core::findMainChainSegmentContainingBlock(uint32_t blockIndex) const {
@@ -1702,6 +2185,14 @@ void Core::getTransactionPoolDifference(const std::vector<Crypto::Hash>& knownHa
   deletedTransactions.assign(knownTransactions.begin(), knownTransactions.end());
 }
 
+TransactionPrefixInfo Core::getPoolTransactionPrefixInfo(const Crypto::Hash& transactionHash) const {
+  TransactionPrefixInfo transactionPrefixInfo;
+  transactionPrefixInfo.txHash = transactionHash;
+  transactionPrefixInfo.txPrefix =
+      static_cast<const TransactionPrefix&>(transactionPool->getTransaction(transactionHash).getTransaction());
+  return transactionPrefixInfo;
+}
+
 uint8_t Core::getBlockMajorVersionForHeight(uint32_t height) const {
   return upgradeManager->getBlockMajorVersion(height);
 }
@@ -1713,8 +2204,7 @@ size_t Core::calculateCumulativeBlocksizeLimit(uint32_t height) const {
   assert(!chainsStorage.empty());
   assert(!chainsLeaves.empty());
   // FIXME: skip gensis here?
-  auto sizes = chainsLeaves[0]->getLastBlocksSizes(currency.rewardBlocksWindow());
-  uint64_t median = Common::medianValue(sizes);
+  uint64_t median = getLastBlocksSizesMedian(chainsLeaves[0], chainsLeaves[0]->getTopBlockIndex(), skipGenesisBlock);
   if (median <= nextBlockGrantedFullRewardZone) {
     median = nextBlockGrantedFullRewardZone;
   }
@@ -1722,48 +2212,91 @@ size_t Core::calculateCumulativeBlocksizeLimit(uint32_t height) const {
   return median * 2;
 }
 
-void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t maxCumulativeSize,
-                             size_t& transactionsSize, uint64_t& fee) const {
-  transactionsSize = 0;
-  fee = 0;
-
-  size_t maxTotalSize = (125 * medianSize) / 100;
-  maxTotalSize = std::min(maxTotalSize, maxCumulativeSize) - currency.minerTxBlobReservedSize();
-
-  TransactionSpentInputsChecker spentInputsChecker;
+void Core::fillBlockTemplate(BlockTemplateTransactions& transactions) const {
+  transactions.transactionHashes.clear();
+  transactions.spentKeyImages.clear();
+  transactions.transactionsSize = 0;
+  transactions.fee = 0;
+  transactions.cheapestTransactionFee = 0;
+  transactions.cheapestTransactionSize = 0;
 
-  std::vector<CachedTransaction> poolTransactions = transactionPool->getPoolTransactions();
-  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && it->getTransactionFee() == 0; ++it) {
-    const CachedTransaction& transaction = *it;
+  // fusion transactions have no fee, so they are the least profitable ones
+  transactionPool->forEachTransaction(false, [this, &transactions](const CachedTransaction& transaction) {
+    if (transaction.getTransactionFee() != 0) {
+      return false;
+    }
 
     auto transactionBlobSize = transaction.getTransactionBinaryArray().size();
-    if (currency.fusionTxMaxSize() < transactionsSize + transactionBlobSize) {
-      continue;
+    if (currency.fusionTxMaxSize() < transactions.transactionsSize + transactionBlobSize) {
+      return true;
     }
 
-    if (!spentInputsChecker.haveSpentInputs(transaction.getTransaction())) {
-      block.transactionHashes.emplace_back(transaction.getTransactionHash());
-      transactionsSize += transactionBlobSize;
+    if (!haveSpentInputs(transaction.getTransaction(), transactions.spentKeyImages)) {
+      transactions.transactionHashes.emplace_back(transaction.getTransactionHash());
+      transactions.transactionsSize += transactionBlobSize;
       logger(Logging::TRACE) << "Fusion transaction " << transaction.getTransactionHash() << " included to block template";
     }
-  }
 
-  for (const auto& cachedTransaction : poolTransactions) {
-    size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
-
-    if (blockSizeLimit < transactionsSize + cachedTransaction.getTransactionBinaryArray().size()) {
-      continue;
-    }
+    return true;
+  });
 
-    if (!spentInputsChecker.haveSpentInputs(cachedTransaction.getTransaction())) {
-      transactionsSize += cachedTransaction.getTransactionBinaryArray().size();
-      fee += cachedTransaction.getTransactionFee();
-      block.transactionHashes.emplace_back(cachedTransaction.getTransactionHash());
+  // transactions are visited without copying, and only until the block is full
+  transactionPool->forEachTransaction(true, [this, &transactions](const CachedTransaction& cachedTransaction) {
+    if (addToBlockTemplate(transactions, cachedTransaction)) {
       logger(Logging::TRACE) << "Transaction " << cachedTransaction.getTransactionHash() << " included to block template";
     } else {
       logger(Logging::TRACE) << "Transaction " << cachedTransaction.getTransactionHash() << " is failed to include to block template";
     }
+
+    return transactions.transactionsSize < transactions.maxTotalSize;
+  });
+}
+
+bool Core::addToBlockTemplate(BlockTemplateTransactions& transactions, const CachedTransaction& transaction) const {
+  size_t blockSizeLimit = (transaction.getTransactionFee() == 0) ? transactions.medianSize : transactions.maxTotalSize;
+  if (blockSizeLimit < transactions.transactionsSize + transaction.getTransactionBinaryArray().size()) {
+    return false;
+  }
+
+  if (haveSpentInputs(transaction.getTransaction(), transactions.spentKeyImages)) {
+    return false;
+  }
+
+  size_t transactionSize = transaction.getTransactionBinaryArray().size();
+  uint64_t transactionFee = transaction.getTransactionFee();
+  if (transactionFee != 0 && (transactions.cheapestTransactionSize == 0 || paysMorePerByte(transactions.cheapestTransactionFee,
+      transactions.cheapestTransactionSize, transactionFee, transactionSize))) {
+    transactions.cheapestTransactionFee = transactionFee;
+    transactions.cheapestTransactionSize = transactionSize;
   }
+
+  transactions.transactionsSize += transactionSize;
+  transactions.fee += transactionFee;
+  transactions.transactionHashes.emplace_back(transaction.getTransactionHash());
+  return true;
+}
+
+// Transactions are chosen from the whole pool only when the main chain top changes, a chosen transaction leaves
+// the pool or a transaction paying more per byte than a chosen one doesn't fit. Other transactions entering the pool
+// meanwhile are appended by pushTransactionToPool if they fit.
+const Core::BlockTemplateTransactions& Core::getBlockTemplateTransactions(size_t medianSize, size_t maxCumulativeSize) const {
+  size_t maxTotalSize = (125 * medianSize) / 100;
+  maxTotalSize = std::min(maxTotalSize, maxCumulativeSize) - currency.minerTxBlobReservedSize();
+
+  auto& transactions = blockTemplateTransactions;
+  bool actual = transactions.topBlockHash == chainsLeaves[0]->getTopBlockHash() && transactions.medianSize == medianSize &&
+    transactions.maxTotalSize == maxTotalSize &&
+    std::all_of(transactions.transactionHashes.begin(), transactions.transactionHashes.end(),
+      [this](const Crypto::Hash& hash) { return transactionPool->checkIfTransactionPresent(hash); });
+
+  if (!actual) {
+    transactions.topBlockHash = chainsLeaves[0]->getTopBlockHash();
+    transactions.medianSize = medianSize;
+    transactions.maxTotalSize = maxTotalSize;
+    fillBlockTemplate(transactions);
+  }
+
+  return transactions;
 }
 
 void Core::deleteAlternativeChains() {
@@ -1781,6 +2314,7 @@ void Core::deleteLeaf(size_t leafIndex) {
   if (parent != nullptr) {
     bool r = parent->deleteChild(leaf);
     assert(r);
+    unindexSegment(leaf);
   }
 
   auto segmentIt =
@@ -1835,6 +2369,10 @@ void Core::mergeMainChainSegments() {
   chainsStorage.erase(++chainsStorage.begin(), chainsStorage.end());
   chainsLeaves.clear();
   chainsLeaves.push_back(chainsStorage.begin()->get());
+
+  // everything left is in the root segment now
+  blockSegments.clear();
+  transactionSegments.clear();
 }
 
 void Core::mergeSegments(IBlockchainCache* acceptingSegment, IBlockchainCache* segment) {
@@ -2079,23 +2617,15 @@ TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHa
 std::vector<Crypto::Hash> Core::getAlternativeBlockHashesByIndex(uint32_t blockIndex) const {
   throwIfNotInitialized();
 
+  // every alternative segment is checked once, even if it is shared by several leaves
   std::vector<Crypto::Hash> alternativeBlockHashes;
-  for (size_t chain = 1; chain < chainsLeaves.size(); ++chain) {
-    IBlockchainCache* segment = chainsLeaves[chain];
-    if (segment->getTopBlockIndex() < blockIndex) {
-      continue;
+  for (const auto& segment : chainsStorage) {
+    if (mainChainSet.count(segment.get()) == 0 && segment->getStartBlockIndex() <= blockIndex &&
+        blockIndex <= segment->getTopBlockIndex()) {
+      alternativeBlockHashes.push_back(segment->getBlockHash(blockIndex));
     }
-
-    do {
-      if (segment->getTopBlockIndex() - segment->getBlockCount() + 1 <= blockIndex) {
-        alternativeBlockHashes.push_back(segment->getBlockHash(blockIndex));
-        break;
-      } else if (segment->getTopBlockIndex() - segment->getBlockCount() - 1 > blockIndex) {
-        segment = segment->getParent();
-        assert(segment != nullptr);
-      }
-    } while (mainChainSet.count(segment) == 0);
   }
+
   return alternativeBlockHashes;
 }
 
@@ -2143,34 +2673,85 @@ IBlockchainCache* Core::findSegmentContainingTransaction(const Crypto::Hash& tra
   assert(!chainsLeaves.empty());
   assert(!chainsStorage.empty());
 
-  IBlockchainCache* segment = chainsLeaves[0];
-  assert(segment != nullptr);
-
   //find in main chain
-  do {
-    if (segment->hasTransaction(transactionHash)) {
-      return segment;
-    }
+  IBlockchainCache* segment = findIndexedSegmentContainingTransaction(transactionHash, true);
+  if (segment != nullptr) {
+    return segment;
+  }
 
-    segment = segment->getParent();
-  } while (segment != nullptr);
+  IBlockchainCache* rootSegment = getRootSegment();
+  if (rootSegment->hasTransaction(transactionHash)) {
+    return rootSegment;
+  }
 
   //find in alternative chains
-  for (size_t chain = 1; chain < chainsLeaves.size(); ++chain) {
-    segment = chainsLeaves[chain];
-
-    while (mainChainSet.count(segment) == 0) {
-      if (segment->hasTransaction(transactionHash)) {
-        return segment;
-      }
+  return findIndexedSegmentContainingTransaction(transactionHash, false);
+}
 
-      segment = segment->getParent();
+IBlockchainCache* Core::findIndexedSegmentContainingTransaction(const Crypto::Hash& transactionHash, bool mainChain) const {
+  auto range = transactionSegments.equal_range(transactionHash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if ((mainChainSet.count(it->second) != 0) == mainChain) {
+      return it->second;
     }
   }
 
   return nullptr;
 }
 
+IBlockchainCache* Core::getRootSegment() const {
+  assert(!chainsStorage.empty());
+  assert(chainsStorage.front()->getParent() == nullptr);
+
+  return chainsStorage.front().get();
+}
+
+void Core::indexBlock(IBlockchainCache* segment, const CachedBlock& block) {
+  if (segment == getRootSegment()) {
+    return;
+  }
+
+  blockSegments[block.getBlockHash()] = segment;
+  for (const auto& transactionHash : getBlockTransactionHashes(block.getBlock())) {
+    transactionSegments.emplace(transactionHash, segment);
+  }
+}
+
+void Core::indexSegment(IBlockchainCache* segment, IBlockchainCache* previousSegment) {
+  auto startIndex = segment->getStartBlockIndex();
+  for (auto blockIndex = startIndex; blockIndex < startIndex + segment->getBlockCount(); ++blockIndex) {
+    auto blockTemplate = extractBlockTemplate(segment->getBlockByIndex(blockIndex));
+    CachedBlock block(blockTemplate);
+    for (const auto& transactionHash : getBlockTransactionHashes(block.getBlock())) {
+      unindexTransaction(transactionHash, previousSegment);
+    }
+
+    indexBlock(segment, block);
+  }
+}
+
+void Core::unindexSegment(IBlockchainCache* segment) {
+  auto startIndex = segment->getStartBlockIndex();
+  for (auto blockIndex = startIndex; blockIndex < startIndex + segment->getBlockCount(); ++blockIndex) {
+    auto blockTemplate = extractBlockTemplate(segment->getBlockByIndex(blockIndex));
+    CachedBlock block(blockTemplate);
+    blockSegments.erase(block.getBlockHash());
+    for (const auto& transactionHash : getBlockTransactionHashes(block.getBlock())) {
+      unindexTransaction(transactionHash, segment);
+    }
+  }
+}
+
+void Core::unindexTransaction(const Crypto::Hash& transactionHash, IBlockchainCache* segment) {
+  auto range = transactionSegments.equal_range(transactionHash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == segment) {
+      transactionSegments.erase(it);
+      return;
+    }
+  }
+}
+
 bool Core::hasTransaction(const Crypto::Hash& transactionHash) const {
   throwIfNotInitialized();
   return findSegmentContainingTransaction(transactionHash) != nullptr || transactionPool->checkIfTransactionPresent(transactionHash);
@@ -2198,9 +2779,77 @@ void Core::updateBlockMedianSize() {
 
   size_t nextBlockGrantedFullRewardZone = currency.blockGrantedFullRewardZoneByHeight(mainChain->getTopBlockIndex() + 1);
 
-  auto lastBlockSizes = mainChain->getLastBlocksSizes(currency.rewardBlocksWindow());
+  auto median = getLastBlocksSizesMedian(mainChain, mainChain->getTopBlockIndex(), skipGenesisBlock);
+
+  blockMedianSize = std::max(median, static_cast<uint64_t>(nextBlockGrantedFullRewardZone));
+}
+
+void Core::updateMainChainWindows() const {
+  auto mainChain = chainsLeaves[0];
+  if (mainChain->getBlockCount() == 0) {
+    lastBlocksSizes.clear();
+    lastBlocksTimestamps.clear();
+    windowsTopBlockHash = NULL_HASH;
+    return;
+  }
+
+  auto topBlockIndex = mainChain->getTopBlockIndex();
+  auto topBlockHash = mainChain->getTopBlockHash();
+  if (topBlockHash == windowsTopBlockHash) {
+    return;
+  }
+
+  // main chain has grown since the last update: only new blocks are pushed,
+  // otherwise (reorganization, rewind) both windows are reread
+  size_t count;
+  if (windowsTopBlockHash != NULL_HASH && windowsTopBlockIndex < topBlockIndex &&
+      topBlockIndex - windowsTopBlockIndex < lastBlocksSizes.getWindowSize() &&
+      mainChain->getBlockHash(windowsTopBlockIndex) == windowsTopBlockHash) {
+    count = topBlockIndex - windowsTopBlockIndex;
+  } else {
+    lastBlocksSizes.clear();
+    lastBlocksTimestamps.clear();
+    count = lastBlocksSizes.getWindowSize();
+  }
+
+  for (auto size : mainChain->getLastBlocksSizes(count, topBlockIndex, addGenesisBlock)) {
+    lastBlocksSizes.push(size);
+  }
+
+  auto timestampsCount = std::min(count, lastBlocksTimestamps.getWindowSize());
+  for (auto timestamp : mainChain->getLastTimestamps(timestampsCount, topBlockIndex, addGenesisBlock)) {
+    lastBlocksTimestamps.push(timestamp);
+  }
+
+  windowsTopBlockHash = topBlockHash;
+  windowsTopBlockIndex = topBlockIndex;
+}
+
+bool Core::isMainChainTopBlock(IBlockchainCache* segment, uint32_t blockIndex) const {
+  return mainChainSet.count(segment) != 0 && blockIndex == chainsLeaves[0]->getTopBlockIndex();
+}
+
+uint64_t Core::getLastBlocksSizesMedian(IBlockchainCache* segment, uint32_t blockIndex, UseGenesis useGenesis) const {
+  // windows include genesis block, it can be skipped only by a window which doesn't reach it
+  if (isMainChainTopBlock(segment, blockIndex) && (useGenesis || blockIndex >= currency.rewardBlocksWindow())) {
+    updateMainChainWindows();
+    return lastBlocksSizes.median();
+  }
+
+  auto sizes = segment->getLastBlocksSizes(currency.rewardBlocksWindow(), blockIndex, useGenesis);
+  return Common::medianValue(sizes);
+}
+
+bool Core::getLastTimestampsMedian(IBlockchainCache* segment, uint32_t blockIndex, uint64_t& median) const {
+  if (isMainChainTopBlock(segment, blockIndex)) {
+    updateMainChainWindows();
+    median = lastBlocksTimestamps.median();
+    return lastBlocksTimestamps.size() >= currency.timestampCheckWindow();
+  }
 
-  blockMedianSize = std::max(Common::medianValue(lastBlockSizes), static_cast<uint64_t>(nextBlockGrantedFullRewardZone));
+  auto timestamps = segment->getLastTimestamps(currency.timestampCheckWindow(), blockIndex, addGenesisBlock);
+  median = Common::medianValue(timestamps);
+  return timestamps.size() >= currency.timestampCheckWindow();
 }
 
 }
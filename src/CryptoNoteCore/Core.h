@@ -18,12 +18,16 @@
 #pragma once
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include "BlockImportPipeline.h"
 #include "BlockchainCache.h"
 #include "BlockchainMessages.h"
+#include "BlockchainReadSnapshot.h"
 #include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "Currency.h"
 #include "Checkpoints.h"
+#include "CoreConfig.h"
 #include "IBlockchainCache.h"
 #include "IBlockchainCacheFactory.h"
 #include "ICore.h"
@@ -35,10 +39,14 @@
 #include <Logging/LoggerMessage.h>
 #include "MessageQueue.h"
 #include "TransactionValidatiorState.h"
+#include "VerifiedTransactionCache.h"
 #include "SwappedVector.h"
 
 #include "CryptoNoteCore/MinerConfig.h"
 
+#include <Common/RollingMedian.h>
+#include <Common/WorkerPool.h>
+
 #include <System/ContextGroup.h>
 
 namespace CryptoNote {
@@ -46,7 +54,8 @@ namespace CryptoNote {
 class Core : public ICore, public ICoreInformation {
 public:
   Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& checkpoints, System::Dispatcher& dispatcher,
-       std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainChainStorage);
+       std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainChainStorage,
+       const CoreConfig& config = CoreConfig());
   virtual ~Core();
 
   virtual bool addMessageQueue(MessageQueue<BlockchainMessage>&  messageQueue) override;
@@ -56,6 +65,7 @@ public:
   virtual Crypto::Hash getTopBlockHash() const override;
   virtual Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const override;
   virtual uint64_t getBlockTimestampByIndex(uint32_t blockIndex) const override;
+  virtual uint32_t getPrunedBlockCount() const override;
 
   virtual bool hasBlock(const Crypto::Hash& blockHash) const override;
   virtual BlockTemplate getBlockByIndex(uint32_t index) const override;
@@ -87,12 +97,15 @@ public:
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) override;
+  virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) override;
 
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<BinaryArray>& addedTransactions,
     std::vector<Crypto::Hash>& deletedTransactions) const override;
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<TransactionPrefixInfo>& addedTransactions,
     std::vector<Crypto::Hash>& deletedTransactions) const override;
+  virtual bool getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t& sequence, std::vector<TransactionPrefixInfo>& addedTransactions,
+    std::vector<Crypto::Hash>& deletedTransactions, bool& fullResync) const override;
 
   virtual bool getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, const BinaryArray& extraNonce, Difficulty& difficulty, uint32_t& height) const override;
 
@@ -108,6 +121,10 @@ public:
   
   const Currency& getCurrency() const;
 
+  // Main chain blocks stored in the data base, nullptr if a snapshot isn't available.
+  // The snapshot may be read on another thread while blocks keep being added.
+  std::unique_ptr<BlockchainReadSnapshot> createReadSnapshot() const;
+
   virtual void save() override;
   virtual void load() override;
 
@@ -118,7 +135,16 @@ public:
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
 
 private:
+  struct RingSignatureCheck {
+    const Transaction* transaction;
+    Crypto::Hash prefixHash;
+    size_t inputIndex;
+    std::vector<Crypto::PublicKey> outputKeys;
+    bool checkKeyImage;
+  };
+
   const Currency& currency;
+  CoreConfig config;
   System::Dispatcher& dispatcher;
   System::ContextGroup contextGroup;
   Logging::LoggerRef logger;
@@ -130,6 +156,11 @@ private:
   std::unique_ptr<ITransactionPoolCleanWrapper> transactionPool;
   std::unordered_set<IBlockchainCache*> mainChainSet;
 
+  // Segments holding blocks and transactions outside of the root segment. The root segment keeps the rest of
+  // the blockchain and is asked directly, so lookups don't have to walk every chain.
+  std::unordered_map<Crypto::Hash, IBlockchainCache*> blockSegments;
+  std::unordered_multimap<Crypto::Hash, IBlockchainCache*> transactionSegments;
+
   std::string dataFolder;
 
   IntrusiveLinkedList<MessageQueue<BlockchainMessage>> queueList;
@@ -138,12 +169,56 @@ private:
   bool initialized;
 
   size_t blockMedianSize;
+  // windows of the blocks up to windowsTopBlockHash in the main chain, genesis block included
+  mutable Common::RollingMedian<uint64_t> lastBlocksSizes;
+  mutable Common::RollingMedian<uint64_t> lastBlocksTimestamps;
+  mutable Crypto::Hash windowsTopBlockHash;
+  mutable uint32_t windowsTopBlockIndex;
+
+  // transactions chosen from the pool for a block on top of topBlockHash, see getBlockTemplateTransactions
+  struct BlockTemplateTransactions {
+    Crypto::Hash topBlockHash;
+    size_t medianSize;
+    size_t maxTotalSize;
+    std::vector<Crypto::Hash> transactionHashes;
+    std::unordered_set<Crypto::KeyImage> spentKeyImages;
+    size_t transactionsSize;
+    uint64_t fee;
+    // fee and size of the chosen transaction paying the least per byte, size is zero if none pays a fee
+    uint64_t cheapestTransactionFee;
+    size_t cheapestTransactionSize;
+  };
+
+  mutable BlockTemplateTransactions blockTemplateTransactions;
+  std::unique_ptr<Common::WorkerPool> workerPool;
+  VerifiedTransactionCache verifiedTransactions;
+  uint64_t verifiedTransactionCacheHits;
+  uint64_t verifiedTransactionCacheMisses;
+
+  // work done by addTransactionsToPool for relayed transactions, stage times are in microseconds
+  struct TransactionAdmissionStatistics {
+    uint64_t batchCount;
+    uint64_t transactionCount;
+    uint64_t maxBatchSize;
+    uint64_t parseTime;
+    uint64_t inputsTime;
+    uint64_t signaturesTime;
+    uint64_t insertionTime;
+  };
+
+  TransactionAdmissionStatistics admissionStatistics;
 
   void throwIfNotInitialized() const;
   bool extractTransactions(const std::vector<BinaryArray>& rawTransactions, std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize);
 
   std::error_code validateSemantic(const Transaction& transaction, uint64_t& fee);
   std::error_code validateTransaction(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex);
+  std::error_code validateTransactionInputs(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee,
+    uint32_t blockIndex, std::vector<RingSignatureCheck>& signatureChecks);
+  bool checkRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks);
+  static bool checkRingSignatureRange(const std::vector<RingSignatureCheck>& signatureChecks, size_t begin, size_t end);
+  bool isTransactionVerified(const CachedTransaction& transaction, const std::vector<RingSignatureCheck>& signatureChecks, size_t firstCheck);
+  void addVerifiedTransaction(const CachedTransaction& transaction, const std::vector<RingSignatureCheck>& signatureChecks, size_t firstCheck);
 
   uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds) const;
   std::vector<Crypto::Hash> getBlockHashes(uint32_t startBlockIndex, uint32_t maxCount) const;
@@ -160,6 +235,13 @@ private:
   IBlockchainCache* findAlternativeSegmentContainingBlock(uint32_t blockIndex) const;
 
   IBlockchainCache* findSegmentContainingTransaction(const Crypto::Hash& transactionHash) const;
+  IBlockchainCache* findIndexedSegmentContainingTransaction(const Crypto::Hash& transactionHash, bool mainChain) const;
+
+  IBlockchainCache* getRootSegment() const;
+  void indexBlock(IBlockchainCache* segment, const CachedBlock& block);
+  void indexSegment(IBlockchainCache* segment, IBlockchainCache* previousSegment);
+  void unindexSegment(IBlockchainCache* segment);
+  void unindexTransaction(const Crypto::Hash& transactionHash, IBlockchainCache* segment);
 
   BlockTemplate restoreBlockTemplate(IBlockchainCache* blockchainCache, uint32_t blockIndex) const;
   std::vector<Crypto::Hash> doBuildSparseChain(const Crypto::Hash& blockHash) const;
@@ -173,10 +255,13 @@ private:
   void fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, std::vector<BlockShortInfo>& entries) const;
 
   void getTransactionPoolDifference(const std::vector<Crypto::Hash>& knownHashes, std::vector<Crypto::Hash>& newTransactions, std::vector<Crypto::Hash>& deletedTransactions) const;
+  TransactionPrefixInfo getPoolTransactionPrefixInfo(const Crypto::Hash& transactionHash) const;
 
   uint8_t getBlockMajorVersionForHeight(uint32_t height) const;
   size_t calculateCumulativeBlocksizeLimit(uint32_t height) const;
-  void fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t maxCumulativeSize, size_t& transactionsSize, uint64_t& fee) const;
+  void fillBlockTemplate(BlockTemplateTransactions& transactions) const;
+  bool addToBlockTemplate(BlockTemplateTransactions& transactions, const CachedTransaction& transaction) const;
+  const BlockTemplateTransactions& getBlockTemplateTransactions(size_t medianSize, size_t maxCumulativeSize) const;
   void deleteAlternativeChains();
   void deleteLeaf(size_t leafIndex);
   void mergeMainChainSegments();
@@ -191,12 +276,29 @@ private:
 
   void transactionPoolCleaningProcedure();
   void updateBlockMedianSize();
+  void updateMainChainWindows() const;
+  bool isMainChainTopBlock(IBlockchainCache* segment, uint32_t blockIndex) const;
+  uint64_t getLastBlocksSizesMedian(IBlockchainCache* segment, uint32_t blockIndex, UseGenesis useGenesis) const;
+  bool getLastTimestampsMedian(IBlockchainCache* segment, uint32_t blockIndex, uint64_t& median) const;
   bool addTransactionToPool(CachedTransaction&& cachedTransaction);
+  std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays,
+                                          TransactionAdmissionStatistics* statistics);
+  bool pushTransactionToPool(CachedTransaction&& cachedTransaction, TransactionValidatorState&& validatorState,
+                             std::vector<Crypto::Hash>& evictedTransactions);
   bool isTransactionValidForPool(const CachedTransaction& cachedTransaction, TransactionValidatorState& validatorState);
+  bool checkTransactionSizeAndFee(const CachedTransaction& cachedTransaction, uint64_t fee) const;
+  std::vector<char> checkPoolTransactionInputs(const std::vector<const CachedTransaction*>& transactions,
+    std::vector<TransactionValidatorState>& validatorStates, std::vector<std::vector<RingSignatureCheck>>& signatureChecks,
+    std::vector<size_t>& unverifiedTransactions);
+  void checkPoolTransactionSignatures(const std::vector<const CachedTransaction*>& transactions,
+    const std::vector<std::vector<RingSignatureCheck>>& signatureChecks, const std::vector<size_t>& unverifiedTransactions,
+    std::vector<char>& valid);
 
   void initRootSegment();
   void importBlocksFromStorage();
+  void prepareImportedBlock(PreparedBlock& block);
   void cutSegment(IBlockchainCache& segment, uint32_t startIndex);
+  void pruneMainChain();
 
   void switchMainChainStorage(uint32_t splitBlockIndex, IBlockchainCache& newChain);
 };
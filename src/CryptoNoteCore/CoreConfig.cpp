@@ -0,0 +1,90 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "CoreConfig.h"
+
+#include <algorithm>
+
+#include "Common/CommandLine.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint32_t DEFAULT_IMPORT_THREADS_COUNT = 0;
+// blocks a chain switch may need to move to an alternative segment must keep their transactions
+const uint32_t MIN_PRUNE_DEPTH = 1000;
+const uint64_t POOL_MAX_MB_DEFAULT_SIZE = 100;
+
+const uint64_t MEGABYTE = 1024 * 1024;
+
+const command_line::arg_descriptor<uint32_t> argImportThreadsCount = { "import-threads", "Number of threads preparing blocks imported from blockchain storage, 0 to use all cores", DEFAULT_IMPORT_THREADS_COUNT };
+const command_line::arg_descriptor<uint32_t> argPruneDepth = { "prune-depth", "Drop transactions of main chain blocks older than this number of blocks (at least 1000), 0 keeps everything", 0 };
+const command_line::arg_descriptor<uint64_t> argPoolMaxSize = { "pool-max-size", "Size of transactions kept in the pool in megabytes, the lowest fee per byte ones are evicted above it, 0 means no limit", POOL_MAX_MB_DEFAULT_SIZE };
+
+} //namespace
+
+void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, argImportThreadsCount);
+  command_line::add_arg(desc, argPruneDepth);
+  command_line::add_arg(desc, argPoolMaxSize);
+}
+
+CoreConfig::CoreConfig() :
+  importThreadsCount(DEFAULT_IMPORT_THREADS_COUNT),
+  pruneDepth(0),
+  poolMaxSize(POOL_MAX_MB_DEFAULT_SIZE * MEGABYTE) {
+}
+
+bool CoreConfig::init(const boost::program_options::variables_map& vm) {
+  if (vm.count(argImportThreadsCount.name) != 0 && !vm[argImportThreadsCount.name].defaulted()) {
+    importThreadsCount = command_line::get_arg(vm, argImportThreadsCount);
+  }
+
+  if (vm.count(argPruneDepth.name) != 0 && !vm[argPruneDepth.name].defaulted()) {
+    setPruneDepth(command_line::get_arg(vm, argPruneDepth));
+  }
+
+  if (vm.count(argPoolMaxSize.name) != 0 && !vm[argPoolMaxSize.name].defaulted()) {
+    poolMaxSize = command_line::get_arg(vm, argPoolMaxSize) * MEGABYTE;
+  }
+
+  return true;
+}
+
+uint32_t CoreConfig::getImportThreadsCount() const {
+  return importThreadsCount;
+}
+
+uint32_t CoreConfig::getPruneDepth() const {
+  return pruneDepth;
+}
+
+uint64_t CoreConfig::getPoolMaxSize() const {
+  return poolMaxSize;
+}
+
+void CoreConfig::setImportThreadsCount(uint32_t importThreadsCount) {
+  this->importThreadsCount = importThreadsCount;
+}
+
+void CoreConfig::setPruneDepth(uint32_t pruneDepth) {
+  this->pruneDepth = pruneDepth == 0 ? 0 : std::max(pruneDepth, MIN_PRUNE_DEPTH);
+}
+
+void CoreConfig::setPoolMaxSize(uint64_t poolMaxSize) {
+  this->poolMaxSize = poolMaxSize;
+}
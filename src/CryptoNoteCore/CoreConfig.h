@@ -0,0 +1,45 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstdint>
+
+#include <boost/program_options.hpp>
+
+namespace CryptoNote {
+
+class CoreConfig {
+public:
+  CoreConfig();
+  static void initOptions(boost::program_options::options_description& desc);
+  bool init(const boost::program_options::variables_map& vm);
+
+  uint32_t getImportThreadsCount() const; //0 means hardware concurrency
+  uint32_t getPruneDepth() const; //0 means no pruning
+  uint64_t getPoolMaxSize() const; //in bytes, 0 means no limit
+
+  void setImportThreadsCount(uint32_t importThreadsCount);
+  void setPruneDepth(uint32_t pruneDepth);
+  void setPoolMaxSize(uint64_t poolMaxSize);
+
+private:
+  uint32_t importThreadsCount;
+  uint32_t pruneDepth;
+  uint64_t poolMaxSize;
+};
+
+} //namespace CryptoNote
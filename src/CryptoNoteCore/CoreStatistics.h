@@ -27,6 +27,16 @@ struct CoreStatistics {
   uint64_t miningSpeed;
   uint64_t alternativeBlockCount;
   std::string topBlockHashString;
+  uint64_t verifiedTransactionCacheHits;
+  uint64_t verifiedTransactionCacheMisses;
+  uint64_t admittedTransactionBatches;
+  uint64_t admittedTransactions;
+  uint64_t maxAdmissionBatchSize;
+  // total microseconds spent in each stage of transaction admission
+  uint64_t admissionParseTime;
+  uint64_t admissionInputsTime;
+  uint64_t admissionSignaturesTime;
+  uint64_t admissionInsertionTime;
 
   void serialize(ISerializer& s) {    
     s(transactionPoolSize, "tx_pool_size");
@@ -34,6 +44,15 @@ struct CoreStatistics {
     s(miningSpeed, "mining_speed");
     s(alternativeBlockCount, "alternative_blocks");
     s(topBlockHashString, "top_block_id_str");
+    s(verifiedTransactionCacheHits, "verified_tx_cache_hits");
+    s(verifiedTransactionCacheMisses, "verified_tx_cache_misses");
+    s(admittedTransactionBatches, "admitted_tx_batches");
+    s(admittedTransactions, "admitted_txs");
+    s(maxAdmissionBatchSize, "max_admission_batch_size");
+    s(admissionParseTime, "admission_parse_us");
+    s(admissionInputsTime, "admission_inputs_us");
+    s(admissionSignaturesTime, "admission_signatures_us");
+    s(admissionInsertionTime, "admission_insertion_us");
   }
 };
 
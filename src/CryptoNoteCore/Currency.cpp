@@ -410,6 +410,13 @@ Difficulty Currency::nextDifficulty(std::vector<uint64_t> timestamps,
   sort(timestamps.begin(), timestamps.end());
 
   size_t cutBegin, cutEnd;
+  getDifficultyCut(length, cutBegin, cutEnd);
+  uint64_t timeSpan = timestamps[cutEnd - 1] - timestamps[cutBegin];
+  Difficulty totalWork = cumulativeDifficulties[cutEnd - 1] - cumulativeDifficulties[cutBegin];
+  return getDifficultyForWork(totalWork, timeSpan);
+}
+
+void Currency::getDifficultyCut(size_t length, size_t& cutBegin, size_t& cutEnd) const {
   assert(2 * m_difficultyCut <= m_difficultyWindow - 2);
   if (length <= m_difficultyWindow - 2 * m_difficultyCut) {
     cutBegin = 0;
@@ -419,12 +426,13 @@ Difficulty Currency::nextDifficulty(std::vector<uint64_t> timestamps,
     cutEnd = cutBegin + (m_difficultyWindow - 2 * m_difficultyCut);
   }
   assert(/*cut_begin >= 0 &&*/ cutBegin + 2 <= cutEnd && cutEnd <= length);
-  uint64_t timeSpan = timestamps[cutEnd - 1] - timestamps[cutBegin];
+}
+
+Difficulty Currency::getDifficultyForWork(Difficulty totalWork, uint64_t timeSpan) const {
   if (timeSpan == 0) {
     timeSpan = 1;
   }
 
-  Difficulty totalWork = cumulativeDifficulties[cutEnd - 1] - cumulativeDifficulties[cutBegin];
   assert(totalWork > 0);
 
   uint64_t low, high;
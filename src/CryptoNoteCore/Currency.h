@@ -118,6 +118,9 @@ public:
   bool parseAmount(const std::string& str, uint64_t& amount) const;
 
   Difficulty nextDifficulty(std::vector<uint64_t> timestamps, std::vector<Difficulty> cumulativeDifficulties) const;
+  // Bounds of sorted window of given length used by nextDifficulty
+  void getDifficultyCut(size_t length, size_t& cutBegin, size_t& cutEnd) const;
+  Difficulty getDifficultyForWork(Difficulty totalWork, uint64_t timeSpan) const;
 
   bool checkProofOfWorkV1(Crypto::cn_context& context, const CachedBlock& block, Difficulty currentDifficulty) const;
   bool checkProofOfWorkV2(Crypto::cn_context& context, const CachedBlock& block, Difficulty currentDifficulty) const;
@@ -17,6 +17,10 @@
 
 #include "DBUtils.h"
 
+#include <cstring>
+
+#include "Serialization/KVBinaryCommon.h"
+
 namespace {
   const std::string RAW_BLOCK_NAME = "raw_block";
   const std::string RAW_TXS_NAME = "raw_txs";
@@ -42,5 +46,32 @@ namespace DB {
     serializer(value.block, RAW_BLOCK_NAME);
     serializer(value.transactions, RAW_TXS_NAME);
   }
+
+  std::string getKeyPrefix(const std::string& rawKey) {
+    //serializeKey writes the header and a root section holding a single object named after the prefix
+    const size_t nameOffset = sizeof(KVBinaryStorageBlockHeader) + 2;
+    if (rawKey.size() <= nameOffset) {
+      return std::string();
+    }
+
+    KVBinaryStorageBlockHeader header;
+    std::memcpy(&header, rawKey.data(), sizeof(header));
+    if (header.m_signature_a != PORTABLE_STORAGE_SIGNATUREA || header.m_signature_b != PORTABLE_STORAGE_SIGNATUREB ||
+        header.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+      return std::string();
+    }
+
+    uint8_t rootCount = static_cast<uint8_t>(rawKey[sizeof(header)]);
+    if (rootCount != ((1 << 2) | PORTABLE_RAW_SIZE_MARK_BYTE)) {
+      return std::string();
+    }
+
+    uint8_t nameLength = static_cast<uint8_t>(rawKey[nameOffset - 1]);
+    if (rawKey.size() <= nameOffset + nameLength || static_cast<uint8_t>(rawKey[nameOffset + nameLength]) != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+      return std::string();
+    }
+
+    return rawKey.substr(nameOffset, nameLength);
+  }
 }
 }
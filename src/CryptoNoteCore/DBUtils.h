@@ -85,6 +85,9 @@ namespace DB {
     return DB::serialize(std::make_pair(keyPrefix, key), keyPrefix);
   }
 
+  //returns the prefix a key was serialized with by serializeKey, or an empty string if the key isn't such a key
+  std::string getKeyPrefix(const std::string& rawKey);
+
   template <class Value>
   void deserialize(const std::string& serialized, Value& value, const std::string& name) {
     std::stringstream ss(serialized);
@@ -31,6 +31,7 @@ namespace {
 
 const uint64_t WRITE_BUFFER_MB_DEFAULT_SIZE = 256;
 const uint64_t READ_BUFFER_MB_DEFAULT_SIZE = 10;
+const uint64_t OBJECT_CACHE_MB_DEFAULT_SIZE = 64;
 const uint32_t DEFAULT_MAX_OPEN_FILES = 100;
 const uint16_t DEFAULT_BACKGROUND_THREADS_COUNT = 2;
 
@@ -40,6 +41,12 @@ const command_line::arg_descriptor<uint16_t>    argBackgroundThreadsCount = { "d
 const command_line::arg_descriptor<uint32_t>    argMaxOpenFiles = { "db-max-open-files", "Number of open files that can be used by the DB", DEFAULT_MAX_OPEN_FILES};
 const command_line::arg_descriptor<uint64_t>    argWriteBufferSize = { "db-write-buffer-size", "Size of data base write buffer in megabytes", WRITE_BUFFER_MB_DEFAULT_SIZE};
 const command_line::arg_descriptor<uint64_t>    argReadCacheSize = { "db-read-cache-size", "Size of data base read cache in megabytes", READ_BUFFER_MB_DEFAULT_SIZE};
+const command_line::arg_descriptor<uint64_t>    argObjectCacheSize = { "db-object-cache-size", "Size of decoded blocks, transactions and outputs cache in megabytes", OBJECT_CACHE_MB_DEFAULT_SIZE};
+const command_line::arg_descriptor<bool>        argBulkSync = { "db-bulk-sync", "Buffer data base writes in memory and skip write-ahead log while syncing blocks inside the checkpoint zone" };
+const command_line::arg_descriptor<bool>        argRawBlocksInStorage = { "db-raw-blocks-in-storage", "Keep raw blocks only in the blockchain storage file instead of copying them to the data base" };
+const command_line::arg_descriptor<bool>        argWriteBehind = { "db-write-behind", "Queue data base writes and apply them in groups on a background thread" };
+const command_line::arg_descriptor<uint32_t>    argSyncWritesInterval = { "db-sync-writes", "Sync write-ahead log after this number of writes, 1 syncs every block, 0 leaves it to the OS", 0};
+const command_line::arg_descriptor<uint32_t>    argSyncTimeInterval = { "db-sync-interval", "Sync write-ahead log at least once in this number of seconds, 0 disables it", 0};
 
 } //namespace
 
@@ -48,6 +55,12 @@ void DataBaseConfig::initOptions(boost::program_options::options_description& de
   command_line::add_arg(desc, argMaxOpenFiles);
   command_line::add_arg(desc, argWriteBufferSize);
   command_line::add_arg(desc, argReadCacheSize);
+  command_line::add_arg(desc, argObjectCacheSize);
+  command_line::add_arg(desc, argBulkSync);
+  command_line::add_arg(desc, argRawBlocksInStorage);
+  command_line::add_arg(desc, argWriteBehind);
+  command_line::add_arg(desc, argSyncWritesInterval);
+  command_line::add_arg(desc, argSyncTimeInterval);
 }
 
 DataBaseConfig::DataBaseConfig() :
@@ -56,7 +69,13 @@ DataBaseConfig::DataBaseConfig() :
   maxOpenFiles(DEFAULT_MAX_OPEN_FILES),
   writeBufferSize(WRITE_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
   readCacheSize(READ_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
-  testnet(false) {
+  testnet(false),
+  bulkSync(false),
+  rawBlocksInStorage(false),
+  objectCacheSize(OBJECT_CACHE_MB_DEFAULT_SIZE * MEGABYTE),
+  writeBehind(false),
+  syncWritesInterval(0),
+  syncTimeInterval(0) {
 }
 
 bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
@@ -76,10 +95,34 @@ bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
     readCacheSize = command_line::get_arg(vm, argReadCacheSize) * MEGABYTE;
   }
 
+  if (vm.count(argObjectCacheSize.name) != 0 && !vm[argObjectCacheSize.name].defaulted()) {
+    objectCacheSize = command_line::get_arg(vm, argObjectCacheSize) * MEGABYTE;
+  }
+
   if (vm.count(command_line::arg_data_dir.name) != 0 && (!vm[command_line::arg_data_dir.name].defaulted() || dataDir == Tools::getDefaultDataDirectory())) {
     dataDir = command_line::get_arg(vm, command_line::arg_data_dir);
   }
 
+  if (command_line::has_arg(vm, argBulkSync)) {
+    bulkSync = true;
+  }
+
+  if (command_line::has_arg(vm, argRawBlocksInStorage)) {
+    rawBlocksInStorage = true;
+  }
+
+  if (command_line::has_arg(vm, argWriteBehind)) {
+    writeBehind = true;
+  }
+
+  if (vm.count(argSyncWritesInterval.name) != 0 && !vm[argSyncWritesInterval.name].defaulted()) {
+    syncWritesInterval = command_line::get_arg(vm, argSyncWritesInterval);
+  }
+
+  if (vm.count(argSyncTimeInterval.name) != 0 && !vm[argSyncTimeInterval.name].defaulted()) {
+    syncTimeInterval = command_line::get_arg(vm, argSyncTimeInterval);
+  }
+
   configFolderDefaulted = vm[command_line::arg_data_dir.name].defaulted();
 
   return true;
@@ -113,6 +156,30 @@ bool DataBaseConfig::getTestnet() const {
   return testnet;
 }
 
+bool DataBaseConfig::getBulkSync() const {
+  return bulkSync;
+}
+
+bool DataBaseConfig::getRawBlocksInStorage() const {
+  return rawBlocksInStorage;
+}
+
+uint64_t DataBaseConfig::getObjectCacheSize() const {
+  return objectCacheSize;
+}
+
+bool DataBaseConfig::getWriteBehind() const {
+  return writeBehind;
+}
+
+uint32_t DataBaseConfig::getSyncWritesInterval() const {
+  return syncWritesInterval;
+}
+
+uint32_t DataBaseConfig::getSyncTimeInterval() const {
+  return syncTimeInterval;
+}
+
 void DataBaseConfig::setConfigFolderDefaulted(bool defaulted) {
   configFolderDefaulted = defaulted;
 }
@@ -140,3 +207,27 @@ void DataBaseConfig::setReadCacheSize(uint64_t readCacheSize) {
 void DataBaseConfig::setTestnet(bool testnet) {
   this->testnet = testnet;
 }
+
+void DataBaseConfig::setBulkSync(bool bulkSync) {
+  this->bulkSync = bulkSync;
+}
+
+void DataBaseConfig::setRawBlocksInStorage(bool rawBlocksInStorage) {
+  this->rawBlocksInStorage = rawBlocksInStorage;
+}
+
+void DataBaseConfig::setObjectCacheSize(uint64_t objectCacheSize) {
+  this->objectCacheSize = objectCacheSize;
+}
+
+void DataBaseConfig::setWriteBehind(bool writeBehind) {
+  this->writeBehind = writeBehind;
+}
+
+void DataBaseConfig::setSyncWritesInterval(uint32_t syncWritesInterval) {
+  this->syncWritesInterval = syncWritesInterval;
+}
+
+void DataBaseConfig::setSyncTimeInterval(uint32_t syncTimeInterval) {
+  this->syncTimeInterval = syncTimeInterval;
+}
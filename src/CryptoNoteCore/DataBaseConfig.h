@@ -38,6 +38,12 @@ public:
   uint64_t getWriteBufferSize() const; //Bytes
   uint64_t getReadCacheSize() const; //Bytes
   bool getTestnet() const;
+  bool getBulkSync() const;
+  bool getRawBlocksInStorage() const;
+  uint64_t getObjectCacheSize() const; //Bytes
+  bool getWriteBehind() const;
+  uint32_t getSyncWritesInterval() const;
+  uint32_t getSyncTimeInterval() const; //Seconds
 
   void setConfigFolderDefaulted(bool defaulted);
   void setDataDir(const std::string& dataDir);
@@ -46,6 +52,12 @@ public:
   void setWriteBufferSize(uint64_t writeBufferSize); //Bytes
   void setReadCacheSize(uint64_t readCacheSize); //Bytes
   void setTestnet(bool testnet);
+  void setBulkSync(bool bulkSync);
+  void setRawBlocksInStorage(bool rawBlocksInStorage);
+  void setObjectCacheSize(uint64_t objectCacheSize); //Bytes
+  void setWriteBehind(bool writeBehind);
+  void setSyncWritesInterval(uint32_t syncWritesInterval);
+  void setSyncTimeInterval(uint32_t syncTimeInterval); //Seconds
 
 private:
   bool configFolderDefaulted;
@@ -55,5 +67,11 @@ private:
   uint64_t writeBufferSize;
   uint64_t readCacheSize;
   bool testnet;
+  bool bulkSync;
+  bool rawBlocksInStorage;
+  uint64_t objectCacheSize;
+  bool writeBehind;
+  uint32_t syncWritesInterval;
+  uint32_t syncTimeInterval;
 };
 } //namespace CryptoNote
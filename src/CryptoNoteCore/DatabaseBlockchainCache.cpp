@@ -31,6 +31,7 @@
 #include <CryptoNoteCore/BlockchainStorage.h>
 #include <CryptoNoteCore/CryptoNoteTools.h>
 #include <CryptoNoteCore/CryptoNoteBasicImpl.h>
+#include <CryptoNoteCore/DatabaseBlockchainCacheOverlay.h>
 #include "CryptoNoteCore/TransactionExtra.h"
 
 namespace CryptoNote {
@@ -192,7 +193,7 @@ std::pair<boost::optional<uint32_t>, bool> requestClosestBlockIndexByTimestamp(u
   return result;
 }
 
-bool requestRawBlock(IDataBase& database, uint32_t blockIndex, RawBlock& block) {
+bool requestDatabaseRawBlock(IDataBase& database, uint32_t blockIndex, RawBlock& block) {
   auto batch = BlockchainReadBatch().requestRawBlock(blockIndex);
 
   auto error = database.read(batch);
@@ -228,41 +229,6 @@ Transaction extractTransaction(const RawBlock& block, uint32_t transactionIndex)
   return blockTemplate.baseTransaction;
 }
 
-size_t requestPaymentIdTransactionsCount(IDataBase& database, const Crypto::Hash& paymentId) {
-  auto batch = BlockchainReadBatch().requestTransactionCountByPaymentId(paymentId);
-  auto error = database.read(batch);
-  if (error) {
-    throw std::system_error(error, "Error while reading transactions count by payment id");
-  }
-
-  auto result = batch.extractResult();
-  if (result.getTransactionCountByPaymentIds().count(paymentId) == 0) {
-    return 0;
-  }
-
-  return result.getTransactionCountByPaymentIds().at(paymentId);
-}
-
-bool requestPaymentId(IDataBase& database, const Crypto::Hash& transactionHash, Crypto::Hash& paymentId) {
-  std::vector<CachedTransactionInfo> cachedTransactions;
-
-  if (!requestCachedTransactionInfos({transactionHash}, database, cachedTransactions)) {
-    return false;
-  }
-
-  if (cachedTransactions.empty()) {
-    return false;
-  }
-
-  RawBlock block;
-  if (!requestRawBlock(database, cachedTransactions[0].blockIndex, block)) {
-    return false;
-  }
-
-  Transaction transaction = extractTransaction(block, cachedTransactions[0].transactionIndex);
-  return getPaymentIdFromTxExtra(transaction.extra, paymentId);
-}
-
 uint32_t requestKeyOutputGlobalIndexesCountForAmount(IBlockchainCache::Amount amount, IDataBase& database) {
   auto batch = BlockchainReadBatch().requestKeyOutputGlobalIndexesCountForAmount(amount);
   auto dbError = database.read(batch);
@@ -420,16 +386,169 @@ private:
 
 const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
 
+// present if raw blocks are kept in the main chain storage only
+const std::string RAW_BLOCKS_IN_STORAGE_KEY = "raw_blocks_in_storage";
+const uint32_t RAW_BLOCKS_MOVE_BATCH_SIZE = 10000;
+
+// raw blocks with indexes below the value are stored without transactions
+const std::string PRUNED_BLOCK_COUNT_KEY = "pruned_block_count";
+const uint32_t PRUNE_BATCH_SIZE = 1000;
+
+const size_t MIN_SPENT_KEY_IMAGE_FILTER_CAPACITY = 1 << 20;
+const uint32_t SPENT_KEY_IMAGE_FILTER_BUILD_BATCH_SIZE = 1000;
+const uint64_t SPENT_KEY_IMAGE_FILTER_REPORT_INTERVAL = 1 << 20;
+
+// hash table or tree node and its bucket
+const size_t CONTAINER_NODE_OVERHEAD = 4 * sizeof(void*);
+
+size_t getTransactionInfoDynamicSize(const ExtendedTransactionInfo& transaction) {
+  size_t size = transaction.outputs.capacity() * sizeof(TransactionOutputTarget) + transaction.globalIndexes.capacity() * sizeof(uint32_t);
+  for (const auto& amountIndexes: transaction.amountToKeyIndexes) {
+    size += CONTAINER_NODE_OVERHEAD + sizeof(amountIndexes) + amountIndexes.second.capacity() * sizeof(IBlockchainCache::GlobalOutputIndex);
+  }
+
+  return size;
+}
+
+const uint32_t KEY_OUTPUT_TABLE_FLUSH_INTERVAL = 1000;
+const uint32_t KEY_OUTPUT_TABLE_SYNC_REPORT_INTERVAL = 10000;
+
+void appendKeyOutputTableEntries(const Transaction& transaction, uint32_t blockIndex, uint16_t transactionIndex,
+                                 std::vector<KeyOutputTableEntry>& entries) {
+  for (size_t outputIndex = 0; outputIndex < transaction.outputs.size(); ++outputIndex) {
+    const auto& output = transaction.outputs[outputIndex];
+    if (output.target.type() != typeid(KeyOutput)) {
+      continue;
+    }
+
+    KeyOutputTableEntry entry;
+    entry.amount = output.amount;
+    entry.publicKey = boost::get<KeyOutput>(output.target).key;
+    entry.location.blockIndex = blockIndex;
+    entry.location.transactionIndex = transactionIndex;
+    entry.location.outputIndex = static_cast<uint16_t>(outputIndex);
+    entry.unlockTime = transaction.unlockTime;
+    entries.push_back(entry);
+  }
+}
+
+class RawBlocksInStorageReadBatch: public IReadBatch {
+public:
+  virtual ~RawBlocksInStorageReadBatch() {}
+
+  virtual std::vector<std::string> getRawKeys() const override {
+    return {RAW_BLOCKS_IN_STORAGE_KEY};
+  }
+
+  virtual void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override {
+    assert(values.size() == 1);
+    assert(resultStates.size() == values.size());
+
+    rawBlocksInStorage = resultStates[0];
+  }
+
+  bool getRawBlocksInStorage() const {
+    return rawBlocksInStorage;
+  }
+
+private:
+  bool rawBlocksInStorage = false;
+};
+
+class RawBlocksInStorageWriteBatch: public IWriteBatch {
+public:
+  virtual ~RawBlocksInStorageWriteBatch() {}
+
+  virtual std::vector<std::pair<std::string, std::string> > extractRawDataToInsert() override {
+    return {make_pair(RAW_BLOCKS_IN_STORAGE_KEY, std::string("1"))};
+  }
+
+  virtual std::vector<std::string> extractRawKeysToRemove() override {
+    return {};
+  }
+};
+
+bool requestRawBlocksInStorage(IDataBase& database) {
+  RawBlocksInStorageReadBatch readBatch;
+  auto ec = database.read(readBatch);
+  if (ec) {
+    throw std::system_error(ec);
+  }
+
+  return readBatch.getRawBlocksInStorage();
 }
 
-struct DatabaseBlockchainCache::ExtendedPushedBlockInfo {
-  PushedBlockInfo pushedBlockInfo;
-  uint64_t timestamp;
+class PrunedBlockCountReadBatch: public IReadBatch {
+public:
+  virtual ~PrunedBlockCountReadBatch() {}
+
+  virtual std::vector<std::string> getRawKeys() const override {
+    return {PRUNED_BLOCK_COUNT_KEY};
+  }
+
+  virtual void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override {
+    assert(values.size() == 1);
+    assert(resultStates.size() == values.size());
+
+    if (resultStates[0]) {
+      prunedBlockCount = static_cast<uint32_t>(std::stoul(values[0]));
+    }
+  }
+
+  uint32_t getPrunedBlockCount() const {
+    return prunedBlockCount;
+  }
+
+private:
+  uint32_t prunedBlockCount = 0;
+};
+
+// header-only raw blocks are written together with the pruned block count covering them
+class PrunedBlocksWriteBatch: public IWriteBatch {
+public:
+  explicit PrunedBlocksWriteBatch(uint32_t prunedBlockCount): prunedBlockCount(prunedBlockCount) {}
+  virtual ~PrunedBlocksWriteBatch() {}
+
+  BlockchainWriteBatch& getRawBlocksBatch() {
+    return rawBlocksBatch;
+  }
+
+  virtual std::vector<std::pair<std::string, std::string> > extractRawDataToInsert() override {
+    auto rawData = rawBlocksBatch.extractRawDataToInsert();
+    rawData.emplace_back(PRUNED_BLOCK_COUNT_KEY, std::to_string(prunedBlockCount));
+    return rawData;
+  }
+
+  virtual std::vector<std::string> extractRawKeysToRemove() override {
+    return rawBlocksBatch.extractRawKeysToRemove();
+  }
+
+private:
+  uint32_t prunedBlockCount;
+  BlockchainWriteBatch rawBlocksBatch;
 };
 
+uint32_t requestPrunedBlockCount(IDataBase& database) {
+  PrunedBlockCountReadBatch readBatch;
+  auto ec = database.read(readBatch);
+  if (ec) {
+    throw std::system_error(ec);
+  }
+
+  return readBatch.getPrunedBlockCount();
+}
+
+}
+
 
-DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger)
-    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache") {
+DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger,
+                                                 uint32_t bulkWriteEndIndex, const IMainChainStorage* rawBlocksStorage,
+                                                 const std::string& keyOutputTableFilename, uint64_t objectCacheSize)
+    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache"),
+      bulkWriteEndIndex(bulkWriteEndIndex), bulkWriteActive(false), rawBlocksStorage(rawBlocksStorage), prunedBlockCount(0), difficultyCache(curr),
+      blockInfoCache(static_cast<size_t>(objectCacheSize / 4)),
+      transactionCache(static_cast<size_t>(objectCacheSize / 2), getTransactionInfoDynamicSize),
+      keyOutputCache(static_cast<size_t>(objectCacheSize / 4)) {
   DatabaseVersionReadBatch readBatch;
   auto ec = database.read(readBatch);
   if (ec) {
@@ -449,13 +568,29 @@ DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase
     logger(Logging::DEBUGGING) << "Current db scheme version: " << *version;
   }
 
-  if (getTopBlockIndex() == 0) {
+  prunedBlockCount = requestPrunedBlockCount(database);
+  if (rawBlocksStorage != nullptr && !requestRawBlocksInStorage(database)) {
+    moveRawBlocksToStorage();
+  }
+
+  if (getDatabaseTopBlockIndex() == 0) {
     logger(Logging::DEBUGGING) << "top block index is nill, add genesis block";
     addGenesisBlock(CachedBlock (currency.genesisBlock()));
   }
+
+  // most transactions have a couple of inputs, the filter is resized if there are more key images
+  rebuildSpentKeyImageFilter(std::max<size_t>(MIN_SPENT_KEY_IMAGE_FILTER_CAPACITY, getCachedTransactionsCount() * 2));
+  if (spentKeyImageFilter.getCount() > spentKeyImageFilter.getCapacity()) {
+    rebuildSpentKeyImageFilter(spentKeyImageFilter.getCount() * 2);
+  }
+
+  if (!keyOutputTableFilename.empty()) {
+    keyOutputTable.reset(new KeyOutputTable(keyOutputTableFilename));
+    syncKeyOutputTable();
+  }
 }
 
-bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging::ILogger& _logger) {
+bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging::ILogger& _logger, bool rawBlocksInStorage) {
   Logging::LoggerRef logger(_logger, "DatabaseBlockchainCache");
 
   DatabaseVersionReadBatch readBatch;
@@ -474,11 +609,125 @@ bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging:
   } else if (*version > CURRENT_DB_SCHEME_VERSION) {
     logger(Logging::ERROR) << "DB scheme version is greater than expected. Expected version " << CURRENT_DB_SCHEME_VERSION << ". Actual version " << *version << ". Please update your software.";
     throw std::runtime_error("DB scheme version is greater than expected");
+  } else if (!rawBlocksInStorage && requestRawBlocksInStorage(database)) {
+    logger(Logging::WARNING) << "DB doesn't contain raw blocks, they are kept in blockchain storage only. DB will be destroyed and recreated from blocks.bin file.";
+    return false;
   } else {
     return true;
   }
 }
 
+void DatabaseBlockchainCache::moveRawBlocksToStorage() {
+  assert(rawBlocksStorage != nullptr);
+
+  // blocks missing in the storage are kept, Core cuts them off on load. Headers of pruned blocks are kept too
+  uint32_t blockCount = std::min(getDatabaseTopBlockIndex() + 1, rawBlocksStorage->getBlockCount());
+  logger(Logging::INFO) << "Removing raw blocks " << prunedBlockCount << " - " << blockCount << " from DB, they are kept in blockchain storage";
+
+  for (uint32_t batchStart = prunedBlockCount; batchStart < blockCount; batchStart += RAW_BLOCKS_MOVE_BATCH_SIZE) {
+    BlockchainWriteBatch writeBatch;
+    for (uint32_t blockIndex = batchStart; blockIndex < std::min(batchStart + RAW_BLOCKS_MOVE_BATCH_SIZE, blockCount); ++blockIndex) {
+      writeBatch.removeRawBlock(blockIndex);
+    }
+
+    auto error = database.write(writeBatch);
+    if (error) {
+      logger(Logging::ERROR) << "Failed to remove raw blocks from DB: " << error.message();
+      throw std::system_error(error);
+    }
+  }
+
+  RawBlocksInStorageWriteBatch writeBatch;
+  auto error = database.write(writeBatch);
+  if (error) {
+    throw std::system_error(error);
+  }
+}
+
+void DatabaseBlockchainCache::rebuildSpentKeyImageFilter(size_t capacity) {
+  logger(Logging::INFO) << "Building spent key image filter for " << capacity << " key images";
+
+  spentKeyImageFilter.reset(capacity);
+
+  uint32_t blockCount = getDatabaseTopBlockIndex() + 1;
+  for (uint32_t batchStart = 0; batchStart < blockCount; batchStart += SPENT_KEY_IMAGE_FILTER_BUILD_BATCH_SIZE) {
+    BlockchainReadBatch batch;
+    for (uint32_t blockIndex = batchStart; blockIndex < std::min(batchStart + SPENT_KEY_IMAGE_FILTER_BUILD_BATCH_SIZE, blockCount); ++blockIndex) {
+      batch.requestSpentKeyImagesByBlock(blockIndex);
+    }
+
+    auto result = readDatabase(batch);
+    for (const auto& blockKeyImages: result.getSpentKeyImagesByBlock()) {
+      for (const auto& keyImage: blockKeyImages.second) {
+        spentKeyImageFilter.add(keyImage);
+      }
+    }
+  }
+
+  logger(Logging::INFO) << "Spent key image filter contains " << spentKeyImageFilter.getCount() << " key images";
+}
+
+// headers of pruned blocks are written to DB before the storage drops these blocks
+bool DatabaseBlockchainCache::isRawBlockInStorage(uint32_t blockIndex) const {
+  return rawBlocksStorage != nullptr && blockIndex >= prunedBlockCount && blockIndex < rawBlocksStorage->getBlockCount();
+}
+
+bool DatabaseBlockchainCache::requestVerifiedRawBlock(uint32_t blockIndex, const Crypto::Hash& blockHash, RawBlock& block) const {
+  // storage may contain another chain until Core::load recovers consistency
+  if (isRawBlockInStorage(blockIndex)) {
+    block = rawBlocksStorage->getBlockByIndex(blockIndex);
+
+    BlockTemplate blockTemplate;
+    if (fromBinaryArray(blockTemplate, block.block) && CachedBlock(blockTemplate).getBlockHash() == blockHash) {
+      return true;
+    }
+  }
+
+  return requestDatabaseRawBlock(database, blockIndex, block);
+}
+
+// table may be behind data base if it wasn't flushed or was created for existing data base, missing blocks are taken
+// from raw blocks. If some of them can't be read, table stays behind and key outputs are read from data base
+void DatabaseBlockchainCache::syncKeyOutputTable() {
+  uint32_t blockCount = getDatabaseTopBlockIndex() + 1;
+  keyOutputTable->truncate(blockCount);
+
+  if (keyOutputTable->getBlockCount() < blockCount) {
+    logger(Logging::INFO) << "Adding blocks from " << keyOutputTable->getBlockCount() << " to " << blockCount - 1 << " to key output table";
+  }
+
+  while (keyOutputTable->getBlockCount() < blockCount) {
+    uint32_t blockIndex = keyOutputTable->getBlockCount();
+    if (blockIndex < prunedBlockCount) {
+      logger(Logging::WARNING) << "Key output table is behind data base: block " << blockIndex << " is pruned";
+      break;
+    }
+
+    RawBlock rawBlock;
+    if (!requestVerifiedRawBlock(blockIndex, getCachedBlockInfo(blockIndex).blockHash, rawBlock)) {
+      logger(Logging::WARNING) << "Key output table is behind data base: failed to read raw block " << blockIndex;
+      break;
+    }
+
+    std::vector<KeyOutputTableEntry> entries;
+    for (uint32_t transactionIndex = 0; transactionIndex < rawBlock.transactions.size() + 1; ++transactionIndex) {
+      appendKeyOutputTableEntries(extractTransaction(rawBlock, transactionIndex), blockIndex, static_cast<uint16_t>(transactionIndex), entries);
+    }
+
+    keyOutputTable->pushBlock(blockIndex, entries);
+
+    if (blockIndex % KEY_OUTPUT_TABLE_SYNC_REPORT_INTERVAL == 0) {
+      logger(Logging::INFO) << "Key output table contains " << blockIndex + 1 << " blocks of " << blockCount;
+    }
+  }
+
+  keyOutputTable->flush();
+}
+
+bool DatabaseBlockchainCache::isKeyOutputTableActual() const {
+  return keyOutputTable && keyOutputTable->getBlockCount() == getDatabaseTopBlockIndex() + 1;
+}
+
 void DatabaseBlockchainCache::deleteClosestTimestampBlockIndex(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex) {
   auto batch = BlockchainReadBatch().requestCachedBlock(splitBlockIndex);
   auto blockResult = readDatabase(batch);
@@ -511,43 +760,93 @@ void DatabaseBlockchainCache::deleteClosestTimestampBlockIndex(BlockchainWriteBa
 
 /*
  * This methods splits cache, upper part (ie blocks with indexes greater or equal to splitBlockIndex)
- * is copied to new BlockchainCache
+ * stays in data base and is read by the returned overlay segment. Nothing is copied or deleted here,
+ * hidden blocks are deleted with a single write batch once another block is pushed above the split point or on save
  */
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitBlockIndex) {
+  assert(splitBlockIndex > 0);
   assert(splitBlockIndex <= getTopBlockIndex());
+  if (splitBlockIndex < prunedBlockCount) {
+    throw std::runtime_error("Can't split pruned blocks, split index " + std::to_string(splitBlockIndex) +
+                             ", pruned blocks count " + std::to_string(prunedBlockCount));
+  }
+
   logger(Logging::DEBUGGING) << "split at index " << splitBlockIndex << " started, top block index: " << getTopBlockIndex();
 
-  auto cache = blockchainCacheFactory.createBlockchainCache(currency, this, splitBlockIndex);
+  // the main chain storage drops these blocks if another chain becomes the main one
+  std::vector<RawBlock> rawBlocks;
+  if (rawBlocksStorage != nullptr) {
+    for (uint32_t blockIndex = splitBlockIndex; blockIndex <= getTopBlockIndex(); ++blockIndex) {
+      rawBlocks.push_back(getBlockByIndex(blockIndex));
+      addOverlayPaymentIds(blockIndex, rawBlocks.back());
+    }
+  }
 
-  using DeleteBlockInfo = std::tuple<uint32_t, Crypto::Hash, TransactionValidatorState, uint64_t>;
-  std::vector<DeleteBlockInfo> deletingBlocks;
+  std::unique_ptr<DatabaseBlockchainCacheOverlay> cache(new DatabaseBlockchainCacheOverlay(
+    *this, this, splitBlockIndex, getTopBlockIndex(), getTopBlockHash(), std::move(rawBlocks), logger.getLogger()));
 
-  BlockchainWriteBatch writeBatch;
-  auto currentTop = getTopBlockIndex();
-  for (uint32_t blockIndex = splitBlockIndex; blockIndex <= currentTop; ++blockIndex) {
-    ExtendedPushedBlockInfo extendedInfo = getExtendedPushedBlockInfo(blockIndex);
+  for (auto child: children) {
+    child->setParent(cache.get());
+    cache->addChild(child);
+  }
+
+  children.clear();
+  children.push_back(cache.get());
+
+  overlayParentHash = getBlockHash(splitBlockIndex - 1);
+  overlayStartIndex = splitBlockIndex;
+
+  logger(Logging::DEBUGGING) << "split completed";
+  // return new cache
+  return std::move(cache);
+}
 
-    auto validatorState = extendedInfo.pushedBlockInfo.validatorState;
-    logger(Logging::DEBUGGING) << "pushing block " << blockIndex << " to child segment";
-    auto blockHash = pushBlockToAnotherCache(*cache, std::move(extendedInfo.pushedBlockInfo));
+void DatabaseBlockchainCache::truncate(uint32_t startIndex) {
+  assert(startIndex <= getTopBlockIndex());
+  if (startIndex < prunedBlockCount) {
+    throw std::runtime_error("Can't remove pruned blocks, start index " + std::to_string(startIndex) +
+                             ", pruned blocks count " + std::to_string(prunedBlockCount));
+  }
+
+  logger(Logging::DEBUGGING) << "truncate from index " << startIndex << " started, top block index: " << getTopBlockIndex();
+
+  deleteBlocks(startIndex);
 
-    deletingBlocks.emplace_back(blockIndex, blockHash, validatorState, extendedInfo.timestamp);
+  logger(Logging::DEBUGGING) << "truncate completed";
+}
+
+// raw blocks aren't needed here, so blocks may be deleted even if the main chain storage lost them.
+// Key images of deleted blocks stay in the spent key image filter until it is rebuilt, DB is checked for them anyway
+void DatabaseBlockchainCache::deleteBlocks(uint32_t splitBlockIndex) {
+  auto currentTop = getDatabaseTopBlockIndex();
+  assert(splitBlockIndex > 0 && splitBlockIndex <= currentTop);
+
+  BlockchainReadBatch readBatch;
+  for (uint32_t blockIndex = splitBlockIndex; blockIndex <= currentTop; ++blockIndex) {
+    readBatch.requestCachedBlock(blockIndex).requestSpentKeyImagesByBlock(blockIndex);
   }
 
-  for (auto it = deletingBlocks.rbegin(); it != deletingBlocks.rend(); ++it) {
-    auto blockIndex = std::get<0>(*it);
-    auto blockHash = std::get<1>(*it);
-    auto& validatorState = std::get<2>(*it);
-    uint64_t timestamp = std::get<3>(*it);
+  auto blocks = readDatabase(readBatch);
+
+  BlockchainWriteBatch writeBatch;
+  std::unordered_map<uint64_t, std::vector<Crypto::Hash>> blockHashesByTimestamp;
+  for (uint32_t blockIndex = currentTop + 1; blockIndex-- > splitBlockIndex;) {
+    const CachedBlockInfo& blockInfo = blocks.getCachedBlocks().at(blockIndex);
+    const auto& spentKeyImages = blocks.getSpentKeyImagesByBlock().at(blockIndex);
+
+    TransactionValidatorState validatorState;
+    validatorState.spentKeyImages.insert(spentKeyImages.begin(), spentKeyImages.end());
 
-    writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex);
+    writeBatch.removeCachedBlock(blockInfo.blockHash, blockIndex).removeRawBlock(blockIndex);
     requestDeleteSpentOutputs(writeBatch,
                               blockIndex,
                               validatorState);
-    requestRemoveTimestamp(writeBatch, timestamp, blockHash);
+    blockHashesByTimestamp[blockInfo.timestamp].push_back(blockInfo.blockHash);
   }
 
-  auto deletingTransactionHashes = requestTransactionHashesFromBlockIndex(splitBlockIndex);
+  requestRemoveTimestamps(writeBatch, blockHashesByTimestamp);
+
+  auto deletingTransactionHashes = requestTransactionHashes(splitBlockIndex, currentTop + 1);
   requestDeleteTransactions(writeBatch, deletingTransactionHashes);
   requestDeletePaymentIds(writeBatch, deletingTransactionHashes);
 
@@ -568,6 +867,13 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
 
   deleteClosestTimestampBlockIndex(writeBatch, splitBlockIndex);
 
+  if (keyOutputTable) {
+    keyOutputTable->truncate(splitBlockIndex);
+  }
+
+  clearPrefetchedKeyInputs();
+  clearObjectCache();
+
   logger(Logging::DEBUGGING) << "Performing delete operations";
   // all data and indexes are now copied, no errors detected, can now erase data from database
   auto err = database.write(writeBatch);
@@ -577,47 +883,42 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   }
 
   cutTail(unitsCache, currentTop + 1 - splitBlockIndex);
+  difficultyCache.reset();
 
-  children.push_back(cache.get());
   logger(Logging::TRACE) << "Delete successfull";
 
   // invalidate top block index and hash
   topBlockIndex = boost::none;
   topBlockHash = boost::none;
   transactionsCount = boost::none;
+  keyOutputCountLimits.clear();
 
-  logger(Logging::DEBUGGING) << "split completed";
-  // return new cache
-  return cache;
+  overlayPaymentIds.erase(overlayPaymentIds.lower_bound(splitBlockIndex), overlayPaymentIds.end());
+  if (overlayStartIndex && splitBlockIndex <= *overlayStartIndex) {
+    overlayStartIndex = boost::none;
+  }
 }
 
-//returns hash of pushed block
-Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo) {
-  BlockTemplate block;
-  bool br = fromBinaryArray(block, pushedBlockInfo.rawBlock.block);
-  assert(br);
+void DatabaseBlockchainCache::addOverlayPaymentIds(uint32_t blockIndex, const RawBlock& rawBlock) {
+  assert(rawBlocksStorage != nullptr);
 
-  std::vector<CachedTransaction> transactions;
-  bool tr = Utils::restoreCachedTransactions(pushedBlockInfo.rawBlock.transactions, transactions);
-  assert(tr);
-
-  CachedBlock cachedBlock(block);
-  segment.pushBlock(cachedBlock,
-                    transactions,
-                    pushedBlockInfo.validatorState,
-                    pushedBlockInfo.blockSize,
-                    pushedBlockInfo.generatedCoins,
-                    pushedBlockInfo.blockDifficulty,
-                    std::move(pushedBlockInfo.rawBlock));
-
-  return cachedBlock.getBlockHash();
+  auto& paymentIds = overlayPaymentIds[blockIndex];
+  paymentIds.clear();
+  for (uint32_t transactionIndex = 0; transactionIndex < rawBlock.transactions.size() + 1; ++transactionIndex) {
+    Crypto::Hash paymentId;
+    if (getPaymentIdFromTxExtra(extractTransaction(rawBlock, transactionIndex).extra, paymentId)) {
+      paymentIds.push_back(paymentId);
+    }
+  }
 }
 
-std::vector<Crypto::Hash> DatabaseBlockchainCache::requestTransactionHashesFromBlockIndex(uint32_t splitBlockIndex) {
-  logger(Logging::DEBUGGING) << "Requesting transaction hashes starting from block index " << splitBlockIndex;
+// hashes of blocks [startIndex, endIndex), base transaction is the first one of each block
+std::vector<Crypto::Hash> DatabaseBlockchainCache::requestTransactionHashes(uint32_t startIndex, uint32_t endIndex,
+                                                                            bool withBaseTransactions) const {
+  logger(Logging::DEBUGGING) << "Requesting transaction hashes of blocks " << startIndex << " - " << endIndex - 1;
 
   BlockchainReadBatch readBatch;
-  for (uint32_t blockIndex = splitBlockIndex; blockIndex <= getTopBlockIndex(); ++blockIndex) {
+  for (uint32_t blockIndex = startIndex; blockIndex < endIndex; ++blockIndex) {
     readBatch.requestTransactionHashesByBlock(blockIndex);
   }
 
@@ -625,9 +926,12 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::requestTransactionHashesFromB
 
   auto dbResult = readDatabase(readBatch);
   for (const auto& kv: dbResult.getTransactionHashesByBlocks()) {
-    for (const auto& hash: kv.second) {
-      transactionHashes.emplace_back(hash);
+    auto begin = kv.second.begin();
+    if (!withBaseTransactions && begin != kv.second.end()) {
+      ++begin;
     }
+
+    transactionHashes.insert(transactionHashes.end(), begin, kv.second.end());
   }
 
   return transactionHashes;
@@ -642,29 +946,70 @@ void DatabaseBlockchainCache::requestDeleteTransactions(BlockchainWriteBatch& wr
 }
 
 void DatabaseBlockchainCache::requestDeletePaymentIds(BlockchainWriteBatch& writeBatch, const std::vector<Crypto::Hash>& transactionHashes) {
+  std::vector<CachedTransactionInfo> cachedTransactions;
+  if (!requestCachedTransactionInfos(transactionHashes, database, cachedTransactions)) {
+    logger(Logging::ERROR) << "Failed to request cached transactions while deleting payment ids";
+    throw std::runtime_error("failed to request cached transactions");
+  }
+
   std::unordered_map<Crypto::Hash, size_t> paymentCounts;
 
-  for (const auto& hash: transactionHashes) {
-    Crypto::Hash paymentId;
-    if (!requestPaymentId(database, hash, paymentId)) {
+  // transactions of a block go one after another, so each raw block is read once
+  boost::optional<uint32_t> blockIndex;
+  RawBlock block;
+  bool blockFound = false;
+  for (const auto& transactionInfo: cachedTransactions) {
+    if (!blockIndex || *blockIndex != transactionInfo.blockIndex) {
+      blockIndex = transactionInfo.blockIndex;
+
+      // storage may hold another chain already, payment ids were taken while it held this block
+      auto overlayIt = overlayPaymentIds.find(*blockIndex);
+      if (overlayIt != overlayPaymentIds.end()) {
+        for (const auto& paymentId: overlayIt->second) {
+          paymentCounts[paymentId] += 1;
+        }
+
+        blockFound = false;
+        continue;
+      }
+
+      blockFound = requestVerifiedRawBlock(*blockIndex, getCachedBlockInfo(*blockIndex).blockHash, block);
+      if (!blockFound) {
+        logger(Logging::WARNING) << "Raw block " << *blockIndex << " is lost, payment ids of its transactions remain in DB";
+      }
+    }
+
+    if (!blockFound) {
       continue;
     }
 
-    paymentCounts[paymentId] += 1;
+    Crypto::Hash paymentId;
+    Transaction transaction = extractTransaction(block, transactionInfo.transactionIndex);
+    if (getPaymentIdFromTxExtra(transaction.extra, paymentId)) {
+      paymentCounts[paymentId] += 1;
+    }
+  }
+
+  if (paymentCounts.empty()) {
+    return;
   }
 
+  BlockchainReadBatch readBatch;
   for (const auto& kv: paymentCounts) {
-    requestDeletePaymentId(writeBatch, kv.first, kv.second);
+    readBatch.requestTransactionCountByPaymentId(kv.first);
   }
-}
 
-void DatabaseBlockchainCache::requestDeletePaymentId(BlockchainWriteBatch& writeBatch, const Crypto::Hash& paymentId, size_t toDelete) {
-  size_t count = requestPaymentIdTransactionsCount(database, paymentId);
-  assert(count > 0);
-  assert(count >= toDelete);
+  auto result = readDatabase(readBatch);
+  const auto& counts = result.getTransactionCountByPaymentIds();
+  for (const auto& kv: paymentCounts) {
+    auto countIt = counts.find(kv.first);
+    size_t count = countIt == counts.end() ? 0 : countIt->second;
+    assert(count > 0);
+    assert(count >= kv.second);
 
-  logger(Logging::DEBUGGING) << "Deleting last " << toDelete << " transaction hashes of payment id " << paymentId;
-  writeBatch.removePaymentId(paymentId, static_cast<uint32_t>(count - toDelete));
+    logger(Logging::DEBUGGING) << "Deleting last " << kv.second << " transaction hashes of payment id " << kv.first;
+    writeBatch.removePaymentId(kv.first, static_cast<uint32_t>(count - kv.second));
+  }
 }
 
 void DatabaseBlockchainCache::requestDeleteSpentOutputs(BlockchainWriteBatch& writeBatch, uint32_t blockIndex, const TransactionValidatorState& spentOutputs) {
@@ -710,24 +1055,40 @@ void DatabaseBlockchainCache::requestDeleteKeyOutputsAmount(BlockchainWriteBatch
   updateKeyOutputCount(amount, boundary - outputsCount);
 }
 
-void DatabaseBlockchainCache::requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash) {
-  auto readBatch = BlockchainReadBatch().requestBlockHashesByTimestamp(timestamp);
-  auto result = readDatabase(readBatch);
-
-  if (result.getBlockHashesByTimestamp().count(timestamp) == 0) {
+// blocks with the same timestamp are removed from its list together, otherwise the last written list would restore the others
+void DatabaseBlockchainCache::requestRemoveTimestamps(BlockchainWriteBatch& batch,
+                                                      const std::unordered_map<uint64_t, std::vector<Crypto::Hash>>& blockHashesByTimestamp) {
+  if (blockHashesByTimestamp.empty()) {
     return;
   }
 
-  auto indexes = result.getBlockHashesByTimestamp().at(timestamp);
-  auto it = std::find(indexes.begin(), indexes.end(), blockHash);
-  indexes.erase(it);
+  BlockchainReadBatch readBatch;
+  for (const auto& kv: blockHashesByTimestamp) {
+    readBatch.requestBlockHashesByTimestamp(kv.first);
+  }
 
-  if (indexes.empty()) {
-    logger(Logging::DEBUGGING) << "Deleting timestamp " << timestamp;
-    batch.removeTimestamp(timestamp);
-  } else {
-    logger(Logging::DEBUGGING) << "Deleting block hash " << blockHash << " from timestamp " << timestamp;
-    batch.insertTimestamp(timestamp, indexes);
+  auto result = readDatabase(readBatch);
+  for (const auto& kv: blockHashesByTimestamp) {
+    auto timestampIt = result.getBlockHashesByTimestamp().find(kv.first);
+    if (timestampIt == result.getBlockHashesByTimestamp().end()) {
+      continue;
+    }
+
+    auto hashes = timestampIt->second;
+    for (const auto& blockHash: kv.second) {
+      auto it = std::find(hashes.begin(), hashes.end(), blockHash);
+      if (it != hashes.end()) {
+        hashes.erase(it);
+      }
+    }
+
+    if (hashes.empty()) {
+      logger(Logging::DEBUGGING) << "Deleting timestamp " << kv.first;
+      batch.removeTimestamp(kv.first);
+    } else {
+      logger(Logging::DEBUGGING) << "Deleting " << kv.second.size() << " block hashes from timestamp " << kv.first;
+      batch.insertTimestamp(kv.first, hashes);
+    }
   }
 }
 
@@ -869,12 +1230,41 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
                                         const std::vector<CachedTransaction>& cachedTransactions,
                                         const TransactionValidatorState& validatorState, size_t blockSize,
                                         uint64_t generatedCoins, Difficulty blockDifficulty, RawBlock&& rawBlock) {
+  if (overlayStartIndex) {
+    // overlay segment is merged back, its block is already in data base
+    if (getBlockHash(*overlayStartIndex) == cachedBlock.getBlockHash()) {
+      logger(Logging::DEBUGGING) << "push block with hash " << cachedBlock.getBlockHash() << " found in data base";
+      overlayParentHash = cachedBlock.getBlockHash();
+      overlayPaymentIds.erase(*overlayStartIndex);
+      overlayStartIndex = *overlayStartIndex + 1;
+      if (*overlayStartIndex > getDatabaseTopBlockIndex()) {
+        overlayStartIndex = boost::none;
+      }
+
+      return;
+    }
+
+    deleteBlocks(*overlayStartIndex);
+  }
+
+  // the block index is its locator in the main chain storage
+  assert(rawBlocksStorage == nullptr || rawBlocksStorage->getBlockCount() > getDatabaseTopBlockIndex() + 1);
+  pushDatabaseBlock(cachedBlock, cachedTransactions, validatorState, blockSize, generatedCoins, blockDifficulty, std::move(rawBlock));
+}
+
+// overlay segments push their blocks here too, raw blocks of the main chain storage are not checked then
+void DatabaseBlockchainCache::pushDatabaseBlock(const CachedBlock& cachedBlock,
+                                                const std::vector<CachedTransaction>& cachedTransactions,
+                                                const TransactionValidatorState& validatorState, size_t blockSize,
+                                                uint64_t generatedCoins, Difficulty blockDifficulty, RawBlock&& rawBlock) {
   BlockchainWriteBatch batch;
   logger(Logging::DEBUGGING) << "push block with hash " << cachedBlock.getBlockHash() << ", and "
                              << cachedTransactions.size() + 1 << " transactions"; //+1 for base transaction
 
+  updateBulkWriteMode(getDatabaseTopBlockIndex() + 1);
+
   // TODO: cache top block difficulty, size, timestamp, coins; use it here
-  auto lastBlockInfo = getCachedBlockInfo(getTopBlockIndex());
+  auto lastBlockInfo = getCachedBlockInfo(getDatabaseTopBlockIndex());
   auto cumulativeDifficulty = lastBlockInfo.cumulativeDifficulty + blockDifficulty;
   auto alreadyGeneratedCoins = lastBlockInfo.alreadyGeneratedCoins + generatedCoins;
   auto alreadyGeneratedTransactions = lastBlockInfo.alreadyGeneratedTransactions + cachedTransactions.size() + 1;
@@ -887,7 +1277,7 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   blockInfo.blockSize = static_cast<uint32_t>(blockSize);
   blockInfo.timestamp = cachedBlock.getBlock().timestamp;
 
-  batch.insertSpentKeyImages(getTopBlockIndex() + 1, validatorState.spentKeyImages);
+  batch.insertSpentKeyImages(getDatabaseTopBlockIndex() + 1, validatorState.spentKeyImages);
 
   auto txHashes = cachedBlock.getBlock().transactionHashes;
   auto baseTransaction = cachedBlock.getBlock().baseTransaction;
@@ -896,14 +1286,16 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   // base transaction's hash is always the first one in index for this block
   txHashes.insert(txHashes.begin(), cachedBaseTransaction.getTransactionHash());
 
-  batch.insertCachedBlock(blockInfo, getTopBlockIndex() + 1, txHashes);
-  batch.insertRawBlock(getTopBlockIndex() + 1, std::move(rawBlock));
+  batch.insertCachedBlock(blockInfo, getDatabaseTopBlockIndex() + 1, txHashes);
+  if (rawBlocksStorage == nullptr) {
+    batch.insertRawBlock(getDatabaseTopBlockIndex() + 1, std::move(rawBlock));
+  }
 
   auto transactionIndex = 0;
-  pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+  pushTransaction(cachedBaseTransaction, getDatabaseTopBlockIndex() + 1, transactionIndex++, batch);
 
   for (const auto& transaction: cachedTransactions) {
-    pushTransaction(transaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+    pushTransaction(transaction, getDatabaseTopBlockIndex() + 1, transactionIndex++, batch);
   }
 
   auto closestBlockIndexDb = requestClosestBlockIndexByTimestamp(roundToMidnight(cachedBlock.getBlock().timestamp), database);
@@ -913,7 +1305,7 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   }
 
   if (!closestBlockIndexDb.first) {
-    batch.insertClosestTimestampBlockIndex(roundToMidnight(cachedBlock.getBlock().timestamp), getTopBlockIndex() + 1);
+    batch.insertClosestTimestampBlockIndex(roundToMidnight(cachedBlock.getBlock().timestamp), getDatabaseTopBlockIndex() + 1);
   }
 
   insertBlockTimestamp(batch, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
@@ -928,10 +1320,54 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   topBlockHash = cachedBlock.getBlockHash();
   logger(Logging::DEBUGGING) << "push block " << cachedBlock.getBlockHash() << " completed";
 
+  clearPrefetchedKeyInputs();
+
+  for (const auto& keyImage: validatorState.spentKeyImages) {
+    spentKeyImageFilter.add(keyImage);
+  }
+
+  if (spentKeyImageFilter.getCount() > spentKeyImageFilter.getCapacity()) {
+    rebuildSpentKeyImageFilter(spentKeyImageFilter.getCount() * 2);
+  }
+
+  // table that fell behind isn't updated, it is synchronized on the next start
+  if (keyOutputTable && keyOutputTable->getBlockCount() == *topBlockIndex) {
+    std::vector<KeyOutputTableEntry> entries;
+    appendKeyOutputTableEntries(cachedBaseTransaction.getTransaction(), *topBlockIndex, 0, entries);
+    for (size_t i = 0; i < cachedTransactions.size(); ++i) {
+      appendKeyOutputTableEntries(cachedTransactions[i].getTransaction(), *topBlockIndex, static_cast<uint16_t>(i + 1), entries);
+    }
+
+    keyOutputTable->pushBlock(*topBlockIndex, entries);
+    if (*topBlockIndex % KEY_OUTPUT_TABLE_FLUSH_INTERVAL == 0) {
+      keyOutputTable->flush();
+    }
+  }
+
   unitsCache.push_back(blockInfo);
   if (unitsCache.size() > unitsCacheSize) {
     unitsCache.pop_front();
   }
+
+  difficultyCache.push(*topBlockIndex, blockInfo.timestamp, blockInfo.cumulativeDifficulty);
+}
+
+void DatabaseBlockchainCache::updateBulkWriteMode(uint32_t blockIndex) {
+  // blocks inside the checkpoint zone are never reorganized, so after a crash in the middle of a bulk write
+  // the data base is recreated and the blocks are imported again from the blockchain storage on the next start
+  if (blockIndex < bulkWriteEndIndex) {
+    if (!bulkWriteActive) {
+      database.beginBulkWrite();
+      bulkWriteActive = true;
+    }
+  } else if (bulkWriteActive) {
+    bulkWriteActive = false;
+    auto error = database.endBulkWrite();
+    if (error) {
+      logger(Logging::ERROR) << "finishing bulk write failed: " << error.message();
+      throw std::runtime_error(error.message());
+    }
+  }
 }
 
 PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const {
@@ -939,6 +1375,34 @@ PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex)
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const {
+  return checkIfSpent(keyImage, blockIndex, getTopBlockIndex());
+}
+
+bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex, uint32_t topIndex) const {
+  // key images spent above the top belong to another segment
+  blockIndex = std::min(blockIndex, topIndex);
+
+  if (++spentKeyImageFilterStatistics.lookups % SPENT_KEY_IMAGE_FILTER_REPORT_INTERVAL == 0) {
+    logger(Logging::DEBUGGING) << "Spent key image filter: " << spentKeyImageFilterStatistics.lookups << " lookups, "
+                               << spentKeyImageFilterStatistics.filteredOut << " answered without DB, false positive rate "
+                               << spentKeyImageFilterStatistics.getFalsePositiveRate();
+  }
+
+  if (!spentKeyImageFilter.mayContain(keyImage)) {
+    ++spentKeyImageFilterStatistics.filteredOut;
+    return false;
+  }
+
+  auto prefetched = prefetchedSpentKeyImages.find(keyImage);
+  if (prefetched != prefetchedSpentKeyImages.end()) {
+    if (prefetched->second == INVALID_BLOCK_INDEX) {
+      ++spentKeyImageFilterStatistics.falsePositives;
+      return false;
+    }
+
+    return prefetched->second <= blockIndex;
+  }
+
   auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
   auto res = database.read(batch);
   if (res) {
@@ -948,8 +1412,125 @@ bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uin
 
   auto readResult = batch.extractResult();
   auto it = readResult.getBlockIndexesBySpentKeyImages().find(keyImage);
+  if (it == readResult.getBlockIndexesBySpentKeyImages().end()) {
+    ++spentKeyImageFilterStatistics.falsePositives;
+    return false;
+  }
+
+  return it->second <= blockIndex;
+}
+
+void DatabaseBlockchainCache::prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const {
+  prefetchedSpentKeyImages.clear();
+  prefetchedKeyOutputs.clear();
+
+  // the table answers key output requests without data base reads anyway
+  bool requestKeyOutputs = !isKeyOutputTableActual();
+
+  BlockchainReadBatch batch;
+  std::vector<Crypto::KeyImage> keyImages;
+  std::vector<std::pair<Amount, GlobalOutputIndex>> keyOutputs;
+  for (const KeyInput* input: inputs) {
+    if (spentKeyImageFilter.mayContain(input->keyImage)) {
+      batch.requestBlockIndexBySpentKeyImage(input->keyImage);
+      keyImages.push_back(input->keyImage);
+    }
 
-  return it != readResult.getBlockIndexesBySpentKeyImages().end() && it->second <= blockIndex;
+    if (requestKeyOutputs) {
+      GlobalOutputIndex globalIndex = 0;
+      for (auto offset: input->outputIndexes) {
+        globalIndex += offset;
+        batch.requestKeyOutputInfo(input->amount, globalIndex);
+        keyOutputs.emplace_back(input->amount, globalIndex);
+      }
+    }
+  }
+
+  if (keyImages.empty() && keyOutputs.empty()) {
+    return;
+  }
+
+  auto error = database.read(batch);
+  if (error) {
+    logger(Logging::WARNING) << "Failed to prefetch key inputs, they will be read one by one: " << error.message();
+    return;
+  }
+
+  auto result = batch.extractResult();
+  const auto& spentBlockIndexes = result.getBlockIndexesBySpentKeyImages();
+  for (const auto& keyImage: keyImages) {
+    auto it = spentBlockIndexes.find(keyImage);
+    prefetchedSpentKeyImages[keyImage] = it == spentBlockIndexes.end() ? INVALID_BLOCK_INDEX : it->second;
+  }
+
+  const auto& keyOutputInfos = result.getKeyOutputInfo();
+  for (const auto& keyOutput: keyOutputs) {
+    auto it = keyOutputInfos.find(keyOutput);
+    prefetchedKeyOutputs[keyOutput] = it == keyOutputInfos.end() ? boost::optional<KeyOutputInfo>() : it->second;
+  }
+
+  logger(Logging::TRACE) << "Prefetched " << keyImages.size() << " key images and " << keyOutputs.size() << " key outputs for " << inputs.size() << " inputs";
+}
+
+void DatabaseBlockchainCache::clearPrefetchedKeyInputs() {
+  prefetchedSpentKeyImages.clear();
+  prefetchedKeyOutputs.clear();
+}
+
+const KeyImageFilterStatistics& DatabaseBlockchainCache::getSpentKeyImageFilterStatistics() const {
+  return spentKeyImageFilterStatistics;
+}
+
+DatabaseBlockchainCache::ObjectCacheStatistics DatabaseBlockchainCache::getObjectCacheStatistics() const {
+  return { blockInfoCache.getStatistics(), transactionCache.getStatistics(), keyOutputCache.getStatistics() };
+}
+
+void DatabaseBlockchainCache::clearObjectCache() {
+  blockInfoCache.clear();
+  transactionCache.clear();
+  keyOutputCache.clear();
+}
+
+bool DatabaseBlockchainCache::requestTransactionInfos(const std::vector<Crypto::Hash>& transactionHashes,
+                                                      std::unordered_map<Crypto::Hash, ExtendedTransactionInfo>& transactions,
+                                                      uint32_t startIndex, uint32_t topIndex) const {
+  auto inRange = [startIndex, topIndex] (const ExtendedTransactionInfo& transaction) {
+    return transaction.blockIndex >= startIndex && transaction.blockIndex <= topIndex;
+  };
+
+  BlockchainReadBatch batch;
+  bool batchEmpty = true;
+  for (const auto& hash: transactionHashes) {
+    const ExtendedTransactionInfo* cached = transactionCache.find(hash);
+    if (cached != nullptr) {
+      if (inRange(*cached)) {
+        transactions.emplace(hash, *cached);
+      }
+    } else {
+      batch.requestCachedTransaction(hash);
+      batchEmpty = false;
+    }
+  }
+
+  if (batchEmpty) {
+    return true;
+  }
+
+  auto error = database.read(batch);
+  if (error) {
+    logger(Logging::ERROR) << "failed to read transactions from database, error is " << error.message();
+    return false;
+  }
+
+  auto result = batch.extractResult();
+  for (const auto& transaction: result.getCachedTransactions()) {
+    transactionCache.insert(transaction.first, transaction.second);
+    if (inRange(transaction.second)) {
+      transactions.insert(transaction);
+    }
+  }
+
+  return true;
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage) const {
@@ -981,6 +1562,34 @@ ExtractOutputKeysResult
 DatabaseBlockchainCache::extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
                                               Common::ArrayView<uint32_t> globalIndexes,
                                               std::vector<Crypto::PublicKey>& publicKeys) const {
+  return extractKeyOutputKeys(amount, blockIndex, globalIndexes, publicKeys, getTopBlockIndex());
+}
+
+ExtractOutputKeysResult
+DatabaseBlockchainCache::extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
+                                              Common::ArrayView<uint32_t> globalIndexes,
+                                              std::vector<Crypto::PublicKey>& publicKeys, uint32_t topIndex) const {
+  if (isKeyOutputTableActual()) {
+    // same order and missing outputs handling as in extractKeyOutputs
+    uint32_t outputCountLimit = getKeyOutputCountLimit(amount, topIndex);
+    std::set<uint32_t> sortedIndexes(globalIndexes.begin(), globalIndexes.end());
+    for (auto globalIndex: sortedIndexes) {
+      const KeyOutputTableEntry* entry = globalIndex < outputCountLimit ? keyOutputTable->find(amount, globalIndex) : nullptr;
+      if (entry == nullptr) {
+        continue;
+      }
+
+      if (!isTransactionSpendTimeUnlocked(entry->unlockTime, blockIndex)) {
+        logger(Logging::DEBUGGING) << "extractKeyOutputKeys: output " << globalIndex << " is locked";
+        return ExtractOutputKeysResult::OUTPUT_LOCKED;
+      }
+
+      publicKeys.push_back(entry->publicKey);
+    }
+
+    return ExtractOutputKeysResult::SUCCESS;
+  }
+
   return extractKeyOutputs(amount, blockIndex, globalIndexes, [this, &publicKeys, blockIndex] (const CachedTransactionInfo& info, PackedOutIndex index, uint32_t globalIndex) {
     if (!isTransactionSpendTimeUnlocked(info.unlockTime, blockIndex)) {
       logger(Logging::DEBUGGING) << "extractKeyOutputKeys: output " << globalIndex << " is locked";
@@ -992,12 +1601,42 @@ DatabaseBlockchainCache::extractKeyOutputKeys(uint64_t amount, uint32_t blockInd
     publicKeys.push_back(boost::get<KeyOutput>(output).key);
 
     return ExtractOutputKeysResult::SUCCESS;
-  });
+  }, topIndex);
 }
 
 ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOtputIndexes(uint64_t amount,
                                                                         Common::ArrayView<uint32_t> globalIndexes,
                                                                         std::vector<PackedOutIndex>& outIndexes) const {
+  return extractKeyOtputIndexes(amount, globalIndexes, outIndexes, getTopBlockIndex());
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOtputIndexes(uint64_t amount,
+                                                                        Common::ArrayView<uint32_t> globalIndexes,
+                                                                        std::vector<PackedOutIndex>& outIndexes,
+                                                                        uint32_t topIndex) const {
+  uint32_t outputCountLimit = getKeyOutputCountLimit(amount, topIndex);
+  for (auto globalIndex: globalIndexes) {
+    if (globalIndex >= outputCountLimit) {
+      logger(Logging::ERROR) << "extractKeyOtputIndexes failed: output " << globalIndex << " of amount " << amount << " is above block " << topIndex;
+      return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+    }
+  }
+
+  if (isKeyOutputTableActual()) {
+    outIndexes.reserve(outIndexes.size() + globalIndexes.getSize());
+    for (auto globalIndex: globalIndexes) {
+      const KeyOutputTableEntry* entry = keyOutputTable->find(amount, globalIndex);
+      if (entry == nullptr) {
+        logger(Logging::ERROR) << "extractKeyOtputIndexes failed: output " << globalIndex << " of amount " << amount << " not found";
+        return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+      }
+
+      outIndexes.push_back(entry->location);
+    }
+
+    return ExtractOutputKeysResult::SUCCESS;
+  }
+
   if (!requestPackedOutputs(amount, globalIndexes, database, outIndexes)) {
     logger(Logging::ERROR) << "extractKeyOtputIndexes failed: failed to read database";
     return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
@@ -1013,10 +1652,14 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOtputReferences(
   return extractKeyOutputs(amount, getTopBlockIndex(), globalIndexes, [&outputReferences] (const CachedTransactionInfo& info, PackedOutIndex index, uint32_t globalIndex) {
     outputReferences.push_back(std::make_pair(info.transactionHash, index.outputIndex));
     return ExtractOutputKeysResult::SUCCESS;
-  });
+  }, getTopBlockIndex());
 }
 
 uint32_t DatabaseBlockchainCache::getTopBlockIndex() const {
+  return overlayStartIndex ? *overlayStartIndex - 1 : getDatabaseTopBlockIndex();
+}
+
+uint32_t DatabaseBlockchainCache::getDatabaseTopBlockIndex() const {
   if (!topBlockIndex) {
     auto batch = BlockchainReadBatch().requestLastBlockIndex();
     auto result = database.read(batch);
@@ -1061,10 +1704,14 @@ uint64_t DatabaseBlockchainCache::getCachedTransactionsCount() const {
 }
 
 const Crypto::Hash& DatabaseBlockchainCache::getTopBlockHash() const {
+  return overlayStartIndex ? overlayParentHash : getDatabaseTopBlockHash();
+}
+
+const Crypto::Hash& DatabaseBlockchainCache::getDatabaseTopBlockHash() const {
   if (!topBlockHash) {
-    auto batch = BlockchainReadBatch().requestCachedBlock(getTopBlockIndex());
+    auto batch = BlockchainReadBatch().requestCachedBlock(getDatabaseTopBlockIndex());
     auto result = readDatabase(batch);
-    topBlockHash = result.getCachedBlocks().at(getTopBlockIndex()).blockHash;
+    topBlockHash = result.getCachedBlocks().at(getDatabaseTopBlockIndex()).blockHash;
   }
   return *topBlockHash;
 }
@@ -1073,9 +1720,8 @@ uint32_t DatabaseBlockchainCache::getBlockCount() const {
 }
 
 bool DatabaseBlockchainCache::hasBlock(const Crypto::Hash& blockHash) const {
-  auto batch = BlockchainReadBatch().requestBlockIndexByBlockHash(blockHash);
-  auto result = database.read(batch);
-  return !result && batch.extractResult().getBlockIndexesByBlockHashes().count(blockHash);
+  auto blockIndex = requestBlockIndex(blockHash);
+  return blockIndex && *blockIndex <= getTopBlockIndex();
 }
 
 uint32_t DatabaseBlockchainCache::getBlockIndex(const Crypto::Hash& blockHash) const {
@@ -1083,15 +1729,33 @@ uint32_t DatabaseBlockchainCache::getBlockIndex(const Crypto::Hash& blockHash) c
     return getTopBlockIndex();
   }
 
+  auto blockIndex = requestBlockIndex(blockHash);
+  if (!blockIndex || *blockIndex > getTopBlockIndex()) {
+    throw std::runtime_error("no such block");
+  }
+
+  return *blockIndex;
+}
+
+boost::optional<uint32_t> DatabaseBlockchainCache::requestBlockIndex(const Crypto::Hash& blockHash) const {
   auto batch = BlockchainReadBatch().requestBlockIndexByBlockHash(blockHash);
-  auto result = readDatabase(batch);
-  return result.getBlockIndexesByBlockHashes().at(blockHash);
+  auto result = database.read(batch);
+  if (result) {
+    return {};
+  }
+
+  auto readResult = batch.extractResult();
+  auto it = readResult.getBlockIndexesByBlockHashes().find(blockHash);
+  if (it == readResult.getBlockIndexesByBlockHashes().end()) {
+    return {};
+  }
+
+  return it->second;
 }
 
 bool DatabaseBlockchainCache::hasTransaction(const Crypto::Hash& transactionHash) const {
-  auto batch = BlockchainReadBatch().requestCachedTransaction(transactionHash);
-  auto result = database.read(batch);
-  return !result && batch.extractResult().getCachedTransactions().count(transactionHash);
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  return requestTransactionInfos({transactionHash}, transactions, 0, getTopBlockIndex()) && transactions.count(transactionHash) != 0;
 }
 
 std::vector<uint64_t> DatabaseBlockchainCache::getLastTimestamps(size_t count) const {
@@ -1125,11 +1789,20 @@ Difficulty DatabaseBlockchainCache::getDifficultyForNextBlock() const {
 }
 
 Difficulty DatabaseBlockchainCache::getDifficultyForNextBlock(uint32_t blockIndex) const {
-  assert(blockIndex <= getTopBlockIndex());
+  assert(blockIndex <= getDatabaseTopBlockIndex());
+  if (difficultyCache.isLoaded(blockIndex)) {
+    return difficultyCache.getNextDifficulty();
+  }
+
   auto timestamps = getLastTimestamps(currency.difficultyBlocksCount(), blockIndex, UseGenesis{false});
   auto commulativeDifficulties =
       getLastCumulativeDifficulties(currency.difficultyBlocksCount(), blockIndex, UseGenesis{false});
-  return currency.nextDifficulty(std::move(timestamps), std::move(commulativeDifficulties));
+  if (blockIndex != getDatabaseTopBlockIndex()) {
+    return currency.nextDifficulty(std::move(timestamps), std::move(commulativeDifficulties));
+  }
+
+  difficultyCache.load(blockIndex, timestamps, commulativeDifficulties);
+  return difficultyCache.getNextDifficulty();
 }
 
 Difficulty DatabaseBlockchainCache::getCurrentCumulativeDifficulty() const {
@@ -1137,14 +1810,21 @@ Difficulty DatabaseBlockchainCache::getCurrentCumulativeDifficulty() const {
 }
 
 Difficulty DatabaseBlockchainCache::getCurrentCumulativeDifficulty(uint32_t blockIndex) const {
-  assert(blockIndex <= getTopBlockIndex());
+  assert(blockIndex <= getDatabaseTopBlockIndex());
   return getCachedBlockInfo(blockIndex).cumulativeDifficulty;
 }
 
 CachedBlockInfo DatabaseBlockchainCache::getCachedBlockInfo(uint32_t index) const {
+  const CachedBlockInfo* cached = blockInfoCache.find(index);
+  if (cached != nullptr) {
+    return *cached;
+  }
+
   auto batch = BlockchainReadBatch().requestCachedBlock(index);
   auto result = readDatabase(batch);
-  return result.getCachedBlocks().at(index);
+  const CachedBlockInfo& blockInfo = result.getCachedBlocks().at(index);
+  blockInfoCache.insert(index, blockInfo);
+  return blockInfo;
 }
 
 uint64_t DatabaseBlockchainCache::getAlreadyGeneratedCoins() const {
@@ -1160,10 +1840,10 @@ uint64_t DatabaseBlockchainCache::getAlreadyGeneratedTransactions(uint32_t block
 }
 
 std::vector<CachedBlockInfo> DatabaseBlockchainCache::getLastCachedUnits(uint32_t blockIndex, size_t count, UseGenesis useGenesis) const {
-  assert(blockIndex <= getTopBlockIndex());
+  assert(blockIndex <= getDatabaseTopBlockIndex());
 
   std::vector<CachedBlockInfo> cachedResult;
-  const uint32_t cacheStartIndex = (getTopBlockIndex() + 1) - static_cast<uint32_t>(unitsCache.size());
+  const uint32_t cacheStartIndex = (getDatabaseTopBlockIndex() + 1) - static_cast<uint32_t>(unitsCache.size());
 
   count = std::min(unitsCache.size(), count);
 
@@ -1273,8 +1953,8 @@ DatabaseBlockchainCache::getLastUnits(size_t count, uint32_t blockIndex, UseGene
 }
 
 Crypto::Hash DatabaseBlockchainCache::getBlockHash(uint32_t blockIndex) const {
-  if (blockIndex == getTopBlockIndex()) {
-    return getTopBlockHash();
+  if (blockIndex == getDatabaseTopBlockIndex()) {
+    return getDatabaseTopBlockHash();
   }
 
   auto batch = BlockchainReadBatch().requestCachedBlock(blockIndex);
@@ -1283,10 +1963,14 @@ Crypto::Hash DatabaseBlockchainCache::getBlockHash(uint32_t blockIndex) const {
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashes(uint32_t startIndex, size_t maxCount) const {
-  assert(startIndex <= getTopBlockIndex());
+  return getBlockHashes(startIndex, maxCount, getTopBlockIndex());
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashes(uint32_t startIndex, size_t maxCount, uint32_t topIndex) const {
+  assert(startIndex <= topIndex);
   assert(maxCount <= std::numeric_limits<uint32_t>::max());
 
-  uint32_t count = std::min(getTopBlockIndex() - startIndex + 1, static_cast<uint32_t>(maxCount));
+  uint32_t count = std::min(topIndex - startIndex + 1, static_cast<uint32_t>(maxCount));
   if (count == 0) {
     return {};
   }
@@ -1320,6 +2004,29 @@ uint32_t DatabaseBlockchainCache::getStartBlockIndex() const {
 }
 
 size_t DatabaseBlockchainCache::getKeyOutputsCountForAmount(uint64_t amount, uint32_t blockIndex) const {
+  return getKeyOutputsCountForAmount(amount, blockIndex, getTopBlockIndex());
+}
+
+size_t DatabaseBlockchainCache::getKeyOutputsCountForAmount(uint64_t amount, uint32_t blockIndex, uint32_t topIndex) const {
+  // outputs are sorted by block, so outputs above the top are cut off by the same search
+  blockIndex = std::min(blockIndex, topIndex + 1);
+
+  if (isKeyOutputTableActual()) {
+    uint32_t begin = 0;
+    uint32_t end = keyOutputTable->getOutputCount(amount);
+    while (begin < end) {
+      uint32_t middle = begin + (end - begin) / 2;
+      if (keyOutputTable->find(amount, middle)->location.blockIndex < blockIndex) {
+        begin = middle + 1;
+      } else {
+        end = middle;
+      }
+    }
+
+    logger(Logging::DEBUGGING) << "Key outputs count for amount " << amount << " is " << begin << " by block index " << blockIndex;
+    return begin;
+  }
+
   uint32_t outputsCount = requestKeyOutputGlobalIndexesCountForAmount(amount, database);
 
   auto getOutput = std::bind(retrieveKeyOutput, std::placeholders::_1, std::placeholders::_2, std::ref(database));
@@ -1336,7 +2043,26 @@ size_t DatabaseBlockchainCache::getKeyOutputsCountForAmount(uint64_t amount, uin
   return result;
 }
 
+// global indexes of outputs above the top block are out of range
+uint32_t DatabaseBlockchainCache::getKeyOutputCountLimit(Amount amount, uint32_t topIndex) const {
+  if (topIndex >= getDatabaseTopBlockIndex()) {
+    return std::numeric_limits<uint32_t>::max();
+  }
+
+  auto key = std::make_pair(topIndex, amount);
+  auto it = keyOutputCountLimits.find(key);
+  if (it == keyOutputCountLimits.end()) {
+    it = keyOutputCountLimits.emplace(key, static_cast<uint32_t>(getKeyOutputsCountForAmount(amount, topIndex + 1, topIndex))).first;
+  }
+
+  return it->second;
+}
+
 uint32_t DatabaseBlockchainCache::getTimestampLowerBoundBlockIndex(uint64_t timestamp) const {
+  return getTimestampLowerBoundBlockIndex(timestamp, getTopBlockIndex());
+}
+
+uint32_t DatabaseBlockchainCache::getTimestampLowerBoundBlockIndex(uint64_t timestamp, uint32_t topIndex) const {
   auto midnight = roundToMidnight(timestamp);
 
   while (midnight > 0) {
@@ -1346,7 +2072,8 @@ uint32_t DatabaseBlockchainCache::getTimestampLowerBoundBlockIndex(uint64_t time
       throw std::runtime_error("Couldn't get closest to timestamp block index");
     }
 
-    if (!dbRes.first) {
+    // a day started above the top has no blocks below it
+    if (!dbRes.first || *dbRes.first > topIndex) {
       midnight -= 60 * 60 * 24;
       continue;
     }
@@ -1359,16 +2086,14 @@ uint32_t DatabaseBlockchainCache::getTimestampLowerBoundBlockIndex(uint64_t time
 
 bool DatabaseBlockchainCache::getTransactionGlobalIndexes(const Crypto::Hash& transactionHash,
                                                           std::vector<uint32_t>& globalIndexes) const {
-  auto batch = BlockchainReadBatch().requestCachedTransaction(transactionHash);
-  auto result = database.read(batch);
-  if (result) {
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  if (!requestTransactionInfos({transactionHash}, transactions, 0, getTopBlockIndex())) {
     logger(Logging::DEBUGGING) << "getTransactionGlobalIndexes failed: failed to read database";
     return false;
   }
 
-  auto readResult = batch.extractResult();
-  auto it = readResult.getCachedTransactions().find(transactionHash);
-  if (it == readResult.getCachedTransactions().end()) {
+  auto it = transactions.find(transactionHash);
+  if (it == transactions.end()) {
     logger(Logging::DEBUGGING) << "getTransactionGlobalIndexes failed: cached transaction for hash " << transactionHash << " not present";
     return false;
   }
@@ -1378,13 +2103,20 @@ bool DatabaseBlockchainCache::getTransactionGlobalIndexes(const Crypto::Hash& tr
 }
 
 size_t DatabaseBlockchainCache::getTransactionCount() const {
+  if (overlayStartIndex) {
+    return static_cast<size_t>(getAlreadyGeneratedTransactions(getTopBlockIndex()));
+  }
+
   return static_cast<size_t>(getCachedTransactionsCount());
 }
 
 uint32_t DatabaseBlockchainCache::getBlockIndexContainingTx(const Crypto::Hash& transactionHash) const {
-  auto batch = BlockchainReadBatch().requestCachedTransaction(transactionHash);
-  auto result = readDatabase(batch);
-  return result.getCachedTransactions().at(transactionHash).blockIndex;
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  if (!requestTransactionInfos({transactionHash}, transactions, 0, getTopBlockIndex())) {
+    throw std::runtime_error("Failed to read transaction from database");
+  }
+
+  return transactions.at(transactionHash).blockIndex;
 }
 
 size_t DatabaseBlockchainCache::getChildCount() const {
@@ -1392,6 +2124,17 @@ size_t DatabaseBlockchainCache::getChildCount() const {
 }
 
 void DatabaseBlockchainCache::save() {
+  if (overlayStartIndex) {
+    deleteBlocks(*overlayStartIndex);
+  }
+
+  if (keyOutputTable) {
+    keyOutputTable->flush();
+  }
+
+  logger(Logging::INFO) << "Object cache hit rates: block infos " << blockInfoCache.getStatistics().getHitRate()
+                        << ", transactions " << transactionCache.getStatistics().getHitRate()
+                        << ", key outputs " << keyOutputCache.getStatistics().getHitRate();
 }
 
 void DatabaseBlockchainCache::load() {
@@ -1416,21 +2159,23 @@ DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>& tra
 void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>& transactions,
                                                  std::vector<BinaryArray>& foundTransactions,
                                                  std::vector<Crypto::Hash>& missedTransactions) const {
-  BlockchainReadBatch batch;
-  for (auto& hash : transactions) {
-    batch.requestCachedTransaction(hash);
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> hashesMap;
+  if (!requestTransactionInfos(transactions, hashesMap, 0, getTopBlockIndex())) {
+    throw std::runtime_error("Failed to read transactions from database");
   }
 
-  auto res = readDatabase(batch);
-  for (auto& tx : res.getCachedTransactions()) {
-    batch.requestRawBlock(tx.second.blockIndex);
+  BlockchainReadBatch batch;
+  for (auto& tx : hashesMap) {
+    if (!isRawBlockInStorage(tx.second.blockIndex)) {
+      batch.requestRawBlock(tx.second.blockIndex);
+    }
   }
 
   auto blocks = readDatabase(batch);
 
   foundTransactions.reserve(foundTransactions.size() + transactions.size());
-  auto& hashesMap = res.getCachedTransactions();
   auto& blocksMap = blocks.getRawBlocks();
+  std::unordered_map<uint32_t, RawBlock> storageBlocksMap;
   for (const auto& hash: transactions) {
     auto transactionIt = hashesMap.find(hash);
     if (transactionIt == hashesMap.end()) {
@@ -1440,7 +2185,13 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
     }
 
     auto blockIt = blocksMap.find(transactionIt->second.blockIndex);
-    if (blockIt == blocksMap.end()) {
+    if (isRawBlockInStorage(transactionIt->second.blockIndex)) {
+      auto blockIndex = transactionIt->second.blockIndex;
+      blockIt = storageBlocksMap.find(blockIndex);
+      if (blockIt == storageBlocksMap.end()) {
+        blockIt = storageBlocksMap.emplace(blockIndex, rawBlocksStorage->getBlockByIndex(blockIndex)).first;
+      }
+    } else if (blockIt == blocksMap.end()) {
       logger(Logging::DEBUGGING) << "detected missing transaction for hash " << hash << " in getRawTransaction";
       missedTransactions.push_back(hash);
       continue;
@@ -1449,6 +2200,9 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
     if (transactionIt->second.transactionIndex == 0) {
       auto block = fromBinaryArray<BlockTemplate>(blockIt->second.block);
       foundTransactions.emplace_back(toBinaryArray(block.baseTransaction));
+    } else if (transactionIt->second.blockIndex < prunedBlockCount) {
+      logger(Logging::DEBUGGING) << "transaction " << hash << " of pruned block " << transactionIt->second.blockIndex << " requested in getRawTransaction";
+      missedTransactions.push_back(hash);
     } else {
       assert(blockIt->second.transactions.size() >= transactionIt->second.transactionIndex - 1);
       foundTransactions.emplace_back(blockIt->second.transactions[transactionIt->second.transactionIndex - 1]);
@@ -1456,7 +2210,52 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
   }
 }
 
+void DatabaseBlockchainCache::pruneBlocks(uint32_t endIndex) {
+  endIndex = std::min(endIndex, getTopBlockIndex() + 1);
+  if (endIndex <= prunedBlockCount) {
+    return;
+  }
+
+  logger(Logging::INFO) << "Pruning transactions of blocks " << prunedBlockCount << " - " << endIndex - 1;
+
+  while (prunedBlockCount < endIndex) {
+    uint32_t batchEnd = std::min(prunedBlockCount + PRUNE_BATCH_SIZE, endIndex);
+
+    BlockchainReadBatch readBatch;
+    for (uint32_t blockIndex = prunedBlockCount; blockIndex < batchEnd; ++blockIndex) {
+      if (!isRawBlockInStorage(blockIndex)) {
+        readBatch.requestRawBlock(blockIndex);
+      }
+    }
+
+    auto readResult = readDatabase(readBatch);
+    PrunedBlocksWriteBatch writeBatch(batchEnd);
+    for (uint32_t blockIndex = prunedBlockCount; blockIndex < batchEnd; ++blockIndex) {
+      RawBlock header;
+      header.block = isRawBlockInStorage(blockIndex) ? rawBlocksStorage->getBlockByIndex(blockIndex).block : readResult.getRawBlocks().at(blockIndex).block;
+      writeBatch.getRawBlocksBatch().insertRawBlock(blockIndex, header);
+    }
+
+    // the main chain storage drops its blocks after this, so the headers must be on disk by then
+    auto error = batchEnd == endIndex ? database.writeSync(writeBatch) : database.write(writeBatch);
+    if (error) {
+      logger(Logging::ERROR) << "Failed to write pruned blocks to DB: " << error.message();
+      throw std::system_error(error);
+    }
+
+    prunedBlockCount = batchEnd;
+  }
+}
+
+uint32_t DatabaseBlockchainCache::getPrunedBlockCount() const {
+  return prunedBlockCount;
+}
+
 RawBlock DatabaseBlockchainCache::getBlockByIndex(uint32_t index) const {
+  if (isRawBlockInStorage(index)) {
+    return rawBlocksStorage->getBlockByIndex(index);
+  }
+
   auto batch = BlockchainReadBatch().requestRawBlock(index);
   auto res = readDatabase(batch);
   return std::move(res.getRawBlocks().at(index));
@@ -1473,15 +2272,25 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashes() const
 
 std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t amount, size_t count,
                                                                      uint32_t blockIndex) const {
+  return getRandomOutsByAmount(amount, count, blockIndex, getTopBlockIndex());
+}
+
+std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t amount, size_t count,
+                                                                     uint32_t blockIndex, uint32_t topIndex) const {
+  if (isKeyOutputTableActual()) {
+    return getRandomOutsByAmountFromTable(amount, count, blockIndex, topIndex);
+  }
+
   auto batch = BlockchainReadBatch().requestKeyOutputGlobalIndexesCountForAmount(amount);
   auto result = readDatabase(batch);
-  auto outputsCount = result.getKeyOutputGlobalIndexesCountForAmounts();
-  auto outputsToPick = std::min(static_cast<uint32_t>(count), outputsCount[amount]);
+  auto outputsCounts = result.getKeyOutputGlobalIndexesCountForAmounts();
+  auto outputsCount = std::min(outputsCounts[amount], getKeyOutputCountLimit(amount, topIndex));
+  auto outputsToPick = std::min(static_cast<uint32_t>(count), outputsCount);
 
   std::vector<uint32_t> resultOuts;
   resultOuts.reserve(outputsToPick);
 
-  ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(outputsCount[amount]);
+  ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(outputsCount);
 
   while (outputsToPick) {
     std::vector<uint32_t> globalIndexes;
@@ -1496,7 +2305,7 @@ std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t am
     }
 
     std::vector<PackedOutIndex> outputs;
-    if (extractKeyOtputIndexes(amount, Common::ArrayView<uint32_t>(globalIndexes.data(), globalIndexes.size()), outputs) != ExtractOutputKeysResult::SUCCESS) {
+    if (extractKeyOtputIndexes(amount, Common::ArrayView<uint32_t>(globalIndexes.data(), globalIndexes.size()), outputs, topIndex) != ExtractOutputKeysResult::SUCCESS) {
       logger(Logging::DEBUGGING) << "getRandomOutsByAmount: failed to extract key output indexes";
       throw std::runtime_error("Invalid output index"); //TODO: make error code
     }
@@ -1527,17 +2336,90 @@ std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t am
   return resultOuts;
 }
 
+// every candidate is checked with a single read of the mapped table, no data base requests are made
+std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmountFromTable(uint64_t amount, size_t count,
+                                                                              uint32_t blockIndex, uint32_t topIndex) const {
+  uint32_t outputsCount = std::min(keyOutputTable->getOutputCount(amount), getKeyOutputCountLimit(amount, topIndex));
+  auto outputsToPick = std::min(static_cast<uint32_t>(count), outputsCount);
+
+  std::vector<uint32_t> resultOuts;
+  resultOuts.reserve(outputsToPick);
+
+  uint32_t uppperBlockIndex = 0;
+  if (blockIndex > currency.minedMoneyUnlockWindow()) {
+    uppperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow();
+  }
+
+  ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(outputsCount);
+  while (resultOuts.size() < outputsToPick) {
+    uint32_t globalIndex;
+    try {
+      globalIndex = generator();
+    } catch (const SequenceEnded&) {
+      logger(Logging::TRACE) << "getRandomOutsByAmount: generator reached sequence end";
+      break;
+    }
+
+    const KeyOutputTableEntry* entry = keyOutputTable->find(amount, globalIndex);
+    assert(entry != nullptr);
+    if (!isTransactionSpendTimeUnlocked(entry->unlockTime, blockIndex) || entry->location.blockIndex > uppperBlockIndex) {
+      continue;
+    }
+
+    resultOuts.push_back(globalIndex);
+  }
+
+  return resultOuts;
+}
+
 ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
     uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
                                           uint32_t globalIndex)> callback) const {
+  return extractKeyOutputs(amount, blockIndex, globalIndexes, std::move(callback), getTopBlockIndex());
+}
+
+// outputs above the top block are handled as missing ones
+ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
+    uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
+    std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
+                                          uint32_t globalIndex)> callback, uint32_t topIndex) const {
+  uint32_t outputCountLimit = getKeyOutputCountLimit(amount, topIndex);
+  std::map<std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>, KeyOutputInfo> sortedResult;
   BlockchainReadBatch batch;
+  bool batchEmpty = true;
   for (auto it = globalIndexes.begin(); it != globalIndexes.end(); ++it) {
-    batch.requestKeyOutputInfo(amount, *it);
+    if (*it >= outputCountLimit) {
+      continue;
+    }
+
+    auto key = std::make_pair(amount, *it);
+    auto prefetched = prefetchedKeyOutputs.find(key);
+    if (prefetched != prefetchedKeyOutputs.end()) {
+      if (prefetched->second) {
+        sortedResult.emplace(key, *prefetched->second);
+      }
+
+      continue;
+    }
+
+    const KeyOutputInfo* cached = keyOutputCache.find(key);
+    if (cached != nullptr) {
+      sortedResult.emplace(key, *cached);
+    } else {
+      batch.requestKeyOutputInfo(amount, *it);
+      batchEmpty = false;
+    }
   }
 
-  auto result = readDatabase(batch).getKeyOutputInfo();
-  std::map<std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>, KeyOutputInfo> sortedResult(result.begin(), result.end());
+  if (!batchEmpty) {
+    auto result = readDatabase(batch).getKeyOutputInfo();
+    for (const auto& keyOutput: result) {
+      keyOutputCache.insert(keyOutput.first, keyOutput.second);
+    }
+
+    sortedResult.insert(result.begin(), result.end());
+  }
   for (const auto& kv: sortedResult) {
     ExtendedTransactionInfo tx;
     tx.unlockTime = kv.second.unlockTime;
@@ -1559,6 +2441,10 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const {
+  return getTransactionHashesByPaymentId(paymentId, getTopBlockIndex());
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId, uint32_t topIndex) const {
   auto countBatch = BlockchainReadBatch().requestTransactionCountByPaymentId(paymentId);
   uint32_t transactionsCountByPaymentId = readDatabase(countBatch).getTransactionCountByPaymentIds().at(paymentId);
 
@@ -1574,10 +2460,26 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashesByPayment
     transactionHashes.emplace_back(kv.second);
   }
 
+  if (topIndex < getDatabaseTopBlockIndex()) {
+    std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+    if (!requestTransactionInfos(transactionHashes, transactions, 0, topIndex)) {
+      throw std::runtime_error("Failed to read transactions from database");
+    }
+
+    transactionHashes.erase(std::remove_if(transactionHashes.begin(), transactionHashes.end(), [&transactions] (const Crypto::Hash& hash) {
+      return transactions.count(hash) == 0;
+    }), transactionHashes.end());
+  }
+
   return transactionHashes;
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const {
+  return getBlockHashesByTimestamps(timestampBegin, secondsCount, getTopBlockIndex());
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount,
+                                                                             uint32_t topIndex) const {
   std::vector<Crypto::Hash> blockHashes;
   if (secondsCount == 0) {
     return blockHashes;
@@ -1598,17 +2500,34 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashesByTimestamps(ui
     blockHashes.insert(blockHashes.end(), hashes.begin(), hashes.end());
   }
 
+  if (topIndex < getDatabaseTopBlockIndex() && !blockHashes.empty()) {
+    BlockchainReadBatch indexBatch;
+    for (const auto& blockHash: blockHashes) {
+      indexBatch.requestBlockIndexByBlockHash(blockHash);
+    }
+
+    auto indexResult = readDatabase(indexBatch);
+    const auto& blockIndexes = indexResult.getBlockIndexesByBlockHashes();
+    blockHashes.erase(std::remove_if(blockHashes.begin(), blockHashes.end(), [&blockIndexes, topIndex] (const Crypto::Hash& hash) {
+      auto it = blockIndexes.find(hash);
+      return it == blockIndexes.end() || it->second > topIndex;
+    }), blockHashes.end());
+  }
+
   return blockHashes;
 }
 
-DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExtendedPushedBlockInfo(uint32_t blockIndex) const {
-  assert(blockIndex <= getTopBlockIndex());
+DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExtendedPushedBlockInfo(uint32_t blockIndex, bool readRawBlock) const {
+  assert(blockIndex <= getDatabaseTopBlockIndex());
 
   auto batch = BlockchainReadBatch()
-    .requestRawBlock(blockIndex)
     .requestCachedBlock(blockIndex)
     .requestSpentKeyImagesByBlock(blockIndex);
 
+  if (readRawBlock && !isRawBlockInStorage(blockIndex)) {
+    batch.requestRawBlock(blockIndex);
+  }
+
   if (blockIndex > 0) {
     batch.requestCachedBlock(blockIndex - 1);
   }
@@ -1619,7 +2538,10 @@ DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExt
 
   ExtendedPushedBlockInfo extendedInfo;
 
-  extendedInfo.pushedBlockInfo.rawBlock = dbResult.getRawBlocks().at(blockIndex);
+  if (readRawBlock) {
+    extendedInfo.pushedBlockInfo.rawBlock = isRawBlockInStorage(blockIndex) ? rawBlocksStorage->getBlockByIndex(blockIndex) : dbResult.getRawBlocks().at(blockIndex);
+  }
+
   extendedInfo.pushedBlockInfo.blockSize = blockInfo.blockSize;
   extendedInfo.pushedBlockInfo.blockDifficulty = blockInfo.cumulativeDifficulty - previousBlockInfo.cumulativeDifficulty;
   extendedInfo.pushedBlockInfo.generatedCoins = blockInfo.alreadyGeneratedCoins - previousBlockInfo.alreadyGeneratedCoins;
@@ -1682,7 +2604,9 @@ void DatabaseBlockchainCache::addGenesisBlock(CachedBlock&& genesisBlock) {
   pushTransaction(cachedBaseTransaction, 0, 0, batch);
 
   batch.insertCachedBlock(blockInfo, 0, {cachedBaseTransaction.getTransactionHash()});
-  batch.insertRawBlock(0, {toBinaryArray(genesisBlock.getBlock()), {}});
+  if (rawBlocksStorage == nullptr) {
+    batch.insertRawBlock(0, {toBinaryArray(genesisBlock.getBlock()), {}});
+  }
   batch.insertClosestTimestampBlockIndex(roundToMidnight(genesisBlock.getBlock().timestamp), 0);
 
   auto res = database.write(batch);
@@ -20,7 +20,12 @@
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "Difficulty.h"
+#include "DifficultyCache.h"
 #include "IBlockchainCache.h"
+#include "IMainChainStorage.h"
+#include "KeyImageFilter.h"
+#include "KeyOutputTable.h"
+#include "LruCache.h"
 #include <IDataBase.h>
 #include <CryptoNoteCore/BlockchainReadBatch.h>
 #include <CryptoNoteCore/BlockchainWriteBatch.h>
@@ -34,6 +39,8 @@ namespace CryptoNote {
  * Current implementation is designed to always be the root of blockchain, ie
  * start index is always zero, parent is always nullptr, no methods
  * do recursive calls to parent.
+ * Blocks above a split point stay in data base for DatabaseBlockchainCacheOverlay segments,
+ * the root segment hides them until they are pushed back or replaced.
  */
 class DatabaseBlockchainCache : public IBlockchainCache {
 public:
@@ -44,24 +51,44 @@ public:
   /*
    * Constructs new DatabaseBlockchainCache object. Currnetly, only factories that produce
    * BlockchainCache objects as children are supported.
+   * Blocks with indexes below bulkWriteEndIndex are written in data base bulk write mode.
+   * If rawBlocksStorage is set, raw blocks aren't written to data base, they are read from the main chain
+   * storage by block index instead. Data base blocks must be a prefix of the storage blocks then.
+   * If keyOutputTableFilename isn't empty, key outputs are also kept in the KeyOutputTable mapped from this file,
+   * random outputs and output keys are taken from it while it is in sync with data base.
+   * Decoded block infos, transactions and key outputs read from data base are cached within objectCacheSize bytes.
    */
   DatabaseBlockchainCache(const Currency& currency, IDataBase& dataBase,
-                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger);
+                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger, uint32_t bulkWriteEndIndex = 0,
+                          const IMainChainStorage* rawBlocksStorage = nullptr, const std::string& keyOutputTableFilename = "",
+                          uint64_t objectCacheSize = 0);
 
-  static bool checkDBSchemeVersion(IDataBase& dataBase, Logging::ILogger& logger);
+  struct ObjectCacheStatistics {
+    LruCacheStatistics blockInfos;
+    LruCacheStatistics transactions;
+    LruCacheStatistics keyOutputs;
+  };
+
+  // Returns false if data base must be destroyed and recreated from the main chain storage
+  static bool checkDBSchemeVersion(IDataBase& dataBase, Logging::ILogger& logger, bool rawBlocksInStorage = false);
 
   /*
-   * This methods splits cache, upper part (ie blocks with indexes larger than splitBlockIndex)
-   * is copied to new BlockchainCache. Unfortunately, implementation requires return value to be of
-   * BlockchainCache type.
+   * This methods splits cache, upper part (ie blocks with indexes larger or equal to splitBlockIndex)
+   * is left in data base and returned as DatabaseBlockchainCacheOverlay reading it.
    */
   std::unique_ptr<IBlockchainCache> split(uint32_t splitBlockIndex) override;
+  void truncate(uint32_t startIndex) override;
+  void pruneBlocks(uint32_t endIndex) override;
+  uint32_t getPrunedBlockCount() const override;
   void pushBlock(const CachedBlock& cachedBlock, const std::vector<CachedTransaction>& cachedTransactions,
                  const TransactionValidatorState& validatorState, size_t blockSize, uint64_t generatedCoins,
                  Difficulty blockDifficulty, RawBlock&& rawBlock) override;
   virtual PushedBlockInfo getPushedBlockInfo(uint32_t index) const override;
   bool checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const override;
   bool checkIfSpent(const Crypto::KeyImage& keyImage) const override;
+  void prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const override;
+  const KeyImageFilterStatistics& getSpentKeyImageFilterStatistics() const;
+  ObjectCacheStatistics getObjectCacheStatistics() const;
 
   bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const override;
   bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const override;
@@ -158,6 +185,8 @@ public:
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
 
 private:
+  friend class DatabaseBlockchainCacheOverlay;
+
   const Currency& currency;
   IDataBase& database;
   IBlockchainCacheFactory& blockchainCacheFactory;
@@ -166,16 +195,85 @@ private:
   mutable boost::optional<uint64_t> transactionsCount;
   mutable boost::optional<uint32_t> keyOutputAmountsCount;
   mutable std::unordered_map<Amount, int32_t> keyOutputCountsForAmounts;
+  // blocks from this index belong to overlay segments, data base top is above the top of this segment then
+  boost::optional<uint32_t> overlayStartIndex;
+  Crypto::Hash overlayParentHash;
+  // key output counts of amounts by the top block index of a segment below data base top
+  mutable std::map<std::pair<uint32_t, Amount>, uint32_t> keyOutputCountLimits;
+  // payment ids of overlay blocks kept in the main chain storage, it may hold another chain by the time they are deleted
+  std::map<uint32_t, std::vector<Crypto::Hash>> overlayPaymentIds;
   std::vector<IBlockchainCache*> children;
   Logging::LoggerRef logger;
   std::deque<CachedBlockInfo> unitsCache;
   const size_t unitsCacheSize = 1000;
-
-  struct ExtendedPushedBlockInfo;
-  ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex) const;
+  uint32_t bulkWriteEndIndex;
+  bool bulkWriteActive;
+  const IMainChainStorage* rawBlocksStorage;
+  // raw blocks below it are stored without transactions
+  uint32_t prunedBlockCount;
+  mutable DifficultyCache difficultyCache;
+  KeyImageFilter spentKeyImageFilter;
+  mutable KeyImageFilterStatistics spentKeyImageFilterStatistics;
+  std::unique_ptr<KeyOutputTable> keyOutputTable;
+  // results of the last prefetchKeyInputs, INVALID_BLOCK_INDEX marks key images that aren't spent
+  mutable std::unordered_map<Crypto::KeyImage, uint32_t> prefetchedSpentKeyImages;
+  mutable std::unordered_map<std::pair<Amount, GlobalOutputIndex>, boost::optional<KeyOutputInfo>> prefetchedKeyOutputs;
+  // only found objects are cached, so pushed blocks don't invalidate them
+  mutable LruCache<uint32_t, CachedBlockInfo> blockInfoCache;
+  mutable LruCache<Crypto::Hash, ExtendedTransactionInfo> transactionCache;
+  mutable LruCache<std::pair<Amount, GlobalOutputIndex>, KeyOutputInfo> keyOutputCache;
+
+  struct ExtendedPushedBlockInfo {
+    PushedBlockInfo pushedBlockInfo;
+    uint64_t timestamp;
+  };
+
+  ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex, bool readRawBlock = true) const;
+
+  uint32_t getDatabaseTopBlockIndex() const;
+  const Crypto::Hash& getDatabaseTopBlockHash() const;
+  void addOverlayPaymentIds(uint32_t blockIndex, const RawBlock& rawBlock);
+  void pushDatabaseBlock(const CachedBlock& cachedBlock, const std::vector<CachedTransaction>& cachedTransactions,
+                         const TransactionValidatorState& validatorState, size_t blockSize, uint64_t generatedCoins,
+                         Difficulty blockDifficulty, RawBlock&& rawBlock);
+
+  // queries below answer for blocks [0, topIndex] of data base
+  bool checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex, uint32_t topIndex) const;
+  size_t getKeyOutputsCountForAmount(uint64_t amount, uint32_t blockIndex, uint32_t topIndex) const;
+  uint32_t getKeyOutputCountLimit(Amount amount, uint32_t topIndex) const;
+  ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
+                                               std::vector<Crypto::PublicKey>& publicKeys, uint32_t topIndex) const;
+  ExtractOutputKeysResult extractKeyOtputIndexes(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
+                                                 std::vector<PackedOutIndex>& outIndexes, uint32_t topIndex) const;
+  ExtractOutputKeysResult
+  extractKeyOutputs(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
+                    std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
+                                                          uint32_t globalIndex)> pred, uint32_t topIndex) const;
+  std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex, uint32_t topIndex) const;
+  std::vector<Crypto::Hash> getBlockHashes(uint32_t startIndex, size_t maxCount, uint32_t topIndex) const;
+  uint32_t getTimestampLowerBoundBlockIndex(uint64_t timestamp, uint32_t topIndex) const;
+  std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId, uint32_t topIndex) const;
+  std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount, uint32_t topIndex) const;
+
+  // these look up blocks and transactions of [startIndex, topIndex] only
+  boost::optional<uint32_t> requestBlockIndex(const Crypto::Hash& blockHash) const;
+  bool requestTransactionInfos(const std::vector<Crypto::Hash>& transactionHashes,
+                               std::unordered_map<Crypto::Hash, ExtendedTransactionInfo>& transactions,
+                               uint32_t startIndex, uint32_t topIndex) const;
 
   void deleteClosestTimestampBlockIndex(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex);
+  void deleteBlocks(uint32_t startIndex);
+  void moveRawBlocksToStorage();
+  bool isRawBlockInStorage(uint32_t blockIndex) const;
+  void rebuildSpentKeyImageFilter(size_t capacity);
+  bool requestVerifiedRawBlock(uint32_t blockIndex, const Crypto::Hash& blockHash, RawBlock& block) const;
+  void syncKeyOutputTable();
+  bool isKeyOutputTableActual() const;
+  void clearPrefetchedKeyInputs();
+  void clearObjectCache();
+  std::vector<uint32_t> getRandomOutsByAmountFromTable(uint64_t amount, size_t count, uint32_t blockIndex, uint32_t topIndex) const;
   CachedBlockInfo getCachedBlockInfo(uint32_t index) const;
+  void updateBulkWriteMode(uint32_t blockIndex);
   BlockchainReadResult readDatabase(BlockchainReadBatch& batch) const;
 
   void addSpentKeyImage(const Crypto::KeyImage& keyImage, uint32_t blockIndex);
@@ -195,15 +293,13 @@ private:
 
   TransactionValidatorState fillOutputsSpentByBlock(uint32_t blockIndex) const;
 
-  Crypto::Hash pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo);
   void requestDeleteSpentOutputs(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex, const TransactionValidatorState& spentOutputs);
-  std::vector<Crypto::Hash> requestTransactionHashesFromBlockIndex(uint32_t splitBlockIndex);
+  std::vector<Crypto::Hash> requestTransactionHashes(uint32_t startIndex, uint32_t endIndex, bool withBaseTransactions = true) const;
   void requestDeleteTransactions(BlockchainWriteBatch& writeBatch, const std::vector<Crypto::Hash>& transactionHashes);
   void requestDeletePaymentIds(BlockchainWriteBatch& writeBatch, const std::vector<Crypto::Hash>& transactionHashes);
-  void requestDeletePaymentId(BlockchainWriteBatch& writeBatch, const Crypto::Hash& paymentId, size_t toDelete);
   void requestDeleteKeyOutputs(BlockchainWriteBatch& writeBatch, const std::map<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>& boundaries);
   void requestDeleteKeyOutputsAmount(BlockchainWriteBatch& writeBatch, IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex boundary, uint32_t outputsCount);
-  void requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
+  void requestRemoveTimestamps(BlockchainWriteBatch& batch, const std::unordered_map<uint64_t, std::vector<Crypto::Hash>>& blockHashesByTimestamp);
 
   uint64_t getCachedTransactionsCount() const;
 
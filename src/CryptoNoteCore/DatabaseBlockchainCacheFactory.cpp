@@ -20,11 +20,16 @@
 #include "IDataBase.h"
 
 #include "BlockchainCache.h"
+#include "BlockchainReadSnapshot.h"
 #include "DatabaseBlockchainCache.h"
 
 namespace CryptoNote {
 
-DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger): database(database), logger(logger) {
+DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, uint32_t bulkWriteEndIndex,
+                                                               const IMainChainStorage* rawBlocksStorage, const std::string& keyOutputTableFilename,
+                                                               uint64_t objectCacheSize):
+  database(database), logger(logger), bulkWriteEndIndex(bulkWriteEndIndex), rawBlocksStorage(rawBlocksStorage),
+  keyOutputTableFilename(keyOutputTableFilename), objectCacheSize(objectCacheSize) {
 
 }
 
@@ -33,11 +38,27 @@ DatabaseBlockchainCacheFactory::~DatabaseBlockchainCacheFactory() {
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createRootBlockchainCache(const Currency& currency) {
-  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger));
+  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger, bulkWriteEndIndex, rawBlocksStorage,
+    keyOutputTableFilename, objectCacheSize));
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex) {
   return std::unique_ptr<IBlockchainCache> (new BlockchainCache("", currency, logger, parent, startIndex));
 }
 
+std::unique_ptr<BlockchainReadSnapshot> DatabaseBlockchainCacheFactory::createReadSnapshot(uint32_t topBlockIndex) {
+  // raw blocks in the main chain storage are modified by the dispatcher, so they can't be read from a snapshot,
+  // with --db-raw-blocks-in-storage every read is done by the dispatcher
+  if (rawBlocksStorage != nullptr) {
+    return nullptr;
+  }
+
+  auto snapshot = database.createSnapshot();
+  if (!snapshot) {
+    return nullptr;
+  }
+
+  return std::unique_ptr<BlockchainReadSnapshot>(new BlockchainReadSnapshot(std::move(snapshot), topBlockIndex));
+}
+
 } //namespace CryptoNote
@@ -23,18 +23,30 @@
 namespace CryptoNote {
 
 class IDataBase;
+class IMainChainStorage;
 
 class DatabaseBlockchainCacheFactory: public IBlockchainCacheFactory {
 public:
-  explicit DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger);
+  // Root cache writes blocks with indexes below bulkWriteEndIndex in data base bulk write mode.
+  // If rawBlocksStorage is set, root cache reads raw blocks from it instead of keeping them in data base.
+  // If keyOutputTableFilename isn't empty, root cache keeps key outputs in a table mapped from this file.
+  // Root cache keeps recently read block infos, transactions and key outputs within objectCacheSize bytes
+  DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, uint32_t bulkWriteEndIndex = 0,
+                                 const IMainChainStorage* rawBlocksStorage = nullptr, const std::string& keyOutputTableFilename = "",
+                                 uint64_t objectCacheSize = 0);
   virtual ~DatabaseBlockchainCacheFactory();
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) override;
   virtual std::unique_ptr<IBlockchainCache> createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex = 0) override;
+  virtual std::unique_ptr<BlockchainReadSnapshot> createReadSnapshot(uint32_t topBlockIndex) override;
 
 private:
   IDataBase& database;
   Logging::ILogger& logger;
+  uint32_t bulkWriteEndIndex;
+  const IMainChainStorage* rawBlocksStorage;
+  std::string keyOutputTableFilename;
+  uint64_t objectCacheSize;
 };
 
 } //namespace CryptoNote
@@ -0,0 +1,464 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <CryptoNoteCore/DatabaseBlockchainCacheOverlay.h>
+
+#include <CryptoNoteCore/CryptoNoteTools.h>
+#include <CryptoNoteCore/DatabaseBlockchainCache.h>
+
+namespace CryptoNote {
+
+DatabaseBlockchainCacheOverlay::DatabaseBlockchainCacheOverlay(DatabaseBlockchainCache& root, IBlockchainCache* parent,
+                                                               uint32_t startIndex, uint32_t topIndex,
+                                                               const Crypto::Hash& topBlockHash, std::vector<RawBlock>&& rawBlocks,
+                                                               Logging::ILogger& logger)
+    : root(root), parent(parent), startIndex(startIndex), topIndex(topIndex), topBlockHash(topBlockHash),
+      rawBlocks(std::move(rawBlocks)), logger(logger, "DatabaseBlockchainCacheOverlay") {
+  assert(startIndex > 0);
+  assert(startIndex <= topIndex);
+  assert(!hasRawBlocksCopy() || this->rawBlocks.size() == topIndex - startIndex + 1);
+}
+
+bool DatabaseBlockchainCacheOverlay::hasRawBlocksCopy() const {
+  return root.rawBlocksStorage != nullptr;
+}
+
+boost::optional<uint32_t> DatabaseBlockchainCacheOverlay::requestBlockIndex(const Crypto::Hash& blockHash) const {
+  auto blockIndex = root.requestBlockIndex(blockHash);
+  if (!blockIndex || *blockIndex < startIndex || *blockIndex > topIndex) {
+    return {};
+  }
+
+  return blockIndex;
+}
+
+std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheOverlay::split(uint32_t splitBlockIndex) {
+  logger(Logging::DEBUGGING) << "Splitting at block index: " << splitBlockIndex << ", top block index: " << topIndex;
+
+  assert(splitBlockIndex > startIndex);
+  assert(splitBlockIndex <= topIndex);
+
+  std::vector<RawBlock> upperRawBlocks;
+  if (hasRawBlocksCopy()) {
+    auto bound = std::next(rawBlocks.begin(), splitBlockIndex - startIndex);
+    std::move(bound, rawBlocks.end(), std::back_inserter(upperRawBlocks));
+    rawBlocks.erase(bound, rawBlocks.end());
+  }
+
+  std::unique_ptr<DatabaseBlockchainCacheOverlay> newCache(new DatabaseBlockchainCacheOverlay(
+    root, this, splitBlockIndex, topIndex, topBlockHash, std::move(upperRawBlocks), logger.getLogger()));
+
+  for (auto child: children) {
+    child->setParent(newCache.get());
+  }
+
+  newCache->children = children;
+  children = { newCache.get() };
+
+  topIndex = splitBlockIndex - 1;
+  topBlockHash = root.getBlockHash(topIndex);
+
+  logger(Logging::DEBUGGING) << "Split successfully completed";
+  return std::move(newCache);
+}
+
+// blocks above the new top stay in data base until a block is pushed in their place
+void DatabaseBlockchainCacheOverlay::truncate(uint32_t truncateIndex) {
+  assert(children.empty());
+  assert(truncateIndex > startIndex);
+  assert(truncateIndex <= topIndex);
+
+  if (hasRawBlocksCopy()) {
+    rawBlocks.erase(std::next(rawBlocks.begin(), truncateIndex - startIndex), rawBlocks.end());
+  }
+
+  topIndex = truncateIndex - 1;
+  topBlockHash = root.getBlockHash(topIndex);
+}
+
+void DatabaseBlockchainCacheOverlay::pruneBlocks(uint32_t endIndex) {
+  parent->pruneBlocks(std::min(endIndex, startIndex));
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getPrunedBlockCount() const {
+  return parent->getPrunedBlockCount();
+}
+
+void DatabaseBlockchainCacheOverlay::pushBlock(const CachedBlock& cachedBlock,
+                                               const std::vector<CachedTransaction>& cachedTransactions,
+                                               const TransactionValidatorState& validatorState, size_t blockSize,
+                                               uint64_t generatedCoins, Difficulty blockDifficulty, RawBlock&& rawBlock) {
+  assert(children.empty());
+
+  // blocks above the top were split off or truncated, nobody reads them anymore
+  if (topIndex < root.getDatabaseTopBlockIndex()) {
+    root.deleteBlocks(topIndex + 1);
+  }
+
+  if (hasRawBlocksCopy()) {
+    rawBlocks.push_back(rawBlock);
+  }
+
+  root.pushDatabaseBlock(cachedBlock, cachedTransactions, validatorState, blockSize, generatedCoins, blockDifficulty,
+                         std::move(rawBlock));
+
+  ++topIndex;
+  if (hasRawBlocksCopy()) {
+    root.addOverlayPaymentIds(topIndex, rawBlocks.back());
+  }
+
+  topBlockHash = cachedBlock.getBlockHash();
+}
+
+PushedBlockInfo DatabaseBlockchainCacheOverlay::getPushedBlockInfo(uint32_t index) const {
+  assert(index >= startIndex);
+  assert(index <= topIndex);
+
+  PushedBlockInfo pushedBlockInfo = root.getExtendedPushedBlockInfo(index, !hasRawBlocksCopy()).pushedBlockInfo;
+  if (hasRawBlocksCopy()) {
+    pushedBlockInfo.rawBlock = rawBlocks[index - startIndex];
+  }
+
+  return pushedBlockInfo;
+}
+
+bool DatabaseBlockchainCacheOverlay::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const {
+  return root.checkIfSpent(keyImage, blockIndex, topIndex);
+}
+
+bool DatabaseBlockchainCacheOverlay::checkIfSpent(const Crypto::KeyImage& keyImage) const {
+  return root.checkIfSpent(keyImage, topIndex, topIndex);
+}
+
+void DatabaseBlockchainCacheOverlay::prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const {
+  root.prefetchKeyInputs(inputs);
+}
+
+bool DatabaseBlockchainCacheOverlay::isTransactionSpendTimeUnlocked(uint64_t unlockTime) const {
+  return root.isTransactionSpendTimeUnlocked(unlockTime, topIndex);
+}
+
+bool DatabaseBlockchainCacheOverlay::isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const {
+  return root.isTransactionSpendTimeUnlocked(unlockTime, blockIndex);
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCacheOverlay::extractKeyOutputKeys(uint64_t amount,
+                                                                             Common::ArrayView<uint32_t> globalIndexes,
+                                                                             std::vector<Crypto::PublicKey>& publicKeys) const {
+  return extractKeyOutputKeys(amount, topIndex, globalIndexes, publicKeys);
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCacheOverlay::extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
+                                                                             Common::ArrayView<uint32_t> globalIndexes,
+                                                                             std::vector<Crypto::PublicKey>& publicKeys) const {
+  return root.extractKeyOutputKeys(amount, blockIndex, globalIndexes, publicKeys, topIndex);
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCacheOverlay::extractKeyOtputIndexes(uint64_t amount,
+                                                                               Common::ArrayView<uint32_t> globalIndexes,
+                                                                               std::vector<PackedOutIndex>& outIndexes) const {
+  return root.extractKeyOtputIndexes(amount, globalIndexes, outIndexes, topIndex);
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCacheOverlay::extractKeyOtputReferences(
+    uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
+    std::vector<std::pair<Crypto::Hash, size_t>>& outputReferences) const {
+  return root.extractKeyOutputs(amount, topIndex, globalIndexes, [&outputReferences] (const CachedTransactionInfo& info, PackedOutIndex index, uint32_t globalIndex) {
+    outputReferences.push_back(std::make_pair(info.transactionHash, index.outputIndex));
+    return ExtractOutputKeysResult::SUCCESS;
+  }, topIndex);
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getTopBlockIndex() const {
+  return topIndex;
+}
+
+const Crypto::Hash& DatabaseBlockchainCacheOverlay::getTopBlockHash() const {
+  return topBlockHash;
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getBlockCount() const {
+  return topIndex - startIndex + 1;
+}
+
+bool DatabaseBlockchainCacheOverlay::hasBlock(const Crypto::Hash& blockHash) const {
+  return bool(requestBlockIndex(blockHash));
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getBlockIndex(const Crypto::Hash& blockHash) const {
+  auto blockIndex = requestBlockIndex(blockHash);
+  if (!blockIndex) {
+    throw std::runtime_error("no such block");
+  }
+
+  return *blockIndex;
+}
+
+bool DatabaseBlockchainCacheOverlay::hasTransaction(const Crypto::Hash& transactionHash) const {
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  return root.requestTransactionInfos({transactionHash}, transactions, startIndex, topIndex) && transactions.count(transactionHash) != 0;
+}
+
+std::vector<uint64_t> DatabaseBlockchainCacheOverlay::getLastTimestamps(size_t count) const {
+  return getLastTimestamps(count, topIndex, UseGenesis{false});
+}
+
+std::vector<uint64_t> DatabaseBlockchainCacheOverlay::getLastTimestamps(size_t count, uint32_t blockIndex,
+                                                                        UseGenesis useGenesis) const {
+  assert(blockIndex <= topIndex);
+  return root.getLastTimestamps(count, blockIndex, useGenesis);
+}
+
+std::vector<uint64_t> DatabaseBlockchainCacheOverlay::getLastBlocksSizes(size_t count) const {
+  return getLastBlocksSizes(count, topIndex, UseGenesis{false});
+}
+
+std::vector<uint64_t> DatabaseBlockchainCacheOverlay::getLastBlocksSizes(size_t count, uint32_t blockIndex,
+                                                                         UseGenesis useGenesis) const {
+  assert(blockIndex <= topIndex);
+  return root.getLastBlocksSizes(count, blockIndex, useGenesis);
+}
+
+std::vector<Difficulty> DatabaseBlockchainCacheOverlay::getLastCumulativeDifficulties(size_t count, uint32_t blockIndex,
+                                                                                      UseGenesis useGenesis) const {
+  assert(blockIndex <= topIndex);
+  return root.getLastCumulativeDifficulties(count, blockIndex, useGenesis);
+}
+
+std::vector<Difficulty> DatabaseBlockchainCacheOverlay::getLastCumulativeDifficulties(size_t count) const {
+  return getLastCumulativeDifficulties(count, topIndex, UseGenesis{false});
+}
+
+Difficulty DatabaseBlockchainCacheOverlay::getDifficultyForNextBlock() const {
+  return getDifficultyForNextBlock(topIndex);
+}
+
+Difficulty DatabaseBlockchainCacheOverlay::getDifficultyForNextBlock(uint32_t blockIndex) const {
+  assert(blockIndex <= topIndex);
+  return root.getDifficultyForNextBlock(blockIndex);
+}
+
+Difficulty DatabaseBlockchainCacheOverlay::getCurrentCumulativeDifficulty() const {
+  return getCurrentCumulativeDifficulty(topIndex);
+}
+
+Difficulty DatabaseBlockchainCacheOverlay::getCurrentCumulativeDifficulty(uint32_t blockIndex) const {
+  assert(blockIndex <= topIndex);
+  return root.getCurrentCumulativeDifficulty(blockIndex);
+}
+
+uint64_t DatabaseBlockchainCacheOverlay::getAlreadyGeneratedCoins() const {
+  return getAlreadyGeneratedCoins(topIndex);
+}
+
+uint64_t DatabaseBlockchainCacheOverlay::getAlreadyGeneratedCoins(uint32_t blockIndex) const {
+  assert(blockIndex <= topIndex);
+  return root.getAlreadyGeneratedCoins(blockIndex);
+}
+
+uint64_t DatabaseBlockchainCacheOverlay::getAlreadyGeneratedTransactions(uint32_t blockIndex) const {
+  assert(blockIndex <= topIndex);
+  return root.getAlreadyGeneratedTransactions(blockIndex);
+}
+
+std::vector<uint64_t> DatabaseBlockchainCacheOverlay::getLastUnits(size_t count, uint32_t blockIndex, UseGenesis useGenesis,
+                                                                   std::function<uint64_t(const CachedBlockInfo&)> pred) const {
+  assert(blockIndex <= topIndex);
+  return root.getLastUnits(count, blockIndex, useGenesis, std::move(pred));
+}
+
+Crypto::Hash DatabaseBlockchainCacheOverlay::getBlockHash(uint32_t blockIndex) const {
+  assert(blockIndex <= topIndex);
+  return root.getBlockHash(blockIndex);
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCacheOverlay::getBlockHashes(uint32_t startBlockIndex, size_t maxCount) const {
+  return root.getBlockHashes(startBlockIndex, maxCount, topIndex);
+}
+
+IBlockchainCache* DatabaseBlockchainCacheOverlay::getParent() const {
+  return parent;
+}
+
+void DatabaseBlockchainCacheOverlay::setParent(IBlockchainCache* p) {
+  parent = p;
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getStartBlockIndex() const {
+  return startIndex;
+}
+
+size_t DatabaseBlockchainCacheOverlay::getKeyOutputsCountForAmount(uint64_t amount, uint32_t blockIndex) const {
+  return root.getKeyOutputsCountForAmount(amount, blockIndex, topIndex);
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getTimestampLowerBoundBlockIndex(uint64_t timestamp) const {
+  return root.getTimestampLowerBoundBlockIndex(timestamp, topIndex);
+}
+
+// raw blocks are read once for all their requested transactions
+void DatabaseBlockchainCacheOverlay::getRawTransactions(const std::vector<Crypto::Hash>& transactions,
+                                                        std::vector<BinaryArray>& foundTransactions,
+                                                        std::vector<Crypto::Hash>& missedTransactions) const {
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactionInfos;
+  if (!root.requestTransactionInfos(transactions, transactionInfos, startIndex, topIndex)) {
+    throw std::runtime_error("Failed to read transactions from database");
+  }
+
+  std::unordered_map<uint32_t, RawBlock> blocks;
+  foundTransactions.reserve(foundTransactions.size() + transactions.size());
+  for (const auto& hash: transactions) {
+    auto transactionIt = transactionInfos.find(hash);
+    if (transactionIt == transactionInfos.end()) {
+      missedTransactions.push_back(hash);
+      continue;
+    }
+
+    auto blockIndex = transactionIt->second.blockIndex;
+    auto blockIt = blocks.find(blockIndex);
+    if (blockIt == blocks.end()) {
+      blockIt = blocks.emplace(blockIndex, getBlockByIndex(blockIndex)).first;
+    }
+
+    auto transactionIndex = transactionIt->second.transactionIndex;
+    if (transactionIndex == 0) {
+      auto block = fromBinaryArray<BlockTemplate>(blockIt->second.block);
+      foundTransactions.emplace_back(toBinaryArray(block.baseTransaction));
+    } else {
+      assert(blockIt->second.transactions.size() >= transactionIndex);
+      foundTransactions.emplace_back(blockIt->second.transactions[transactionIndex - 1]);
+    }
+  }
+}
+
+std::vector<BinaryArray> DatabaseBlockchainCacheOverlay::getRawTransactions(const std::vector<Crypto::Hash>& transactions,
+                                                                            std::vector<Crypto::Hash>& missedTransactions) const {
+  std::vector<BinaryArray> found;
+  getRawTransactions(transactions, found, missedTransactions);
+  return found;
+}
+
+std::vector<BinaryArray> DatabaseBlockchainCacheOverlay::getRawTransactions(const std::vector<Crypto::Hash>& transactions) const {
+  std::vector<Crypto::Hash> missed;
+  std::vector<BinaryArray> found;
+  getRawTransactions(transactions, found, missed);
+  return found;
+}
+
+bool DatabaseBlockchainCacheOverlay::getTransactionGlobalIndexes(const Crypto::Hash& transactionHash,
+                                                                 std::vector<uint32_t>& globalIndexes) const {
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  if (!root.requestTransactionInfos({transactionHash}, transactions, startIndex, topIndex)) {
+    logger(Logging::DEBUGGING) << "getTransactionGlobalIndexes failed: failed to read database";
+    return false;
+  }
+
+  auto it = transactions.find(transactionHash);
+  if (it == transactions.end()) {
+    return false;
+  }
+
+  globalIndexes = it->second.globalIndexes;
+  return true;
+}
+
+size_t DatabaseBlockchainCacheOverlay::getTransactionCount() const {
+  return static_cast<size_t>(root.getAlreadyGeneratedTransactions(topIndex));
+}
+
+uint32_t DatabaseBlockchainCacheOverlay::getBlockIndexContainingTx(const Crypto::Hash& transactionHash) const {
+  std::unordered_map<Crypto::Hash, ExtendedTransactionInfo> transactions;
+  if (!root.requestTransactionInfos({transactionHash}, transactions, startIndex, topIndex)) {
+    throw std::runtime_error("Failed to read transaction from database");
+  }
+
+  return transactions.at(transactionHash).blockIndex;
+}
+
+size_t DatabaseBlockchainCacheOverlay::getChildCount() const {
+  return children.size();
+}
+
+void DatabaseBlockchainCacheOverlay::addChild(IBlockchainCache* child) {
+  if (std::find(children.begin(), children.end(), child) == children.end()) {
+    children.push_back(child);
+  }
+}
+
+bool DatabaseBlockchainCacheOverlay::deleteChild(IBlockchainCache* child) {
+  auto it = std::remove(children.begin(), children.end(), child);
+  auto res = it != children.end();
+  children.erase(it, children.end());
+  return res;
+}
+
+// blocks are in data base already, the root segment deletes them if they aren't merged back
+void DatabaseBlockchainCacheOverlay::save() {
+}
+
+void DatabaseBlockchainCacheOverlay::load() {
+}
+
+RawBlock DatabaseBlockchainCacheOverlay::getBlockByIndex(uint32_t index) const {
+  if (index < startIndex) {
+    return parent->getBlockByIndex(index);
+  }
+
+  assert(index <= topIndex);
+  return hasRawBlocksCopy() ? rawBlocks[index - startIndex] : root.getBlockByIndex(index);
+}
+
+BinaryArray DatabaseBlockchainCacheOverlay::getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const {
+  if (blockIndex < startIndex) {
+    return parent->getRawTransaction(blockIndex, transactionIndex);
+  }
+
+  auto rawBlock = getBlockByIndex(blockIndex);
+  if (transactionIndex == 0) {
+    auto block = fromBinaryArray<BlockTemplate>(rawBlock.block);
+    return toBinaryArray(block.baseTransaction);
+  }
+
+  assert(rawBlock.transactions.size() >= transactionIndex);
+  return rawBlock.transactions[transactionIndex - 1];
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCacheOverlay::getTransactionHashes() const {
+  return root.requestTransactionHashes(startIndex, topIndex + 1, false);
+}
+
+std::vector<uint32_t> DatabaseBlockchainCacheOverlay::getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex) const {
+  return root.getRandomOutsByAmount(amount, count, blockIndex, topIndex);
+}
+
+ExtractOutputKeysResult DatabaseBlockchainCacheOverlay::extractKeyOutputs(
+    uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
+    std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
+                                          uint32_t globalIndex)> pred) const {
+  return root.extractKeyOutputs(amount, blockIndex, globalIndexes, std::move(pred), topIndex);
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCacheOverlay::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const {
+  return root.getTransactionHashesByPaymentId(paymentId, topIndex);
+}
+
+std::vector<Crypto::Hash> DatabaseBlockchainCacheOverlay::getBlockHashesByTimestamps(uint64_t timestampBegin,
+                                                                                     size_t secondsCount) const {
+  return root.getBlockHashesByTimestamps(timestampBegin, secondsCount, topIndex);
+}
+
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "IBlockchainCache.h"
+#include "Logging/LoggerRef.h"
+
+namespace CryptoNote {
+
+class DatabaseBlockchainCache;
+
+/*
+ * Segment split off the root DatabaseBlockchainCache. Its blocks [startIndex, topIndex] stay in data base
+ * and are read from there on request, so splitting the root doesn't copy them. Blocks pushed to a leaf overlay
+ * are written to data base too, the blocks above its top are deleted then. Only one chain of overlays
+ * reads data base above the root top, other children are BlockchainCache segments.
+ * If the root keeps raw blocks in the main chain storage, raw blocks of the overlay are copied to memory,
+ * because the storage replaces them when the main chain is switched.
+ */
+class DatabaseBlockchainCacheOverlay : public IBlockchainCache {
+public:
+  DatabaseBlockchainCacheOverlay(DatabaseBlockchainCache& root, IBlockchainCache* parent, uint32_t startIndex,
+                                 uint32_t topIndex, const Crypto::Hash& topBlockHash, std::vector<RawBlock>&& rawBlocks,
+                                 Logging::ILogger& logger);
+
+  std::unique_ptr<IBlockchainCache> split(uint32_t splitBlockIndex) override;
+  void truncate(uint32_t startIndex) override;
+  void pruneBlocks(uint32_t endIndex) override;
+  uint32_t getPrunedBlockCount() const override;
+  void pushBlock(const CachedBlock& cachedBlock, const std::vector<CachedTransaction>& cachedTransactions,
+                 const TransactionValidatorState& validatorState, size_t blockSize, uint64_t generatedCoins,
+                 Difficulty blockDifficulty, RawBlock&& rawBlock) override;
+  PushedBlockInfo getPushedBlockInfo(uint32_t index) const override;
+  bool checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const override;
+  bool checkIfSpent(const Crypto::KeyImage& keyImage) const override;
+  void prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const override;
+
+  bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const override;
+  bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const override;
+
+  ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
+                                               std::vector<Crypto::PublicKey>& publicKeys) const override;
+  ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
+                                               Common::ArrayView<uint32_t> globalIndexes,
+                                               std::vector<Crypto::PublicKey>& publicKeys) const override;
+
+  ExtractOutputKeysResult extractKeyOtputIndexes(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
+                                                 std::vector<PackedOutIndex>& outIndexes) const override;
+  ExtractOutputKeysResult
+  extractKeyOtputReferences(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
+                            std::vector<std::pair<Crypto::Hash, size_t>>& outputReferences) const override;
+
+  uint32_t getTopBlockIndex() const override;
+  const Crypto::Hash& getTopBlockHash() const override;
+  uint32_t getBlockCount() const override;
+  bool hasBlock(const Crypto::Hash& blockHash) const override;
+  uint32_t getBlockIndex(const Crypto::Hash& blockHash) const override;
+
+  bool hasTransaction(const Crypto::Hash& transactionHash) const override;
+
+  std::vector<uint64_t> getLastTimestamps(size_t count) const override;
+  std::vector<uint64_t> getLastTimestamps(size_t count, uint32_t blockIndex, UseGenesis) const override;
+
+  std::vector<uint64_t> getLastBlocksSizes(size_t count) const override;
+  std::vector<uint64_t> getLastBlocksSizes(size_t count, uint32_t blockIndex, UseGenesis) const override;
+
+  std::vector<Difficulty> getLastCumulativeDifficulties(size_t count, uint32_t blockIndex, UseGenesis) const override;
+  std::vector<Difficulty> getLastCumulativeDifficulties(size_t count) const override;
+
+  Difficulty getDifficultyForNextBlock() const override;
+  Difficulty getDifficultyForNextBlock(uint32_t blockIndex) const override;
+
+  Difficulty getCurrentCumulativeDifficulty() const override;
+  Difficulty getCurrentCumulativeDifficulty(uint32_t blockIndex) const override;
+
+  uint64_t getAlreadyGeneratedCoins() const override;
+  uint64_t getAlreadyGeneratedCoins(uint32_t blockIndex) const override;
+  uint64_t getAlreadyGeneratedTransactions(uint32_t blockIndex) const override;
+  std::vector<uint64_t> getLastUnits(size_t count, uint32_t blockIndex, UseGenesis use,
+                                     std::function<uint64_t(const CachedBlockInfo&)> pred) const override;
+
+  Crypto::Hash getBlockHash(uint32_t blockIndex) const override;
+  std::vector<Crypto::Hash> getBlockHashes(uint32_t startIndex, size_t maxCount) const override;
+
+  IBlockchainCache* getParent() const override;
+  void setParent(IBlockchainCache* parent) override;
+  uint32_t getStartBlockIndex() const override;
+
+  size_t getKeyOutputsCountForAmount(uint64_t amount, uint32_t blockIndex) const override;
+
+  uint32_t getTimestampLowerBoundBlockIndex(uint64_t timestamp) const override;
+
+  void getRawTransactions(const std::vector<Crypto::Hash>& transactions, std::vector<BinaryArray>& foundTransactions,
+                          std::vector<Crypto::Hash>& missedTransactions) const override;
+  std::vector<BinaryArray> getRawTransactions(const std::vector<Crypto::Hash>& transactions,
+                                              std::vector<Crypto::Hash>& missedTransactions) const override;
+  std::vector<BinaryArray> getRawTransactions(const std::vector<Crypto::Hash>& transactions) const override;
+
+  bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const override;
+  size_t getTransactionCount() const override;
+  uint32_t getBlockIndexContainingTx(const Crypto::Hash& transactionHash) const override;
+
+  size_t getChildCount() const override;
+  void addChild(IBlockchainCache* child) override;
+  bool deleteChild(IBlockchainCache* child) override;
+
+  void save() override;
+  void load() override;
+
+  RawBlock getBlockByIndex(uint32_t index) const override;
+  BinaryArray getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const override;
+  std::vector<Crypto::Hash> getTransactionHashes() const override;
+  std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex) const override;
+  ExtractOutputKeysResult
+  extractKeyOutputs(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
+                    std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
+                                                          uint32_t globalIndex)> pred) const override;
+
+  std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+  std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
+
+private:
+  DatabaseBlockchainCache& root;
+  IBlockchainCache* parent;
+  uint32_t startIndex;
+  uint32_t topIndex;
+  Crypto::Hash topBlockHash;
+  std::vector<IBlockchainCache*> children;
+  // blocks [startIndex, topIndex] if the root keeps raw blocks in the main chain storage
+  std::vector<RawBlock> rawBlocks;
+  Logging::LoggerRef logger;
+
+  bool hasRawBlocksCopy() const;
+  boost::optional<uint32_t> requestBlockIndex(const Crypto::Hash& blockHash) const;
+};
+
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DifficultyCache.h"
+
+#include <cassert>
+#include <iterator>
+
+#include "CryptoNoteCore/Currency.h"
+
+namespace CryptoNote {
+
+DifficultyCache::DifficultyCache(const Currency& currency) : currency(currency) {
+}
+
+bool DifficultyCache::isLoaded(uint32_t blockIndex) const {
+  return topBlockIndex && *topBlockIndex == blockIndex;
+}
+
+void DifficultyCache::load(uint32_t blockIndex, const std::vector<uint64_t>& timestamps, const std::vector<Difficulty>& cumulativeDifficulties) {
+  assert(timestamps.size() == cumulativeDifficulties.size());
+
+  reset();
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    push(timestamps[i], cumulativeDifficulties[i]);
+  }
+
+  topBlockIndex = blockIndex;
+}
+
+void DifficultyCache::push(uint32_t blockIndex, uint64_t timestamp, Difficulty cumulativeDifficulty) {
+  if (!topBlockIndex || *topBlockIndex + 1 != blockIndex) {
+    reset();
+    return;
+  }
+
+  push(timestamp, cumulativeDifficulty);
+  topBlockIndex = blockIndex;
+}
+
+void DifficultyCache::reset() {
+  topBlockIndex = boost::none;
+  window.clear();
+  lag.clear();
+  sortedTimestamps.clear();
+  nextDifficulty = boost::none;
+}
+
+Difficulty DifficultyCache::getNextDifficulty() const {
+  assert(topBlockIndex);
+
+  if (!nextDifficulty) {
+    size_t length = window.size();
+    if (length <= 1) {
+      nextDifficulty = 1;
+    } else {
+      size_t cutBegin;
+      size_t cutEnd;
+      currency.getDifficultyCut(length, cutBegin, cutEnd);
+
+      // both cut bounds are within difficultyCut of the window ends
+      auto first = std::next(sortedTimestamps.begin(), cutBegin);
+      auto last = std::prev(sortedTimestamps.end(), length - cutEnd + 1);
+      nextDifficulty = currency.getDifficultyForWork(window[cutEnd - 1].second - window[cutBegin].second, *last - *first);
+    }
+  }
+
+  return *nextDifficulty;
+}
+
+void DifficultyCache::push(uint64_t timestamp, Difficulty cumulativeDifficulty) {
+  nextDifficulty = boost::none;
+
+  if (lag.empty() && window.size() < currency.difficultyWindow()) {
+    window.emplace_back(timestamp, cumulativeDifficulty);
+    sortedTimestamps.insert(timestamp);
+    return;
+  }
+
+  lag.emplace_back(timestamp, cumulativeDifficulty);
+  if (lag.size() > currency.difficultyLag()) {
+    sortedTimestamps.erase(sortedTimestamps.find(window.front().first));
+    window.pop_front();
+
+    window.push_back(lag.front());
+    sortedTimestamps.insert(lag.front().first);
+    lag.pop_front();
+  }
+}
+
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <deque>
+#include <set>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "CryptoNoteCore/Difficulty.h"
+
+namespace CryptoNote {
+
+class Currency;
+
+// Timestamps and cumulative difficulties of the blocks which determine difficulty of the block following
+// a segment top. Segments keep it up to date on push, so that the whole window isn't reread from
+// the storage for every next difficulty calculation.
+class DifficultyCache {
+public:
+  explicit DifficultyCache(const Currency& currency);
+
+  // Whether the cache holds the window of a segment with top block blockIndex
+  bool isLoaded(uint32_t blockIndex) const;
+  // timestamps and cumulative difficulties of up to difficultyBlocksCount blocks, genesis block excluded
+  void load(uint32_t blockIndex, const std::vector<uint64_t>& timestamps, const std::vector<Difficulty>& cumulativeDifficulties);
+  // Appends a block pushed to the segment, the cache is reset if the block doesn't follow the cached top
+  void push(uint32_t blockIndex, uint64_t timestamp, Difficulty cumulativeDifficulty);
+  void reset();
+
+  Difficulty getNextDifficulty() const;
+
+private:
+  void push(uint64_t timestamp, Difficulty cumulativeDifficulty);
+
+  const Currency& currency;
+  boost::optional<uint32_t> topBlockIndex;
+  // blocks taken into account by difficulty calculation, followed by difficultyLag most recent blocks
+  std::deque<std::pair<uint64_t, Difficulty>> window;
+  std::deque<std::pair<uint64_t, Difficulty>> lag;
+  std::multiset<uint64_t> sortedTimestamps;
+  mutable boost::optional<Difficulty> nextDifficulty;
+};
+
+}
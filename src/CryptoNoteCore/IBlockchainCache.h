@@ -86,6 +86,12 @@ public:
   virtual RawBlock getBlockByIndex(uint32_t index) const = 0;
   virtual BinaryArray getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const = 0;
   virtual std::unique_ptr<IBlockchainCache> split(uint32_t splitBlockIndex) = 0;
+  // Removes blocks starting from startIndex. Unlike split it doesn't move them to a new segment
+  virtual void truncate(uint32_t startIndex) = 0;
+  // Drops transactions of blocks with indexes below endIndex, only headers are returned for them then. Key images,
+  // outputs and global indexes stay, so validation and output selection work as before. Pruned blocks can't be split off
+  virtual void pruneBlocks(uint32_t endIndex) = 0;
+  virtual uint32_t getPrunedBlockCount() const = 0;
   virtual void pushBlock(
       const CachedBlock& cachedBlock,
       const std::vector<CachedTransaction>& cachedTransactions,
@@ -97,6 +103,9 @@ public:
   virtual PushedBlockInfo getPushedBlockInfo(uint32_t index) const = 0;
   virtual bool checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const = 0;
   virtual bool checkIfSpent(const Crypto::KeyImage& keyImage) const = 0;
+  // Reads key images and key outputs referenced by the inputs with a single storage request, so the following checkIfSpent
+  // and extractKeyOutputKeys calls for them are answered from memory. Prefetched data is dropped when the chain changes
+  virtual void prefetchKeyInputs(const std::vector<const KeyInput*>& inputs) const = 0;
 
   virtual bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const = 0;
   virtual bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const = 0;
@@ -21,6 +21,7 @@
 
 namespace CryptoNote {
 
+class BlockchainReadSnapshot;
 class IBlockchainCache;
 class Currency;
 
@@ -30,6 +31,12 @@ public:
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) = 0;
   virtual std::unique_ptr<IBlockchainCache> createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex = 0) = 0;
+
+  // Snapshot of blocks [0, topBlockIndex] kept in a data base by the root cache, nullptr if there is no such data base
+  // or raw blocks aren't kept in it
+  // or it can't provide a snapshot right now.
+  // Data base may keep blocks above the root top for segments split off it, they aren't part of the snapshot
+  virtual std::unique_ptr<BlockchainReadSnapshot> createReadSnapshot(uint32_t topBlockIndex) = 0;
 };
 
 } //namespace CryptoNote
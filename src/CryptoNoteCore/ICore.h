@@ -47,6 +47,8 @@ public:
   virtual Crypto::Hash getTopBlockHash() const = 0;
   virtual Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const = 0;
   virtual uint64_t getBlockTimestampByIndex(uint32_t blockIndex) const = 0;
+  // blocks with indexes below it are kept without transactions and can't be served to peers
+  virtual uint32_t getPrunedBlockCount() const = 0;
 
   virtual bool hasBlock(const Crypto::Hash& blockHash) const = 0;
   virtual BlockTemplate getBlockByIndex(uint32_t index) const = 0;
@@ -85,6 +87,9 @@ public:
                                 std::vector<Crypto::PublicKey>& publicKeys) const = 0;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) = 0;
+  // transactions are parsed and their signatures are checked in parallel, then they are pushed to the pool in order;
+  // the i-th result tells if the i-th transaction was added
+  virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) = 0;
   
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const = 0;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
@@ -93,6 +98,11 @@ public:
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                                   std::vector<TransactionPrefixInfo>& addedTransactions,
                                   std::vector<Crypto::Hash>& deletedTransactions) const = 0;
+  // sequence is the pool change sequence number got by the previous call and is set to the current one; if the pool
+  // no longer logs changes since it, fullResync is set and addedTransactions holds the whole pool
+  virtual bool getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t& sequence,
+                                   std::vector<TransactionPrefixInfo>& addedTransactions,
+                                   std::vector<Crypto::Hash>& deletedTransactions, bool& fullResync) const = 0;
 
   virtual bool getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, const BinaryArray& extraNonce,
                                 Difficulty& difficulty, uint32_t& height) const = 0;
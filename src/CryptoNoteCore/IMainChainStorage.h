@@ -31,6 +31,11 @@ public:
   virtual RawBlock getBlockByIndex(uint32_t index) const = 0;
   virtual uint32_t getBlockCount() const = 0;
 
+  // Drops blocks with indexes below endIndex, indexes of the other blocks stay the same.
+  // Dropped blocks can't be read or popped
+  virtual void pruneBlocks(uint32_t endIndex) = 0;
+  virtual uint32_t getPrunedBlockCount() const = 0;
+
   virtual void clear() = 0;
 };
 
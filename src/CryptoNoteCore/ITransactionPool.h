@@ -16,6 +16,8 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <functional>
+
 #include "CachedTransaction.h"
 
 namespace CryptoNote {
@@ -24,19 +26,33 @@ struct TransactionValidatorState;
 
 class ITransactionPool {
 public:
-  virtual bool pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState) = 0;
+  // transactions evicted to keep the pool within its size limit are appended to evictedTransactions
+  virtual bool pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState,
+                               std::vector<Crypto::Hash>& evictedTransactions) = 0;
   virtual const CachedTransaction& getTransaction(const Crypto::Hash& hash) const = 0;
   virtual bool removeTransaction(const Crypto::Hash& hash) = 0;
 
   virtual size_t getTransactionCount() const = 0;
+  virtual uint64_t getTransactionsSize() const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashes() const = 0;
   virtual bool checkIfTransactionPresent(const Crypto::Hash& hash) const = 0;
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const = 0;
   virtual std::vector<CachedTransaction> getPoolTransactions() const = 0;
+  // visit transactions from the most or the least profitable one while the visitor returns true
+  virtual void forEachTransaction(bool mostProfitableFirst, const std::function<bool (const CachedTransaction&)>& visitor) const = 0;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const = 0;
+  // hashes of transactions received before the time, the oldest first
+  virtual std::vector<Crypto::Hash> getTransactionHashesReceivedBefore(uint64_t time) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
+
+  // sequence number the next added or removed transaction gets
+  virtual uint64_t getChangeSequence() const = 0;
+  // transactions added and removed since the sequence number, only the last change of a transaction is reported;
+  // returns false if the sequence number is not in the change log anymore
+  virtual bool getChangesSince(uint64_t sequence, std::vector<Crypto::Hash>& addedTransactions,
+                               std::vector<Crypto::Hash>& deletedTransactions) const = 0;
 };
 
 }
@@ -0,0 +1,92 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "KeyImageFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t BITS_PER_KEY_IMAGE = 16;
+const size_t BITS_PER_BLOCK = 512;
+const size_t BITS_PER_KEY_IMAGE_IN_BLOCK = 8;
+// bytes 0-7 select the block, each of the following pairs selects a bit in it
+const size_t BIT_POSITIONS_OFFSET = 8;
+
+uint64_t readWord(const uint8_t* data) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+size_t getBitPosition(const Crypto::KeyImage& keyImage, size_t index) {
+  const uint8_t* data = keyImage.data + BIT_POSITIONS_OFFSET + 2 * index;
+  return (static_cast<size_t>(data[0]) | static_cast<size_t>(data[1]) << 8) % BITS_PER_BLOCK;
+}
+
+}
+
+KeyImageFilter::KeyImageFilter(size_t capacity) {
+  reset(capacity);
+}
+
+void KeyImageFilter::reset(size_t capacity) {
+  size_t blockCount = std::max<size_t>(1, (capacity * BITS_PER_KEY_IMAGE + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK);
+
+  blocks.assign(blockCount, Block());
+  this->capacity = capacity;
+  count = 0;
+}
+
+void KeyImageFilter::add(const Crypto::KeyImage& keyImage) {
+  Block& block = blocks[getBlockIndex(keyImage)];
+  for (size_t i = 0; i < BITS_PER_KEY_IMAGE_IN_BLOCK; ++i) {
+    size_t position = getBitPosition(keyImage, i);
+    block[position / 64] |= uint64_t(1) << (position % 64);
+  }
+
+  ++count;
+}
+
+bool KeyImageFilter::mayContain(const Crypto::KeyImage& keyImage) const {
+  const Block& block = blocks[getBlockIndex(keyImage)];
+  for (size_t i = 0; i < BITS_PER_KEY_IMAGE_IN_BLOCK; ++i) {
+    size_t position = getBitPosition(keyImage, i);
+    if ((block[position / 64] & (uint64_t(1) << (position % 64))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t KeyImageFilter::getCount() const {
+  return count;
+}
+
+size_t KeyImageFilter::getCapacity() const {
+  return capacity;
+}
+
+size_t KeyImageFilter::getBlockIndex(const Crypto::KeyImage& keyImage) const {
+  return static_cast<size_t>(readWord(keyImage.data) % blocks.size());
+}
+
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+struct KeyImageFilterStatistics {
+  uint64_t lookups = 0;
+  uint64_t filteredOut = 0; //lookups answered by the filter alone
+  uint64_t falsePositives = 0; //lookups passed by the filter for absent key images
+
+  // Share of absent key images the filter failed to answer
+  double getFalsePositiveRate() const {
+    return falsePositives + filteredOut == 0 ? 0 : static_cast<double>(falsePositives) / (falsePositives + filteredOut);
+  }
+};
+
+// Blocked Bloom filter over key images. All bits of a key image are set in one 64 byte block, so a lookup
+// touches a single cache line. Key images are uniformly distributed, so their bytes are used as hashes.
+// Key images can't be removed, stale ones only raise the false positive rate until the filter is reset.
+class KeyImageFilter {
+public:
+  explicit KeyImageFilter(size_t capacity = 0);
+
+  // Clears the filter and sizes it for the given number of key images
+  void reset(size_t capacity);
+
+  void add(const Crypto::KeyImage& keyImage);
+  bool mayContain(const Crypto::KeyImage& keyImage) const;
+
+  size_t getCount() const;
+  size_t getCapacity() const;
+
+private:
+  typedef std::array<uint64_t, 8> Block;
+
+  size_t getBlockIndex(const Crypto::KeyImage& keyImage) const;
+
+  std::vector<Block> blocks;
+  size_t capacity;
+  size_t count;
+};
+
+}
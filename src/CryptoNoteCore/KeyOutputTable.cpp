@@ -0,0 +1,122 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "KeyOutputTable.h"
+
+#include <cassert>
+
+namespace CryptoNote {
+
+KeyOutputTable::KeyOutputTable(const std::string& filename) {
+  entries.open(filename, Common::FileMappedVectorOpenMode::OPEN_OR_CREATE, sizeof(Header));
+  entries.setAutoFlush(false);
+
+  // rows written after the last flush may be lost or come back zero filled, so only the flushed ones are kept.
+  // Every block has a coinbase output, a table with blocks and no rows is left by an older version and built again
+  blockCount = header().flushedBlockCount;
+  uint64_t size = header().flushedRowCount;
+  if (size > entries.size() || (size == 0 && blockCount != 0)) {
+    blockCount = 0;
+    size = 0;
+  }
+
+  if (size < entries.size()) {
+    entries.erase(entries.cbegin() + size, entries.cend());
+  }
+
+  for (uint64_t position = 0; position < entries.size(); ++position) {
+    positionsByAmount[entries[position].amount].push_back(static_cast<uint32_t>(position));
+  }
+}
+
+KeyOutputTable::~KeyOutputTable() {
+  flush();
+}
+
+uint32_t KeyOutputTable::getBlockCount() const {
+  return blockCount;
+}
+
+void KeyOutputTable::pushBlock(uint32_t blockIndex, const std::vector<KeyOutputTableEntry>& blockEntries) {
+  assert(blockIndex == blockCount);
+
+  uint64_t position = entries.size();
+  for (const auto& entry: blockEntries) {
+    assert(entry.location.blockIndex == blockIndex);
+    positionsByAmount[entry.amount].push_back(static_cast<uint32_t>(position++));
+  }
+
+  entries.insert(entries.cend(), blockEntries.begin(), blockEntries.end());
+  ++blockCount;
+}
+
+void KeyOutputTable::truncate(uint32_t startIndex) {
+  if (startIndex >= blockCount) {
+    return;
+  }
+
+  uint64_t size = entries.size();
+  while (size > 0 && entries[size - 1].location.blockIndex >= startIndex) {
+    --size;
+
+    auto it = positionsByAmount.find(entries[size].amount);
+    assert(it != positionsByAmount.end() && it->second.back() == size);
+    it->second.pop_back();
+    if (it->second.empty()) {
+      positionsByAmount.erase(it);
+    }
+  }
+
+  // removed rows are overwritten by the next pushes, they must not be trusted on open
+  if (startIndex < header().flushedBlockCount) {
+    header().flushedBlockCount = startIndex;
+    header().flushedRowCount = static_cast<uint32_t>(size);
+    entries.flush();
+  }
+
+  entries.erase(entries.cbegin() + size, entries.cend());
+  blockCount = startIndex;
+}
+
+void KeyOutputTable::flush() {
+  entries.flush();
+  if (header().flushedBlockCount != blockCount) {
+    header().flushedBlockCount = blockCount;
+    header().flushedRowCount = static_cast<uint32_t>(entries.size());
+    entries.flush();
+  }
+}
+
+uint32_t KeyOutputTable::getOutputCount(uint64_t amount) const {
+  auto it = positionsByAmount.find(amount);
+  return it == positionsByAmount.end() ? 0 : static_cast<uint32_t>(it->second.size());
+}
+
+const KeyOutputTableEntry* KeyOutputTable::find(uint64_t amount, uint32_t globalIndex) const {
+  auto it = positionsByAmount.find(amount);
+  if (it == positionsByAmount.end() || globalIndex >= it->second.size()) {
+    return nullptr;
+  }
+
+  return &entries[it->second[globalIndex]];
+}
+
+KeyOutputTable::Header& KeyOutputTable::header() {
+  return *reinterpret_cast<Header*>(entries.prefix());
+}
+
+}
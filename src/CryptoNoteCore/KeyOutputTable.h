@@ -0,0 +1,69 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Common/FileMappedVector.h"
+#include "IBlockchainCache.h"
+
+namespace CryptoNote {
+
+struct KeyOutputTableEntry {
+  uint64_t amount;
+  Crypto::PublicKey publicKey;
+  PackedOutIndex location;
+  uint64_t unlockTime;
+};
+
+// Key outputs of the main chain in the order they were pushed, so the global index of an output is its position
+// among the outputs with the same amount. Everything needed to pick and check a mixin is in one row of a mapped file,
+// rows are located through per amount arrays of positions which are restored from the file on open.
+class KeyOutputTable {
+public:
+  explicit KeyOutputTable(const std::string& filename);
+  ~KeyOutputTable();
+
+  // Blocks which outputs are in the table, blocks that weren't flushed are dropped on open
+  uint32_t getBlockCount() const;
+
+  // blockIndex must be equal to the block count
+  void pushBlock(uint32_t blockIndex, const std::vector<KeyOutputTableEntry>& entries);
+  // removes blocks with indexes greater or equal to startIndex
+  void truncate(uint32_t startIndex);
+  void flush();
+
+  uint32_t getOutputCount(uint64_t amount) const;
+  // returns nullptr if there is no such output
+  const KeyOutputTableEntry* find(uint64_t amount, uint32_t globalIndex) const;
+
+private:
+  struct Header {
+    uint32_t flushedBlockCount;
+    uint32_t flushedRowCount;
+  };
+
+  Header& header();
+
+  Common::FileMappedVector<KeyOutputTableEntry> entries;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> positionsByAmount;
+  uint32_t blockCount;
+};
+
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace CryptoNote {
+
+struct LruCacheStatistics {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+
+  double getHitRate() const {
+    return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+// Keeps the most recently used values within a memory budget. sizeOf estimates memory a value owns besides itself,
+// it may be omitted for plain structures. List and hash table nodes are accounted with a fixed overhead per item.
+template<class Key, class Value, class Hash = std::hash<Key>>
+class LruCache {
+public:
+  using SizeOf = std::function<size_t(const Value&)>;
+
+  explicit LruCache(size_t budget, SizeOf sizeOf = nullptr) : budget(budget), byteSize(0), sizeOf(std::move(sizeOf)) {
+  }
+
+  // returns nullptr if there is no such value, the pointer is valid until the cache is modified
+  const Value* find(const Key& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+      ++statistics.misses;
+      return nullptr;
+    }
+
+    ++statistics.hits;
+    items.splice(items.begin(), items, it->second);
+    return &it->second->value;
+  }
+
+  void insert(const Key& key, const Value& value) {
+    erase(key);
+
+    size_t itemSize = (sizeOf ? sizeOf(value) : 0) + sizeof(Item) + ITEM_OVERHEAD;
+    if (itemSize > budget) {
+      return;
+    }
+
+    items.push_front(Item{key, value, itemSize});
+    index.emplace(key, items.begin());
+    byteSize += itemSize;
+
+    while (byteSize > budget) {
+      byteSize -= items.back().size;
+      index.erase(items.back().key);
+      items.pop_back();
+    }
+  }
+
+  void erase(const Key& key) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      byteSize -= it->second->size;
+      items.erase(it->second);
+      index.erase(it);
+    }
+  }
+
+  void clear() {
+    items.clear();
+    index.clear();
+    byteSize = 0;
+  }
+
+  size_t getCount() const {
+    return items.size();
+  }
+
+  size_t getByteSize() const {
+    return byteSize;
+  }
+
+  const LruCacheStatistics& getStatistics() const {
+    return statistics;
+  }
+
+private:
+  struct Item {
+    Key key;
+    Value value;
+    size_t size;
+  };
+
+  // list node pointers and hash table node with its bucket
+  static const size_t ITEM_OVERHEAD = 4 * sizeof(void*) + sizeof(Key);
+
+  size_t budget;
+  size_t byteSize;
+  SizeOf sizeOf;
+  std::list<Item> items;
+  std::unordered_map<Key, typename std::list<Item>::iterator, Hash> index;
+  LruCacheStatistics statistics;
+};
+
+}
@@ -17,53 +17,215 @@
 
 #include "MainChainStorage.h"
 
+#include <cstring>
+
 #include <boost/filesystem.hpp>
 
+#include "Common/MemoryInputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+
 #include "CryptoNoteTools.h"
+#include "SwappedVector.h"
 
 namespace CryptoNote {
 
-const size_t STORAGE_CACHE_SIZE = 100;
+const size_t SWAPPED_STORAGE_CACHE_SIZE = 100;
+// the blocks file is extended in place by this many bytes instead of being copied to a larger one
+const uint64_t BLOCKS_GROWTH_STEP = 256 * 1024 * 1024;
+const char MAPPED_STORAGE_EXTENSION[] = ".dat";
+const char IMPORTED_STORAGE_EXTENSION[] = ".import";
 
 MainChainStorage::MainChainStorage(const std::string& blocksFilename, const std::string& indexesFilename) {
-  if (!storage.open(blocksFilename, indexesFilename, STORAGE_CACHE_SIZE)) {
-    throw std::runtime_error("Failed to load main chain storage: " + blocksFilename);
+  open(blocksFilename, indexesFilename);
+}
+
+MainChainStorage::MainChainStorage(const std::string& blocksFilename, const std::string& indexesFilename,
+  const std::string& swappedBlocksFilename, const std::string& swappedIndexesFilename) {
+
+  // the swapped storage is removed only after the imported files replace the storage ones,
+  // so an interrupted import is started over on the next start
+  if (boost::filesystem::exists(swappedBlocksFilename) && boost::filesystem::exists(swappedIndexesFilename)) {
+    importSwappedStorage(blocksFilename, indexesFilename, swappedBlocksFilename, swappedIndexesFilename);
   }
+
+  open(blocksFilename, indexesFilename);
 }
 
 MainChainStorage::~MainChainStorage() {
-  storage.close();
+  blocks.flush();
+  blockEnds.flush();
+}
+
+void MainChainStorage::open(const std::string& blocksFilename, const std::string& indexesFilename) {
+  blocks.open(blocksFilename);
+  blockEnds.open(indexesFilename);
+
+  // pages are written back by the OS, the same way the stream based storage relied on
+  blocks.setAutoFlush(false);
+  blockEnds.setAutoFlush(false);
+  blocks.setGrowthStep(BLOCKS_GROWTH_STEP);
+
+  // an interrupted growth leaves the suffix followed by the bytes the file was extended with
+  if (blocks.suffixSize() > sizeof(PrunedBlocks)) {
+    blocks.resizeSuffix(sizeof(PrunedBlocks));
+  }
+
+  // blocks are appended before their index entry and truncated after it is removed,
+  // so an interrupted push or pop leaves only unindexed bytes or an entry without its block
+  while (!blockEnds.empty() && blockEnds.back() > getBlocksEnd()) {
+    blockEnds.pop_back();
+  }
+
+  // an interrupted clear leaves pruned bytes without their index entries
+  if (blockEnds.size() < getPrunedBlocks().blockCount) {
+    clear();
+    return;
+  }
+
+  uint64_t blocksSize = blockEnds.empty() ? 0 : blockEnds.back();
+  if (getBlocksEnd() > blocksSize) {
+    blocks.erase(blocks.cbegin() + (blocksSize - getPrunedBlocks().byteCount), blocks.cend());
+  }
 }
 
 void MainChainStorage::pushBlock(const RawBlock& rawBlock) {
-  storage.push_back(rawBlock);
+  BinaryArray serializedBlock = toBinaryArray(rawBlock);
+  blocks.insert(blocks.cend(), serializedBlock.begin(), serializedBlock.end());
+  blockEnds.push_back(getBlocksEnd());
 }
 
 void MainChainStorage::popBlock() {
-  storage.pop_back();
+  if (blockEnds.empty()) {
+    throw std::runtime_error("Failed to pop block from main chain storage: storage is empty");
+  }
+
+  PrunedBlocks pruned = getPrunedBlocks();
+  if (blockEnds.size() <= pruned.blockCount) {
+    throw std::runtime_error("Failed to pop block from main chain storage: block is pruned");
+  }
+
+  blockEnds.pop_back();
+  blocks.erase(blocks.cbegin() + (getBlockOffset(static_cast<uint32_t>(blockEnds.size())) - pruned.byteCount), blocks.cend());
 }
 
 RawBlock MainChainStorage::getBlockByIndex(uint32_t index) const {
-  if (index >= storage.size()) {
-    throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Blocks count: " + std::to_string(storage.size()));
+  if (index >= blockEnds.size()) {
+    throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Blocks count: " + std::to_string(blockEnds.size()));
+  }
+
+  PrunedBlocks pruned = getPrunedBlocks();
+  if (index < pruned.blockCount) {
+    throw std::out_of_range("Block index " + std::to_string(index) + " is pruned. Pruned blocks count: " + std::to_string(pruned.blockCount));
   }
 
-  return storage[index];
+  // deserialized right from the mapped file, no read calls and no intermediate buffer
+  uint64_t offset = getBlockOffset(index);
+  Common::MemoryInputStream stream(blocks.data() + (offset - pruned.byteCount), static_cast<size_t>(blockEnds[index] - offset));
+  BinaryInputStreamSerializer serializer(stream);
+
+  RawBlock rawBlock;
+  serialize(rawBlock, serializer);
+  return rawBlock;
 }
 
 uint32_t MainChainStorage::getBlockCount() const {
-  return static_cast<uint32_t>(storage.size());
+  return static_cast<uint32_t>(blockEnds.size());
+}
+
+void MainChainStorage::pruneBlocks(uint32_t endIndex) {
+  endIndex = std::min(endIndex, getBlockCount());
+  if (endIndex <= getPrunedBlocks().blockCount) {
+    return;
+  }
+
+  if (blocks.suffixSize() < sizeof(PrunedBlocks)) {
+    blocks.resizeSuffix(sizeof(PrunedBlocks));
+  }
+
+  PrunedBlocks newPruned = { blockEnds[endIndex - 1], endIndex, 0 };
+  uint64_t droppedSize = newPruned.byteCount - getPrunedBlocks().byteCount;
+
+  // the remaining blocks and the new suffix are written to a file replacing the old one, a crash leaves either of them.
+  // The new file has the old capacity, so it is shrunk after that to give the space back
+  blocks.atomicUpdate([this, droppedSize, &newPruned](Common::FileMappedVector<uint8_t>& newBlocks) {
+    newBlocks.setAutoFlush(false);
+    newBlocks.insert(newBlocks.cend(), blocks.cbegin() + droppedSize, blocks.cend());
+    std::memcpy(newBlocks.suffix(), &newPruned, sizeof(newPruned));
+  });
+
+  blocks.shrink_to_fit();
+}
+
+uint32_t MainChainStorage::getPrunedBlockCount() const {
+  return getPrunedBlocks().blockCount;
 }
 
 void MainChainStorage::clear() {
-  storage.clear();
+  blockEnds.clear();
+  blocks.clear();
+
+  if (blocks.suffixSize() >= sizeof(PrunedBlocks)) {
+    std::memset(blocks.suffix(), 0, sizeof(PrunedBlocks));
+    blocks.flush();
+  }
 }
 
-std::unique_ptr<IMainChainStorage> createSwappedMainChainStorage(const std::string& dataDir, const Currency& currency) {
-  boost::filesystem::path blocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
-  boost::filesystem::path indexesFilename = boost::filesystem::path(dataDir) / currency.blockIndexesFileName();
+MainChainStorage::PrunedBlocks MainChainStorage::getPrunedBlocks() const {
+  PrunedBlocks pruned = { 0, 0, 0 };
+  if (blocks.suffixSize() >= sizeof(PrunedBlocks)) {
+    std::memcpy(&pruned, blocks.suffix(), sizeof(pruned));
+  }
+
+  return pruned;
+}
+
+uint64_t MainChainStorage::getBlockOffset(uint32_t index) const {
+  return index == 0 ? 0 : blockEnds[index - 1];
+}
+
+uint64_t MainChainStorage::getBlocksEnd() const {
+  return getPrunedBlocks().byteCount + blocks.size();
+}
+
+void MainChainStorage::importSwappedStorage(const std::string& blocksFilename, const std::string& indexesFilename,
+  const std::string& swappedBlocksFilename, const std::string& swappedIndexesFilename) {
+  std::string importedBlocksFilename = blocksFilename + IMPORTED_STORAGE_EXTENSION;
+  std::string importedIndexesFilename = indexesFilename + IMPORTED_STORAGE_EXTENSION;
+
+  {
+    SwappedVector<RawBlock> swappedStorage;
+    if (!swappedStorage.open(swappedBlocksFilename, swappedIndexesFilename, SWAPPED_STORAGE_CACHE_SIZE)) {
+      throw std::runtime_error("Failed to load main chain storage: " + swappedBlocksFilename);
+    }
+
+    // files left by an interrupted import are written again from the beginning
+    MainChainStorage importedStorage(importedBlocksFilename, importedIndexesFilename);
+    importedStorage.clear();
+    importedStorage.blocks.reserve(boost::filesystem::file_size(swappedBlocksFilename));
+    importedStorage.blockEnds.reserve(swappedStorage.size());
+    for (uint64_t i = 0; i < swappedStorage.size(); ++i) {
+      importedStorage.pushBlock(swappedStorage[i]);
+    }
+  }
+
+  boost::filesystem::rename(importedIndexesFilename, indexesFilename);
+  boost::filesystem::rename(importedBlocksFilename, blocksFilename);
+
+  boost::filesystem::remove(swappedBlocksFilename);
+  boost::filesystem::remove(swappedIndexesFilename);
+}
+
+std::unique_ptr<IMainChainStorage> createMappedMainChainStorage(const std::string& dataDir, const Currency& currency) {
+  boost::filesystem::path swappedBlocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
+  boost::filesystem::path swappedIndexesFilename = boost::filesystem::path(dataDir) / currency.blockIndexesFileName();
+
+  boost::filesystem::path blocksFilename = swappedBlocksFilename;
+  blocksFilename.replace_extension(MAPPED_STORAGE_EXTENSION);
+  boost::filesystem::path indexesFilename = swappedIndexesFilename;
+  indexesFilename.replace_extension(MAPPED_STORAGE_EXTENSION);
 
-  std::unique_ptr<IMainChainStorage> storage(new MainChainStorage(blocksFilename.string(), indexesFilename.string()));
+  std::unique_ptr<IMainChainStorage> storage(new MainChainStorage(blocksFilename.string(), indexesFilename.string(),
+    swappedBlocksFilename.string(), swappedIndexesFilename.string()));
   if (storage->getBlockCount() == 0) {
     RawBlock genesis;
     genesis.block = toBinaryArray(currency.genesisBlock());
@@ -19,13 +19,16 @@
 
 #include "IMainChainStorage.h"
 #include "Currency.h"
-#include "SwappedVector.h"
+#include "Common/FileMappedVector.h"
 
 namespace CryptoNote {
 
 class MainChainStorage: public IMainChainStorage {
 public:
   MainChainStorage(const std::string& blocksFilame, const std::string& indexesFilename);
+  // imports blocks from the swapped storage files replacing the storage and removes them, if they exist
+  MainChainStorage(const std::string& blocksFilame, const std::string& indexesFilename,
+    const std::string& swappedBlocksFilename, const std::string& swappedIndexesFilename);
   virtual ~MainChainStorage();
 
   virtual void pushBlock(const RawBlock& rawBlock) override;
@@ -34,12 +37,33 @@ public:
   virtual RawBlock getBlockByIndex(uint32_t index) const override;
   virtual uint32_t getBlockCount() const override;
 
+  virtual void pruneBlocks(uint32_t endIndex) override;
+  virtual uint32_t getPrunedBlockCount() const override;
+
   virtual void clear() override;
 
 private:
-  mutable SwappedVector<RawBlock> storage;
+  // kept in the suffix of the blocks file, so it is replaced together with the bytes it describes.
+  // Files written before pruning have no suffix, nothing is pruned in them
+  struct PrunedBlocks {
+    uint64_t byteCount;
+    uint32_t blockCount;
+    uint32_t reserved;
+  };
+
+  PrunedBlocks getPrunedBlocks() const;
+  uint64_t getBlockOffset(uint32_t index) const;
+  uint64_t getBlocksEnd() const;
+  void open(const std::string& blocksFilename, const std::string& indexesFilename);
+  void importSwappedStorage(const std::string& blocksFilename, const std::string& indexesFilename,
+    const std::string& swappedBlocksFilename, const std::string& swappedIndexesFilename);
+
+  // serialized blocks one after another, blockEnds[i] is the offset right after the block with index i.
+  // Offsets are counted from the first block ever pushed, pruned bytes are cut from the beginning of blocks
+  Common::FileMappedVector<uint8_t> blocks;
+  Common::FileMappedVector<uint64_t> blockEnds;
 };
 
-std::unique_ptr<IMainChainStorage> createSwappedMainChainStorage(const std::string& dataDir, const Currency& currency);
+std::unique_ptr<IMainChainStorage> createMappedMainChainStorage(const std::string& dataDir, const Currency& currency);
 
 }
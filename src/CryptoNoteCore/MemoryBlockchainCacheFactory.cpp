@@ -17,6 +17,8 @@
 
 #include "MemoryBlockchainCacheFactory.h"
 
+#include "BlockchainReadSnapshot.h"
+
 namespace CryptoNote {
 
 MemoryBlockchainCacheFactory::MemoryBlockchainCacheFactory(const std::string& filename, Logging::ILogger& logger):
@@ -38,4 +40,8 @@ std::unique_ptr<IBlockchainCache> MemoryBlockchainCacheFactory::createBlockchain
   return std::unique_ptr<IBlockchainCache>(new BlockchainCache(filename, currency, logger, parent, startIndex));
 }
 
+std::unique_ptr<BlockchainReadSnapshot> MemoryBlockchainCacheFactory::createReadSnapshot(uint32_t topBlockIndex) {
+  return nullptr;
+}
+
 } //namespace CryptoNote
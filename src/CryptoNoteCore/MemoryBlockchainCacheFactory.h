@@ -30,6 +30,7 @@ public:
 
   std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) override;
   std::unique_ptr<IBlockchainCache> createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex = 0) override;
+  std::unique_ptr<BlockchainReadSnapshot> createReadSnapshot(uint32_t topBlockIndex) override;
 
 private:
   std::string filename;
@@ -18,11 +18,15 @@
 #include "RocksDBWrapper.h"
 
 #include "rocksdb/cache.h"
+#include "rocksdb/env.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
 #include "rocksdb/db.h"
 #include "rocksdb/utilities/backupable_db.h"
 
 #include "DataBaseErrors.h"
+#include "DBUtils.h"
 
 using namespace CryptoNote;
 using namespace Logging;
@@ -30,16 +34,204 @@ using namespace Logging;
 namespace {
   const std::string DB_NAME = "DB";
   const std::string TESTNET_DB_NAME = "testnet_DB";
+
+  const size_t SMALL_BLOCK_SIZE = 1024;
+  const size_t DEFAULT_BLOCK_SIZE = 4 * 1024;
+  const size_t RAW_BLOCK_BLOCK_SIZE = 64 * 1024;
+  const int BLOOM_FILTER_BITS_PER_KEY = 10;
+
+  // Column families are flushed one by one and bulk data has no write-ahead log, so after a crash in the middle of
+  // a bulk write some families may miss data others have. The key is synced before a bulk write and removed after
+  // every family is flushed, a data base still having it on open is recreated.
+  const std::string BULK_WRITE_MARKER_KEY = "unfinished_bulk_write";
+
+struct ColumnFamilyProfile {
+  std::string prefix;
+  // keyed by hashes and read by point lookups only: gets bloom filter and hash index
+  bool hashKeyed;
+  size_t blockSize;
+  bool compressed;
+};
+
+// every key prefix from DBUtils.h gets its own column family named after the prefix
+const std::vector<ColumnFamilyProfile> COLUMN_FAMILY_PROFILES = {
+  { DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, false, RAW_BLOCK_BLOCK_SIZE, true },
+  { DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, true, DEFAULT_BLOCK_SIZE, false },
+  { DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, true, SMALL_BLOCK_SIZE, false },
+  { DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, true, DEFAULT_BLOCK_SIZE, false },
+  { DB::KEY_OUTPUT_AMOUNT_PREFIX, false, SMALL_BLOCK_SIZE, false },
+  { DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::PAYMENT_ID_TO_TX_HASH_PREFIX, true, DEFAULT_BLOCK_SIZE, false },
+  { DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, false, DEFAULT_BLOCK_SIZE, false },
+  { DB::KEY_OUTPUT_KEY_PREFIX, false, SMALL_BLOCK_SIZE, false }
+};
+
+// which compression libraries are linked depends on the platform RocksDB was built on
+bool isCompressionSupported(rocksdb::CompressionType compression) {
+  std::unique_ptr<rocksdb::Env> env(rocksdb::NewMemEnv(rocksdb::Env::Default()));
+
+  rocksdb::Options options;
+  options.env = env.get();
+  options.create_if_missing = true;
+  options.compression = compression;
+
+  rocksdb::DB* dbPtr;
+  rocksdb::Status status = rocksdb::DB::Open(options, "/compression", &dbPtr);
+  if (!status.ok()) {
+    return false;
+  }
+
+  delete dbPtr;
+  return true;
 }
 
-RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED){
+rocksdb::CompressionType getSupportedCompression() {
+  for (auto compression : { rocksdb::kLZ4Compression, rocksdb::kSnappyCompression, rocksdb::kZlibCompression }) {
+    if (isCompressionSupported(compression)) {
+      return compression;
+    }
+  }
 
+  return rocksdb::kNoCompression;
 }
 
-RocksDBWrapper::~RocksDBWrapper() {
+rocksdb::ColumnFamilyOptions getColumnFamilyOptions(const DataBaseConfig& config, const ColumnFamilyProfile& profile,
+  const std::shared_ptr<rocksdb::Cache>& blockCache, rocksdb::CompressionType compression) {
+  rocksdb::ColumnFamilyOptions fOptions;
+  fOptions.write_buffer_size = static_cast<size_t>(config.getWriteBufferSize());
+  // merge two memtables when flushing to L0
+  fOptions.min_write_buffer_number_to_merge = 2;
+  // this means we'll use 50% extra memory in the worst case, but will reduce
+  // write stalls.
+  fOptions.max_write_buffer_number = 6;
+  // start flushing L0->L1 as soon as possible. each file on level0 is
+  // (memtable_memory_budget / 2). This will flush level 0 when it's bigger than
+  // memtable_memory_budget.
+  fOptions.level0_file_num_compaction_trigger = 20;
+
+  fOptions.level0_slowdown_writes_trigger = 30;
+  fOptions.level0_stop_writes_trigger = 40;
+
+  // doesn't really matter much, but we don't want to create too many files
+  fOptions.target_file_size_base = config.getWriteBufferSize() / 10;
+  // make Level1 size equal to Level0 size, so that L0->L1 compactions are fast
+  fOptions.max_bytes_for_level_base = config.getWriteBufferSize();
+  fOptions.num_levels = 10;
+  fOptions.target_file_size_multiplier = 2;
+  // level style compaction
+  fOptions.compaction_style = rocksdb::kCompactionStyleLevel;
+
+  // two first levels are rewritten too often to be worth compressing
+  fOptions.compression_per_level.resize(fOptions.num_levels);
+  for (int i = 0; i < fOptions.num_levels; ++i) {
+    fOptions.compression_per_level[i] = profile.compressed && i >= 2 ? compression : rocksdb::kNoCompression;
+  }
+
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.block_cache = blockCache;
+  tableOptions.block_size = profile.blockSize;
+
+  if (profile.hashKeyed) {
+    tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(BLOOM_FILTER_BITS_PER_KEY, false));
+    // the whole serialized hash key is the prefix, shorter keys like counters are taken as they are
+    tableOptions.index_type = rocksdb::BlockBasedTableOptions::kHashSearch;
+    fOptions.prefix_extractor.reset(rocksdb::NewCappedPrefixTransform(DB::serializeKey(profile.prefix, Crypto::Hash()).size()));
+  }
+
+  std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
+  fOptions.table_factory = tfp;
+
+  return fOptions;
+}
+
+rocksdb::ColumnFamilyHandle* findColumnFamily(rocksdb::DB& db, const std::map<std::string, rocksdb::ColumnFamilyHandle*>& columnFamilies,
+  const std::string& rawKey) {
+  auto it = columnFamilies.find(DB::getKeyPrefix(rawKey));
+  return it != columnFamilies.end() ? it->second : db.DefaultColumnFamily();
+}
+
+// key -> (exists, value) of the writes which weren't applied to the data base when the snapshot was taken
+typedef std::map<std::string, std::pair<bool, std::string>> SnapshotOverlay;
+
+class RocksDBSnapshot : public IDataBaseSnapshot {
+public:
+  RocksDBSnapshot(rocksdb::DB& db, const std::map<std::string, rocksdb::ColumnFamilyHandle*>& columnFamilies, SnapshotOverlay&& overlay) :
+    db(db), columnFamilies(columnFamilies), snapshot(db.GetSnapshot()), overlay(std::move(overlay)) {
+  }
+
+  ~RocksDBSnapshot() override {
+    db.ReleaseSnapshot(snapshot);
+  }
+
+  std::error_code read(IReadBatch& batch) override {
+    rocksdb::ReadOptions readOptions;
+    readOptions.snapshot = snapshot;
+
+    std::vector<std::string> rawKeys(batch.getRawKeys());
+    std::vector<std::string> values(rawKeys.size());
+    std::vector<bool> resultStates(rawKeys.size());
+
+    std::vector<size_t> dbKeyIndexes;
+    std::vector<rocksdb::ColumnFamilyHandle*> keyFamilies;
+    std::vector<rocksdb::Slice> keySlices;
+    dbKeyIndexes.reserve(rawKeys.size());
+    keyFamilies.reserve(rawKeys.size());
+    keySlices.reserve(rawKeys.size());
+    for (size_t i = 0; i < rawKeys.size(); ++i) {
+      auto it = overlay.find(rawKeys[i]);
+      if (it != overlay.end()) {
+        resultStates[i] = it->second.first;
+        values[i] = it->second.second;
+      } else {
+        dbKeyIndexes.push_back(i);
+        keyFamilies.push_back(findColumnFamily(db, columnFamilies, rawKeys[i]));
+        keySlices.emplace_back(rocksdb::Slice(rawKeys[i]));
+      }
+    }
+
+    std::vector<std::string> dbValues;
+    dbValues.reserve(keySlices.size());
+    std::vector<rocksdb::Status> statuses = db.MultiGet(readOptions, keyFamilies, keySlices, &dbValues);
+
+    for (size_t i = 0; i < statuses.size(); ++i) {
+      const rocksdb::Status& status = statuses[i];
+      if (!status.ok() && !status.IsNotFound()) {
+        return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+      }
+
+      resultStates[dbKeyIndexes[i]] = status.ok();
+      values[dbKeyIndexes[i]] = std::move(dbValues[i]);
+    }
+
+    batch.submitRawResult(values, resultStates);
+    return std::error_code();
+  }
+
+private:
+  rocksdb::DB& db;
+  const std::map<std::string, rocksdb::ColumnFamilyHandle*>& columnFamilies;
+  const rocksdb::Snapshot* snapshot;
+  const SnapshotOverlay overlay;
+};
+
+}
+
+RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED),
+  bulkDataSize(0), bulkDataMaxSize(0), bulkWrite(false), writeBehind(false), pendingDataSize(0), lastPendingSequence(0),
+  stopWriter(false), syncWritesInterval(0), syncTimeInterval(0), unsyncedWrites(0) {
 
 }
 
+RocksDBWrapper::~RocksDBWrapper() {
+  stopPendingWriter();
+}
+
 void RocksDBWrapper::init(const DataBaseConfig& config) {
   if (state.load() != NOT_INITIALIZED) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::ALREADY_INITIALIZED));
@@ -50,15 +242,17 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
   logger(INFO) << "Opening DB in " << dataDir;
 
   rocksdb::DB* dbPtr;
+  std::vector<rocksdb::ColumnFamilyHandle*> handles;
 
-  rocksdb::Options dbOptions = getDBOptions(config);
-  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+  rocksdb::DBOptions dbOptions = getDBOptions(config);
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors = getColumnFamilyDescriptors(config);
+  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &handles, &dbPtr);
   if (status.ok()) {
     logger(INFO) << "DB opened in " << dataDir;
   } else if (!status.ok() && status.IsInvalidArgument()) {
     logger(INFO) << "DB not found in " << dataDir << ". Creating new DB...";
     dbOptions.create_if_missing = true;
-    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &handles, &dbPtr);
     if (!status.ok()) {
       logger(ERROR) << "DB Error. DB can't be created in " << dataDir << ". Error: " << status.ToString();
       throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
@@ -72,6 +266,43 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
   }
 
   db.reset(dbPtr);
+
+  // handles go in the order of descriptors, the default column family is the first one
+  for (size_t i = 1; i < handles.size(); ++i) {
+    columnFamilies[descriptors[i].name] = handles[i];
+  }
+
+  db->DestroyColumnFamilyHandle(handles[0]);
+
+  std::string marker;
+  if (db->Get(rocksdb::ReadOptions(), BULK_WRITE_MARKER_KEY, &marker).ok()) {
+    logger(WARNING) << "DB was left inconsistent by an interrupted bulk write. DB will be destroyed and recreated from blocks.bin file.";
+    for (const auto& family : columnFamilies) {
+      db->DestroyColumnFamilyHandle(family.second);
+    }
+
+    columnFamilies.clear();
+    db.reset();
+    destoy(config);
+    init(config);
+    return;
+  }
+
+  bulkDataMaxSize = config.getWriteBufferSize();
+  moveToColumnFamilies();
+
+  writeBehind = config.getWriteBehind();
+  syncWritesInterval = config.getSyncWritesInterval();
+  syncTimeInterval = std::chrono::seconds(config.getSyncTimeInterval());
+  if (writeBehind) {
+    logger(INFO) << "DB writes are applied in background, write-ahead log is synced every " << syncWritesInterval
+                 << " writes and every " << config.getSyncTimeInterval() << " seconds (0 means never)";
+    stopWriter = false;
+    unsyncedWrites = 0;
+    lastSyncTime = std::chrono::steady_clock::now();
+    writerThread = std::thread(&RocksDBWrapper::writePendingBatches, this);
+  }
+
   state.store(INITIALIZED);
 }
 
@@ -81,8 +312,23 @@ void RocksDBWrapper::shutdown() {
   }
 
   logger(INFO) << "Closing DB.";
+  stopPendingWriter();
+  if (bulkWrite) {
+    endBulkWrite();
+  }
+
+  for (const auto& family : columnFamilies) {
+    db->Flush(rocksdb::FlushOptions(), family.second);
+  }
+
   db->Flush(rocksdb::FlushOptions());
   db->SyncWAL();
+
+  for (const auto& family : columnFamilies) {
+    db->DestroyColumnFamilyHandle(family.second);
+  }
+
+  columnFamilies.clear();
   db.reset();
   state.store(NOT_INITIALIZED);
 }
@@ -96,7 +342,7 @@ void RocksDBWrapper::destoy(const DataBaseConfig& config) {
 
   logger(WARNING) << "Destroying DB in " << dataDir;
 
-  rocksdb::Options dbOptions = getDBOptions(config);
+  rocksdb::Options dbOptions(getDBOptions(config), getColumnFamilyDescriptors(config).front().options);
   rocksdb::Status status = rocksdb::DestroyDB(dataDir, dbOptions);
 
   if (status.ok()) {
@@ -112,6 +358,10 @@ std::error_code RocksDBWrapper::write(IWriteBatch& batch) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
+  if (writeBehind && !bulkWrite) {
+    return queueWrite(batch);
+  }
+
   return write(batch, false);
 }
 
@@ -120,22 +370,55 @@ std::error_code RocksDBWrapper::writeSync(IWriteBatch& batch) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
+  if (bulkWrite) {
+    // data written without WAL must reach the disk before anything synced after it
+    auto error = endBulkWrite();
+    if (error) {
+      return error;
+    }
+  }
+
+  auto error = waitForPendingWrites();
+  if (error) {
+    return error;
+  }
+
   return write(batch, true);
 }
 
 std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
+  if (bulkWrite) {
+    std::unique_lock<std::mutex> lock(bulkMutex);
+    for (auto& kvPair : batch.extractRawDataToInsert()) {
+      bulkDataSize += kvPair.first.size() + kvPair.second.size();
+      bulkData[std::move(kvPair.first)] = std::make_pair(true, std::move(kvPair.second));
+    }
+
+    for (auto& key : batch.extractRawKeysToRemove()) {
+      bulkDataSize += key.size();
+      bulkData[std::move(key)] = std::make_pair(false, std::string());
+    }
+
+    if (bulkDataSize < bulkDataMaxSize) {
+      return std::error_code();
+    }
+
+    lock.unlock();
+    return flushBulkData();
+  }
+
   rocksdb::WriteOptions writeOptions;
   writeOptions.sync = sync;
 
   rocksdb::WriteBatch rocksdbBatch;
   std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
   for (const std::pair<std::string, std::string>& kvPair : rawData) {
-    rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+    rocksdbBatch.Put(findColumnFamily(*db, columnFamilies, kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
   }
 
   std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
   for (const std::string& key : rawKeys) {
-    rocksdbBatch.Delete(rocksdb::Slice(key));
+    rocksdbBatch.Delete(findColumnFamily(*db, columnFamilies, key), rocksdb::Slice(key));
   }
 
   rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
@@ -156,70 +439,446 @@ std::error_code RocksDBWrapper::read(IReadBatch& batch) {
   rocksdb::ReadOptions readOptions;
 
   std::vector<std::string> rawKeys(batch.getRawKeys());
+  std::vector<std::string> values(rawKeys.size());
+  std::vector<bool> resultStates(rawKeys.size());
+
+  std::vector<size_t> dbKeyIndexes;
+  std::vector<rocksdb::ColumnFamilyHandle*> keyFamilies;
   std::vector<rocksdb::Slice> keySlices;
+  dbKeyIndexes.reserve(rawKeys.size());
+  keyFamilies.reserve(rawKeys.size());
   keySlices.reserve(rawKeys.size());
-  for (const std::string& key : rawKeys) {
-    keySlices.emplace_back(rocksdb::Slice(key));
+
+  {
+    // buffered and queued values exist only in the modes producing them, so plain reads don't take the locks.
+    // Both flags are changed by the thread writing to the data base, which is the one reading it as well.
+    std::unique_lock<std::mutex> lock(bulkMutex, std::defer_lock);
+    std::unique_lock<std::mutex> pendingLock(pendingMutex, std::defer_lock);
+    if (bulkWrite) {
+      lock.lock();
+    }
+
+    if (writeBehind) {
+      pendingLock.lock();
+    }
+
+    for (size_t i = 0; i < rawKeys.size(); ++i) {
+      if (bulkWrite) {
+        auto it = bulkData.find(rawKeys[i]);
+        if (it != bulkData.end()) {
+          resultStates[i] = it->second.first;
+          values[i] = it->second.second;
+          continue;
+        }
+      }
+
+      if (writeBehind) {
+        auto pendingIt = pendingData.find(rawKeys[i]);
+        if (pendingIt != pendingData.end()) {
+          resultStates[i] = pendingIt->second.exists;
+          values[i] = pendingIt->second.value;
+          continue;
+        }
+      }
+
+      dbKeyIndexes.push_back(i);
+      keyFamilies.push_back(findColumnFamily(*db, columnFamilies, rawKeys[i]));
+      keySlices.emplace_back(rocksdb::Slice(rawKeys[i]));
+    }
   }
 
-  std::vector<std::string> values;
-  values.reserve(rawKeys.size());
-  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+  std::vector<std::string> dbValues;
+  dbValues.reserve(keySlices.size());
+  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keyFamilies, keySlices, &dbValues);
 
-  std::error_code error;
-  std::vector<bool> resultStates;
-  for (const rocksdb::Status& status : statuses) {
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    const rocksdb::Status& status = statuses[i];
     if (!status.ok() && !status.IsNotFound()) {
       return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
     }
-    resultStates.push_back(status.ok());
+
+    resultStates[dbKeyIndexes[i]] = status.ok();
+    values[dbKeyIndexes[i]] = std::move(dbValues[i]);
   }
 
   batch.submitRawResult(values, resultStates);
   return std::error_code();
 }
 
-rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
+void RocksDBWrapper::beginBulkWrite() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  if (!bulkWrite) {
+    // queued writes must not be applied over the bulk data written after them
+    auto error = waitForPendingWrites();
+    if (error) {
+      logger(ERROR) << "Can't start bulk write, queued writes failed: " << error.message();
+      return;
+    }
+
+    if (!writeBulkWriteMarker(true)) {
+      logger(ERROR) << "Can't start bulk write, marker can't be written";
+      return;
+    }
+
+    logger(INFO) << "Starting bulk write, write-ahead log is disabled";
+    bulkWrite = true;
+  }
+}
+
+std::error_code RocksDBWrapper::endBulkWrite() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  if (!bulkWrite) {
+    return std::error_code();
+  }
+
+  auto error = flushBulkData();
+  if (error) {
+    return error;
+  }
+
+  bulkWrite = false;
+
+  // the default column family holds the last block index, it must reach the disk along with the others
+  std::vector<rocksdb::ColumnFamilyHandle*> families = { db->DefaultColumnFamily() };
+  for (const auto& family : columnFamilies) {
+    families.push_back(family.second);
+  }
+
+  for (rocksdb::ColumnFamilyHandle* family : families) {
+    rocksdb::Status status = db->Flush(rocksdb::FlushOptions(), family);
+    if (!status.ok()) {
+      logger(ERROR) << "Can't flush DB after bulk write. " << status.ToString();
+      return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+    }
+  }
+
+  if (!writeBulkWriteMarker(false)) {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  logger(INFO) << "Bulk write finished";
+  return std::error_code();
+}
+
+std::unique_ptr<IDataBaseSnapshot> RocksDBWrapper::createSnapshot() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  // Buffered bulk data isn't in the data base yet and may take a whole write buffer, it is neither copied nor flushed
+  // here, so there are no snapshots in the middle of a bulk write.
+  std::unique_lock<std::mutex> lock(bulkMutex);
+  if (!bulkData.empty()) {
+    return nullptr;
+  }
+
+  // Queued writes are copied into the snapshot. The writer removes a value from pendingData under the same lock
+  // after applying it, so every queued value is seen either in the copy or in the data base.
+  std::unique_lock<std::mutex> pendingLock(pendingMutex);
+  SnapshotOverlay overlay;
+  for (const auto& kv : pendingData) {
+    overlay.emplace_hint(overlay.end(), kv.first, std::make_pair(kv.second.exists, kv.second.value));
+  }
+
+  return std::unique_ptr<IDataBaseSnapshot>(new RocksDBSnapshot(*db, columnFamilies, std::move(overlay)));
+}
+
+std::error_code RocksDBWrapper::flushBulkData() {
+  std::unique_lock<std::mutex> lock(bulkMutex);
+  if (bulkData.empty()) {
+    return std::error_code();
+  }
+
+  // keys are already sorted, so the batch is applied to the memtable in order
+  rocksdb::WriteBatch rocksdbBatch;
+  for (const auto& kv : bulkData) {
+    rocksdb::ColumnFamilyHandle* family = findColumnFamily(*db, columnFamilies, kv.first);
+    if (kv.second.first) {
+      rocksdbBatch.Put(family, rocksdb::Slice(kv.first), rocksdb::Slice(kv.second.second));
+    } else {
+      rocksdbBatch.Delete(family, rocksdb::Slice(kv.first));
+    }
+  }
+
+  rocksdb::WriteOptions writeOptions;
+  writeOptions.disableWAL = true;
+  rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
+  if (!status.ok()) {
+    logger(ERROR) << "Can't write bulk data to DB. " << status.ToString();
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  logger(DEBUGGING) << "Bulk data written to DB: " << bulkData.size() << " keys, " << bulkDataSize << " bytes";
+  bulkData.clear();
+  bulkDataSize = 0;
+  return std::error_code();
+}
+
+bool RocksDBWrapper::writeBulkWriteMarker(bool set) {
+  rocksdb::WriteOptions writeOptions;
+  writeOptions.sync = true;
+
+  rocksdb::Status status = set ? db->Put(writeOptions, BULK_WRITE_MARKER_KEY, rocksdb::Slice()) :
+                                 db->Delete(writeOptions, BULK_WRITE_MARKER_KEY);
+  if (!status.ok()) {
+    logger(ERROR) << "Can't write bulk write marker to DB. " << status.ToString();
+    return false;
+  }
+
+  return true;
+}
+
+std::error_code RocksDBWrapper::queueWrite(IWriteBatch& batch) {
+  PendingBatch pendingBatch;
+  pendingBatch.dataToInsert = batch.extractRawDataToInsert();
+  pendingBatch.keysToRemove = batch.extractRawKeysToRemove();
+
+  std::unique_lock<std::mutex> lock(pendingMutex);
+  // the caller is blocked only if the writer falls behind by more than a write buffer
+  pendingWritten.wait(lock, [this] { return pendingWriteError || pendingDataSize < bulkDataMaxSize; });
+  if (pendingWriteError) {
+    return pendingWriteError;
+  }
+
+  pendingBatch.sequence = ++lastPendingSequence;
+  auto setPendingValue = [this, &pendingBatch] (const std::string& key, bool exists, const std::string& value) {
+    auto it = pendingData.find(key);
+    if (it == pendingData.end()) {
+      pendingDataSize += key.size() + value.size();
+      pendingData.emplace(key, PendingValue{exists, value, pendingBatch.sequence});
+    } else {
+      pendingDataSize += value.size();
+      pendingDataSize -= it->second.value.size();
+      it->second = PendingValue{exists, value, pendingBatch.sequence};
+    }
+  };
+
+  for (const auto& kvPair : pendingBatch.dataToInsert) {
+    setPendingValue(kvPair.first, true, kvPair.second);
+  }
+
+  for (const auto& key : pendingBatch.keysToRemove) {
+    setPendingValue(key, false, std::string());
+  }
+
+  pendingBatches.push_back(std::move(pendingBatch));
+  pendingAdded.notify_one();
+  return std::error_code();
+}
+
+std::error_code RocksDBWrapper::waitForPendingWrites() {
+  std::unique_lock<std::mutex> lock(pendingMutex);
+  pendingWritten.wait(lock, [this] { return pendingWriteError || pendingData.empty(); });
+  return pendingWriteError;
+}
+
+void RocksDBWrapper::writePendingBatches() {
+  std::unique_lock<std::mutex> lock(pendingMutex);
+  for (;;) {
+    if (pendingBatches.empty()) {
+      if (stopWriter) {
+        break;
+      }
+
+      if (unsyncedWrites == 0 || syncTimeInterval == std::chrono::steady_clock::duration::zero()) {
+        pendingAdded.wait(lock);
+        continue;
+      }
+
+      // the last writes are synced when the node is idle for the sync interval
+      if (pendingAdded.wait_until(lock, lastSyncTime + syncTimeInterval) == std::cv_status::timeout && pendingBatches.empty()) {
+        unsyncedWrites = 0;
+        lastSyncTime = std::chrono::steady_clock::now();
+        lock.unlock();
+        rocksdb::Status status = db->SyncWAL();
+        if (!status.ok()) {
+          logger(ERROR) << "Can't sync DB write-ahead log. " << status.ToString();
+        }
+
+        lock.lock();
+      }
+
+      continue;
+    }
+
+    std::deque<PendingBatch> group;
+    group.swap(pendingBatches);
+
+    auto now = std::chrono::steady_clock::now();
+    unsyncedWrites += static_cast<uint32_t>(group.size());
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = (syncWritesInterval != 0 && unsyncedWrites >= syncWritesInterval) ||
+                        (syncTimeInterval != std::chrono::steady_clock::duration::zero() && now - lastSyncTime >= syncTimeInterval);
+    if (writeOptions.sync) {
+      unsyncedWrites = 0;
+      lastSyncTime = now;
+    }
+
+    // after a failure nothing is written, so DB keeps a prefix of the queued writes
+    bool failed = static_cast<bool>(pendingWriteError);
+    lock.unlock();
+
+    if (!failed) {
+      rocksdb::WriteBatch rocksdbBatch;
+      for (const auto& pendingBatch : group) {
+        for (const auto& kvPair : pendingBatch.dataToInsert) {
+          rocksdbBatch.Put(findColumnFamily(*db, columnFamilies, kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+        }
+
+        for (const auto& key : pendingBatch.keysToRemove) {
+          rocksdbBatch.Delete(findColumnFamily(*db, columnFamilies, key), rocksdb::Slice(key));
+        }
+      }
+
+      rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
+      if (!status.ok()) {
+        logger(ERROR) << "Can't write queued batches to DB. " << status.ToString();
+        failed = true;
+      } else {
+        logger(DEBUGGING) << "Written " << group.size() << " queued batches to DB" << (writeOptions.sync ? " with sync" : "");
+      }
+    }
+
+    lock.lock();
+    if (failed) {
+      // queued values stay readable, so the caller's view doesn't go back until it stops on the error
+      pendingWriteError = make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+    } else {
+      uint64_t writtenSequence = group.back().sequence;
+      auto removeWritten = [this, writtenSequence] (const std::string& key) {
+        auto it = pendingData.find(key);
+        if (it != pendingData.end() && it->second.sequence <= writtenSequence) {
+          pendingDataSize -= it->first.size() + it->second.value.size();
+          pendingData.erase(it);
+        }
+      };
+
+      for (const auto& pendingBatch : group) {
+        for (const auto& kvPair : pendingBatch.dataToInsert) {
+          removeWritten(kvPair.first);
+        }
+
+        for (const auto& key : pendingBatch.keysToRemove) {
+          removeWritten(key);
+        }
+      }
+    }
+
+    pendingWritten.notify_all();
+  }
+}
+
+void RocksDBWrapper::stopPendingWriter() {
+  if (!writerThread.joinable()) {
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    stopWriter = true;
+    pendingAdded.notify_one();
+  }
+
+  // the writer applies everything queued before it stops
+  writerThread.join();
+  writeBehind = false;
+  if (pendingWriteError) {
+    logger(ERROR) << "Some queued writes weren't applied to DB: " << pendingWriteError.message();
+  }
+}
+
+void RocksDBWrapper::moveToColumnFamilies() {
+  // data bases created before column families were introduced keep everything in the default column family
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions(), db->DefaultColumnFamily()));
+  it->SeekToFirst();
+  if (!it->Valid()) {
+    return;
+  }
+
+  logger(INFO) << "Moving DB records to column families, it may take a while...";
+
+  // every key is moved by the same batch that removes it from the default column family, so an interrupted
+  // migration continues from where it stopped on the next start
+  rocksdb::WriteBatch rocksdbBatch;
+  uint64_t batchSize = 0;
+  uint64_t movedCount = 0;
+  for (; it->Valid(); it->Next()) {
+    auto family = columnFamilies.find(DB::getKeyPrefix(it->key().ToString()));
+    if (family == columnFamilies.end()) {
+      continue;
+    }
+
+    rocksdbBatch.Put(family->second, it->key(), it->value());
+    rocksdbBatch.Delete(db->DefaultColumnFamily(), it->key());
+    batchSize += it->key().size() + it->value().size();
+    ++movedCount;
+
+    if (batchSize >= bulkDataMaxSize) {
+      rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &rocksdbBatch);
+      if (!status.ok()) {
+        logger(ERROR) << "DB Error. Can't move records to column families. Error: " << status.ToString();
+        throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+      }
+
+      logger(INFO) << "Moved " << movedCount << " DB records";
+      rocksdbBatch.Clear();
+      batchSize = 0;
+    }
+  }
+
+  if (!it->status().ok()) {
+    logger(ERROR) << "DB Error. Can't read records to move to column families. Error: " << it->status().ToString();
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+  }
+
+  it.reset();
+
+  rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &rocksdbBatch);
+  if (!status.ok()) {
+    logger(ERROR) << "DB Error. Can't move records to column families. Error: " << status.ToString();
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+  }
+
+  // drop the tombstones left in the default column family
+  db->CompactRange(rocksdb::CompactRangeOptions(), db->DefaultColumnFamily(), nullptr, nullptr);
+  logger(INFO) << "Moved " << movedCount << " DB records to column families";
+}
+
+rocksdb::DBOptions RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
   rocksdb::DBOptions dbOptions;
   dbOptions.IncreaseParallelism(config.getBackgroundThreadsCount());
   dbOptions.info_log_level = rocksdb::InfoLogLevel::WARN_LEVEL;
   dbOptions.max_open_files = config.getMaxOpenFiles();
+  dbOptions.create_missing_column_families = true;
+  // memtables of all column families together shouldn't take much more than a single one did
+  dbOptions.db_write_buffer_size = static_cast<size_t>(config.getWriteBufferSize() * 2);
 
-  rocksdb::ColumnFamilyOptions fOptions;
-  fOptions.write_buffer_size = static_cast<size_t>(config.getWriteBufferSize());
-  // merge two memtables when flushing to L0
-  fOptions.min_write_buffer_number_to_merge = 2;
-  // this means we'll use 50% extra memory in the worst case, but will reduce
-  // write stalls.
-  fOptions.max_write_buffer_number = 6;
-  // start flushing L0->L1 as soon as possible. each file on level0 is
-  // (memtable_memory_budget / 2). This will flush level 0 when it's bigger than
-  // memtable_memory_budget.
-  fOptions.level0_file_num_compaction_trigger = 20;
+  return dbOptions;
+}
 
-  fOptions.level0_slowdown_writes_trigger = 30;
-  fOptions.level0_stop_writes_trigger = 40;
+std::vector<rocksdb::ColumnFamilyDescriptor> RocksDBWrapper::getColumnFamilyDescriptors(const DataBaseConfig& config) {
+  std::shared_ptr<rocksdb::Cache> blockCache = rocksdb::NewLRUCache(config.getReadCacheSize());
+  rocksdb::CompressionType compression = getSupportedCompression();
+  if (compression == rocksdb::kNoCompression) {
+    logger(WARNING) << "No compression library is linked with RocksDB, raw blocks are stored uncompressed";
+  }
 
-  // doesn't really matter much, but we don't want to create too many files
-  fOptions.target_file_size_base = config.getWriteBufferSize() / 10;
-  // make Level1 size equal to Level0 size, so that L0->L1 compactions are fast
-  fOptions.max_bytes_for_level_base = config.getWriteBufferSize();
-  fOptions.num_levels = 10;
-  fOptions.target_file_size_multiplier = 2;
-  // level style compaction
-  fOptions.compaction_style = rocksdb::kCompactionStyleLevel;
+  ColumnFamilyProfile defaultProfile = { rocksdb::kDefaultColumnFamilyName, false, DEFAULT_BLOCK_SIZE, false };
 
-  fOptions.compression_per_level.resize(fOptions.num_levels);
-  for (int i = 0; i < fOptions.num_levels; ++i) {
-    fOptions.compression_per_level[i] = rocksdb::kNoCompression;
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  descriptors.reserve(COLUMN_FAMILY_PROFILES.size() + 1);
+  descriptors.emplace_back(rocksdb::kDefaultColumnFamilyName, getColumnFamilyOptions(config, defaultProfile, blockCache, compression));
+  for (const ColumnFamilyProfile& profile : COLUMN_FAMILY_PROFILES) {
+    descriptors.emplace_back(profile.prefix, getColumnFamilyOptions(config, profile, blockCache, compression));
   }
 
-  rocksdb::BlockBasedTableOptions tableOptions;
-  tableOptions.block_cache = rocksdb::NewLRUCache(config.getReadCacheSize());
-  std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
-  fOptions.table_factory = tfp;
-
-  return rocksdb::Options(dbOptions, fOptions);
+  return descriptors;
 }
 
 std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
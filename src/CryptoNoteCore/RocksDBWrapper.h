@@ -18,8 +18,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "rocksdb/db.h"
 
@@ -49,10 +56,24 @@ public:
   std::error_code writeSync(IWriteBatch& batch) override;
   std::error_code read(IReadBatch& batch) override;
 
+  void beginBulkWrite() override;
+  std::error_code endBulkWrite() override;
+
+  // Writes queued with write-behind are copied into the snapshot. Returns nullptr during a bulk write.
+  std::unique_ptr<IDataBaseSnapshot> createSnapshot() override;
+
 private:
   std::error_code write(IWriteBatch& batch, bool sync);
+  std::error_code flushBulkData();
+  bool writeBulkWriteMarker(bool set);
+  std::error_code queueWrite(IWriteBatch& batch);
+  std::error_code waitForPendingWrites();
+  void writePendingBatches();
+  void stopPendingWriter();
+  void moveToColumnFamilies();
 
-  rocksdb::Options getDBOptions(const DataBaseConfig& config);
+  rocksdb::DBOptions getDBOptions(const DataBaseConfig& config);
+  std::vector<rocksdb::ColumnFamilyDescriptor> getColumnFamilyDescriptors(const DataBaseConfig& config);
   std::string getDataDir(const DataBaseConfig& config);
 
   enum State {
@@ -63,5 +84,47 @@ private:
   Logging::LoggerRef logger;
   std::unique_ptr<rocksdb::DB> db;
   std::atomic<State> state;
+
+  // key prefix -> column family holding the keys with this prefix, keys with other prefixes stay in the default one
+  std::map<std::string, rocksdb::ColumnFamilyHandle*> columnFamilies;
+
+  // key -> (exists, value), a removed key is kept as a tombstone until flushed
+  std::map<std::string, std::pair<bool, std::string>> bulkData;
+  uint64_t bulkDataSize;
+  uint64_t bulkDataMaxSize;
+  bool bulkWrite;
+  std::mutex bulkMutex;
+
+  struct PendingBatch {
+    uint64_t sequence;
+    std::vector<std::pair<std::string, std::string>> dataToInsert;
+    std::vector<std::string> keysToRemove;
+  };
+
+  struct PendingValue {
+    bool exists;
+    std::string value;
+    uint64_t sequence; //of the last batch changing the key
+  };
+
+  // With write-behind, writes are queued and applied by writerThread in groups, one group is one atomic DB write,
+  // so DB always holds a prefix of the queued writes. Readers see queued values through pendingData.
+  bool writeBehind;
+  std::deque<PendingBatch> pendingBatches;
+  std::map<std::string, PendingValue> pendingData;
+  uint64_t pendingDataSize;
+  uint64_t lastPendingSequence;
+  std::error_code pendingWriteError;
+  bool stopWriter;
+  std::mutex pendingMutex;
+  std::condition_variable pendingAdded;
+  std::condition_variable pendingWritten;
+  std::thread writerThread;
+
+  // write-ahead log sync policy of grouped writes
+  uint32_t syncWritesInterval;
+  std::chrono::steady_clock::duration syncTimeInterval;
+  uint32_t unsyncedWrites;
+  std::chrono::steady_clock::time_point lastSyncTime;
 };
 }
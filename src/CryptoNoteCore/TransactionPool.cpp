@@ -17,6 +17,9 @@
 
 #include "TransactionPool.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "Common/int-util.h"
 #include "CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/TransactionExtra.h"
@@ -49,6 +52,10 @@ const Crypto::Hash& TransactionPool::PendingTransactionInfo::getTransactionHash(
   return cachedTransaction.getTransactionHash();
 }
 
+size_t TransactionPool::PendingTransactionInfo::getTransactionSize() const {
+  return cachedTransaction.getTransactionBinaryArray().size();
+}
+
 size_t TransactionPool::PaymentIdHasher::operator() (const boost::optional<Crypto::Hash>& paymentId) const {
   if (!paymentId) {
     return std::numeric_limits<size_t>::max();
@@ -57,14 +64,21 @@ size_t TransactionPool::PaymentIdHasher::operator() (const boost::optional<Crypt
   return std::hash<Crypto::Hash>{}(*paymentId);
 }
 
-TransactionPool::TransactionPool(Logging::ILogger& logger) :
+TransactionPool::TransactionPool(Logging::ILogger& logger, uint64_t maxSize, size_t changeLogCapacity) :
+  maxSize(maxSize),
+  transactionsSize(0),
+  changeLogCapacity(changeLogCapacity),
+  // sequence numbers of a restarted daemon must not match the ones clients got before
+  changeLogStart(static_cast<uint64_t>(Crypto::rand<uint32_t>()) << 32),
   transactionHashIndex(transactions.get<TransactionHashTag>()),
   transactionCostIndex(transactions.get<TransactionCostTag>()),
   paymentIdIndex(transactions.get<PaymentIdTag>()),
+  receiveTimeIndex(transactions.get<TransactionReceiveTimeTag>()),
   logger(logger, "TransactionPool") {
 }
 
-bool TransactionPool::pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState) {
+bool TransactionPool::pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState,
+                                      std::vector<Crypto::Hash>& evictedTransactions) {
   auto pendingTx = PendingTransactionInfo{static_cast<uint64_t>(time(nullptr)), std::move(transaction)};
 
   Crypto::Hash paymentId;
@@ -82,7 +96,14 @@ bool TransactionPool::pushTransaction(CachedTransaction&& transaction, Transacti
     return false;
   }
 
+  if (!makeRoom(pendingTx, evictedTransactions)) {
+    logger(Logging::DEBUGGING) << "pushTransaction: pool is full of transactions with higher fee per byte";
+    return false;
+  }
+
   mergeStates(poolState, transactionState);
+  transactionsSize += pendingTx.getTransactionSize();
+  logChange(pendingTx.getTransactionHash(), true);
 
   logger(Logging::DEBUGGING) << "pushed transaction " << pendingTx.getTransactionHash() << " to pool";
   return transactionHashIndex.emplace(std::move(pendingTx)).second;
@@ -103,6 +124,8 @@ bool TransactionPool::removeTransaction(const Crypto::Hash& hash) {
   }
 
   excludeFromState(poolState, it->cachedTransaction);
+  transactionsSize -= it->getTransactionSize();
+  logChange(hash, false);
   transactionHashIndex.erase(it);
 
   logger(Logging::DEBUGGING) << "transaction " << hash << " removed from pool";
@@ -113,6 +136,10 @@ size_t TransactionPool::getTransactionCount() const {
   return transactionHashIndex.size();
 }
 
+uint64_t TransactionPool::getTransactionsSize() const {
+  return transactionsSize;
+}
+
 std::vector<Crypto::Hash> TransactionPool::getTransactionHashes() const {
   std::vector<Crypto::Hash> hashes;
   for (auto it = transactionCostIndex.begin(); it != transactionCostIndex.end(); ++it) {
@@ -141,6 +168,16 @@ std::vector<CachedTransaction> TransactionPool::getPoolTransactions() const {
   return result;
 }
 
+void TransactionPool::forEachTransaction(bool mostProfitableFirst, const std::function<bool (const CachedTransaction&)>& visitor) const {
+  if (mostProfitableFirst) {
+    for (auto it = transactionCostIndex.begin(); it != transactionCostIndex.end() && visitor(it->cachedTransaction); ++it) {
+    }
+  } else {
+    for (auto it = transactionCostIndex.rbegin(); it != transactionCostIndex.rend() && visitor(it->cachedTransaction); ++it) {
+    }
+  }
+}
+
 uint64_t TransactionPool::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   auto it = transactionHashIndex.find(hash);
   assert(it != transactionHashIndex.end());
@@ -148,6 +185,15 @@ uint64_t TransactionPool::getTransactionReceiveTime(const Crypto::Hash& hash) co
   return it->receiveTime;
 }
 
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesReceivedBefore(uint64_t time) const {
+  std::vector<Crypto::Hash> hashes;
+  for (auto it = receiveTimeIndex.begin(); it != receiveTimeIndex.end() && it->receiveTime < time; ++it) {
+    hashes.push_back(it->getTransactionHash());
+  }
+
+  return hashes;
+}
+
 std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const {
   boost::optional<Crypto::Hash> p(paymentId);
 
@@ -161,4 +207,75 @@ std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByPaymentId(const
   return transactionHashes;
 }
 
+uint64_t TransactionPool::getChangeSequence() const {
+  return changeLogStart + changeLog.size();
+}
+
+bool TransactionPool::getChangesSince(uint64_t sequence, std::vector<Crypto::Hash>& addedTransactions,
+                                      std::vector<Crypto::Hash>& deletedTransactions) const {
+  if (sequence < changeLogStart || sequence > getChangeSequence()) {
+    return false;
+  }
+
+  // walk from the newest change, so the first change of a transaction met is its last one
+  std::unordered_set<Crypto::Hash> reportedTransactions;
+  for (auto it = changeLog.rbegin(); it != changeLog.rend() - (sequence - changeLogStart); ++it) {
+    if (reportedTransactions.insert(it->transactionHash).second) {
+      (it->added ? addedTransactions : deletedTransactions).push_back(it->transactionHash);
+    }
+  }
+
+  std::reverse(addedTransactions.begin(), addedTransactions.end());
+  std::reverse(deletedTransactions.begin(), deletedTransactions.end());
+  return true;
+}
+
+void TransactionPool::logChange(const Crypto::Hash& transactionHash, bool added) {
+  if (changeLogCapacity == 0) {
+    ++changeLogStart;
+    return;
+  }
+
+  if (changeLog.size() == changeLogCapacity) {
+    changeLog.pop_front();
+    ++changeLogStart;
+  }
+
+  changeLog.push_back(TransactionChange{transactionHash, added});
+}
+
+// The least profitable transactions are evicted only if all of them are less profitable than the new one,
+// so a full pool either keeps its transactions or takes the new one, each evicted transaction costs O(log n)
+bool TransactionPool::makeRoom(const PendingTransactionInfo& transaction, std::vector<Crypto::Hash>& evictedTransactions) {
+  uint64_t transactionSize = transaction.getTransactionSize();
+  if (maxSize == 0 || transactionsSize + transactionSize <= maxSize) {
+    return true;
+  }
+
+  TransactionPriorityComparator isMoreProfitable;
+  uint64_t freedSize = 0;
+  size_t evictedCount = 0;
+  for (auto it = transactionCostIndex.rbegin(); transactionsSize - freedSize + transactionSize > maxSize; ++it) {
+    if (it == transactionCostIndex.rend() || !isMoreProfitable(transaction, *it)) {
+      return false;
+    }
+
+    freedSize += it->getTransactionSize();
+    ++evictedCount;
+  }
+
+  for (; evictedCount > 0; --evictedCount) {
+    auto it = std::prev(transactionCostIndex.end());
+    logger(Logging::DEBUGGING) << "transaction " << it->getTransactionHash() << " evicted from full pool";
+
+    evictedTransactions.push_back(it->getTransactionHash());
+    excludeFromState(poolState, it->cachedTransaction);
+    transactionsSize -= it->getTransactionSize();
+    logChange(it->getTransactionHash(), false);
+    transactionCostIndex.erase(it);
+  }
+
+  return true;
+}
+
 }
@@ -16,6 +16,7 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <deque>
 #include <unordered_map>
 
 #include "crypto/crypto.h"
@@ -36,23 +37,46 @@ namespace CryptoNote {
 
 class TransactionPool : public ITransactionPool {
 public:
-  TransactionPool(Logging::ILogger& logger);
+  static const size_t DEFAULT_CHANGE_LOG_CAPACITY = 100000;
 
-  virtual bool pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState) override;
+  // maxSize limits the total size of transactions in bytes, 0 means no limit
+  TransactionPool(Logging::ILogger& logger, uint64_t maxSize = 0, size_t changeLogCapacity = DEFAULT_CHANGE_LOG_CAPACITY);
+
+  virtual bool pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState,
+                               std::vector<Crypto::Hash>& evictedTransactions) override;
   virtual const CachedTransaction& getTransaction(const Crypto::Hash& hash) const override;
   virtual bool removeTransaction(const Crypto::Hash& hash) override;
 
   virtual size_t getTransactionCount() const override;
+  virtual uint64_t getTransactionsSize() const override;
   virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
   virtual bool checkIfTransactionPresent(const Crypto::Hash& hash) const override;
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual void forEachTransaction(bool mostProfitableFirst, const std::function<bool (const CachedTransaction&)>& visitor) const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesReceivedBefore(uint64_t time) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+
+  virtual uint64_t getChangeSequence() const override;
+  virtual bool getChangesSince(uint64_t sequence, std::vector<Crypto::Hash>& addedTransactions,
+                               std::vector<Crypto::Hash>& deletedTransactions) const override;
 private:
   TransactionValidatorState poolState;
+  uint64_t maxSize;
+  uint64_t transactionsSize;
+
+  struct TransactionChange {
+    Crypto::Hash transactionHash;
+    bool added;
+  };
+
+  // the oldest changes are dropped when the log is full, changeLogStart is the sequence number of the front change
+  std::deque<TransactionChange> changeLog;
+  size_t changeLogCapacity;
+  uint64_t changeLogStart;
 
   struct PendingTransactionInfo {
     uint64_t receiveTime;
@@ -60,6 +84,7 @@ private:
     boost::optional<Crypto::Hash> paymentId;
 
     const Crypto::Hash& getTransactionHash() const;
+    size_t getTransactionSize() const;
   };
 
   struct TransactionPriorityComparator {
@@ -69,6 +94,7 @@ private:
 
   struct TransactionHashTag {};
   struct TransactionCostTag {};
+  struct TransactionReceiveTimeTag {};
   struct PaymentIdTag {};
 
   typedef boost::multi_index::ordered_non_unique<
@@ -86,6 +112,11 @@ private:
     >
   > TransactionHashIndex;
 
+  typedef boost::multi_index::ordered_non_unique<
+    boost::multi_index::tag<TransactionReceiveTimeTag>,
+    BOOST_MULTI_INDEX_MEMBER(PendingTransactionInfo, uint64_t, receiveTime)
+  > TransactionReceiveTimeIndex;
+
   struct PaymentIdHasher {
     size_t operator() (const boost::optional<Crypto::Hash>& paymentId) const;
   };
@@ -101,7 +132,8 @@ private:
     boost::multi_index::indexed_by<
       TransactionHashIndex,
       TransactionCostIndex,
-      PaymentIdIndex
+      PaymentIdIndex,
+      TransactionReceiveTimeIndex
     >
   > TransactionsContainer;
 
@@ -109,8 +141,12 @@ private:
   TransactionsContainer::index<TransactionHashTag>::type& transactionHashIndex;
   TransactionsContainer::index<TransactionCostTag>::type& transactionCostIndex;
   TransactionsContainer::index<PaymentIdTag>::type& paymentIdIndex;
+  TransactionsContainer::index<TransactionReceiveTimeTag>::type& receiveTimeIndex;
   
   Logging::LoggerRef logger;
+
+  bool makeRoom(const PendingTransactionInfo& transaction, std::vector<Crypto::Hash>& evictedTransactions);
+  void logChange(const Crypto::Hash& transactionHash, bool added);
 };
 
 }
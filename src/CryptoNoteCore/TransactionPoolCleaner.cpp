@@ -41,8 +41,10 @@ TransactionPoolCleanWrapper::TransactionPoolCleanWrapper(
 TransactionPoolCleanWrapper::~TransactionPoolCleanWrapper() {
 }
 
-bool TransactionPoolCleanWrapper::pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState) {
-  return !isTransactionRecentlyDeleted(tx.getTransactionHash()) && transactionPool->pushTransaction(std::move(tx), std::move(transactionState));
+bool TransactionPoolCleanWrapper::pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState,
+                                                  std::vector<Crypto::Hash>& evictedTransactions) {
+  return !isTransactionRecentlyDeleted(tx.getTransactionHash()) &&
+    transactionPool->pushTransaction(std::move(tx), std::move(transactionState), evictedTransactions);
 }
 
 const CachedTransaction& TransactionPoolCleanWrapper::getTransaction(const Crypto::Hash& hash) const {
@@ -57,6 +59,10 @@ size_t TransactionPoolCleanWrapper::getTransactionCount() const {
   return transactionPool->getTransactionCount();
 }
 
+uint64_t TransactionPoolCleanWrapper::getTransactionsSize() const {
+  return transactionPool->getTransactionsSize();
+}
+
 std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashes() const {
   return transactionPool->getTransactionHashes();
 }
@@ -73,6 +79,10 @@ std::vector<CachedTransaction> TransactionPoolCleanWrapper::getPoolTransactions(
   return transactionPool->getPoolTransactions();
 }
 
+void TransactionPoolCleanWrapper::forEachTransaction(bool mostProfitableFirst, const std::function<bool (const CachedTransaction&)>& visitor) const {
+  transactionPool->forEachTransaction(mostProfitableFirst, visitor);
+}
+
 uint64_t TransactionPoolCleanWrapper::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   return transactionPool->getTransactionReceiveTime(hash);
 }
@@ -81,20 +91,36 @@ std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByPay
   return transactionPool->getTransactionHashesByPaymentId(paymentId);
 }
 
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesReceivedBefore(uint64_t time) const {
+  return transactionPool->getTransactionHashesReceivedBefore(time);
+}
+
+uint64_t TransactionPoolCleanWrapper::getChangeSequence() const {
+  return transactionPool->getChangeSequence();
+}
+
+bool TransactionPoolCleanWrapper::getChangesSince(uint64_t sequence, std::vector<Crypto::Hash>& addedTransactions,
+                                                  std::vector<Crypto::Hash>& deletedTransactions) const {
+  return transactionPool->getChangesSince(sequence, addedTransactions, deletedTransactions);
+}
+
 std::vector<Crypto::Hash> TransactionPoolCleanWrapper::clean() {
   try {
     uint64_t currentTime = timeProvider->now();
-    auto transactionHashes = transactionPool->getTransactionHashes();
 
+    // only the expired transactions are visited, the pool keeps them ordered by receive time
     std::vector<Crypto::Hash> deletedTransactions;
-    for (const auto& hash: transactionHashes) {
-      uint64_t transactionAge = currentTime - transactionPool->getTransactionReceiveTime(hash);
-      if (transactionAge >= timeout) {
-        logger(Logging::DEBUGGING) << "Deleting transaction " << Common::podToHex(hash) << " from pool";
-        recentlyDeletedTransactions.emplace(hash, currentTime);
-        transactionPool->removeTransaction(hash);
-        deletedTransactions.emplace_back(std::move(hash));
+    if (currentTime >= timeout) {
+      deletedTransactions = transactionPool->getTransactionHashesReceivedBefore(currentTime - timeout + 1);
+    }
+
+    for (const auto& hash: deletedTransactions) {
+      logger(Logging::DEBUGGING) << "Deleting transaction " << Common::podToHex(hash) << " from pool";
+      if (recentlyDeletedTransactions.emplace(hash, currentTime).second) {
+        recentlyDeletedQueue.emplace_back(currentTime, hash);
       }
+
+      transactionPool->removeTransaction(hash);
     }
 
     cleanRecentlyDeletedTransactions(currentTime);
@@ -113,12 +139,9 @@ bool TransactionPoolCleanWrapper::isTransactionRecentlyDeleted(const Crypto::Has
 }
 
 void TransactionPoolCleanWrapper::cleanRecentlyDeletedTransactions(uint64_t currentTime) {
-  for (auto it = recentlyDeletedTransactions.begin(); it != recentlyDeletedTransactions.end();) {
-    if (currentTime - it->second >= timeout) {
-      it = recentlyDeletedTransactions.erase(it);
-    } else {
-      ++it;
-    }
+  while (!recentlyDeletedQueue.empty() && currentTime - recentlyDeletedQueue.front().first >= timeout) {
+    recentlyDeletedTransactions.erase(recentlyDeletedQueue.front().second);
+    recentlyDeletedQueue.pop_front();
   }
 }
 
@@ -20,6 +20,7 @@
 #include "ITransactionPoolCleaner.h"
 
 #include <chrono>
+#include <deque>
 #include <unordered_map>
 
 #include "crypto/crypto.h"
@@ -49,20 +50,28 @@ public:
 
   virtual ~TransactionPoolCleanWrapper();
 
-  virtual bool pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState) override;
+  virtual bool pushTransaction(CachedTransaction&& tx, TransactionValidatorState&& transactionState,
+                               std::vector<Crypto::Hash>& evictedTransactions) override;
   virtual const CachedTransaction& getTransaction(const Crypto::Hash& hash) const override;
   virtual bool removeTransaction(const Crypto::Hash& hash) override;
 
   virtual size_t getTransactionCount() const override;
+  virtual uint64_t getTransactionsSize() const override;
   virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
   virtual bool checkIfTransactionPresent(const Crypto::Hash& hash) const override;
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual void forEachTransaction(bool mostProfitableFirst, const std::function<bool (const CachedTransaction&)>& visitor) const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesReceivedBefore(uint64_t time) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
 
+  virtual uint64_t getChangeSequence() const override;
+  virtual bool getChangesSince(uint64_t sequence, std::vector<Crypto::Hash>& addedTransactions,
+                               std::vector<Crypto::Hash>& deletedTransactions) const override;
+
   virtual std::vector<Crypto::Hash> clean() override;
 
 private:
@@ -70,6 +79,8 @@ private:
   std::unique_ptr<ITimeProvider> timeProvider;
   Logging::LoggerRef logger;
   std::unordered_map<Crypto::Hash, uint64_t> recentlyDeletedTransactions;
+  // recently deleted transactions in the order of deletion, so forgetting them doesn't walk the whole map
+  std::deque<std::pair<uint64_t, Crypto::Hash>> recentlyDeletedQueue;
   uint64_t timeout;
 
   bool isTransactionRecentlyDeleted(const Crypto::Hash& hash) const;
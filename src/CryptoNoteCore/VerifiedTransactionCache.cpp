@@ -0,0 +1,76 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "VerifiedTransactionCache.h"
+
+#include <cassert>
+
+namespace CryptoNote {
+
+VerifiedTransactionCache::VerifiedTransactionCache(size_t maxSize) : maxSize(maxSize) {
+}
+
+void VerifiedTransactionCache::add(const Crypto::Hash& transactionHash, VerifiedTransaction&& transaction) {
+  if (maxSize == 0) {
+    return;
+  }
+
+  auto it = entries.find(transactionHash);
+  if (it != entries.end()) {
+    it->second.transaction = std::move(transaction);
+    order.splice(order.end(), order, it->second.position);
+    return;
+  }
+
+  if (entries.size() == maxSize) {
+    entries.erase(order.front());
+    order.pop_front();
+  }
+
+  order.push_back(transactionHash);
+  entries.emplace(transactionHash, Entry{ std::move(transaction), std::prev(order.end()) });
+}
+
+const VerifiedTransaction* VerifiedTransactionCache::find(const Crypto::Hash& transactionHash) const {
+  auto it = entries.find(transactionHash);
+  if (it == entries.end()) {
+    return nullptr;
+  }
+
+  return &it->second.transaction;
+}
+
+void VerifiedTransactionCache::remove(const Crypto::Hash& transactionHash) {
+  auto it = entries.find(transactionHash);
+  if (it == entries.end()) {
+    return;
+  }
+
+  order.erase(it->second.position);
+  entries.erase(it);
+}
+
+void VerifiedTransactionCache::clear() {
+  entries.clear();
+  order.clear();
+}
+
+size_t VerifiedTransactionCache::size() const {
+  assert(entries.size() == order.size());
+  return entries.size();
+}
+
+}
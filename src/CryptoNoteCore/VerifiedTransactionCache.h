@@ -0,0 +1,59 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+struct VerifiedTransaction {
+  bool keyImagesChecked;
+  std::vector<std::vector<Crypto::PublicKey>> outputKeys; //ring members of every input, empty if the input wasn't checked
+};
+
+// Bounded set of transactions with verified ring signatures, the oldest entries are evicted first.
+class VerifiedTransactionCache {
+public:
+  explicit VerifiedTransactionCache(size_t maxSize);
+
+  void add(const Crypto::Hash& transactionHash, VerifiedTransaction&& transaction);
+  const VerifiedTransaction* find(const Crypto::Hash& transactionHash) const;
+  void remove(const Crypto::Hash& transactionHash);
+  void clear();
+
+  size_t size() const;
+
+private:
+  typedef std::list<Crypto::Hash> Order;
+
+  struct Entry {
+    VerifiedTransaction transaction;
+    Order::iterator position;
+  };
+
+  const size_t maxSize;
+  std::unordered_map<Crypto::Hash, Entry> entries;
+  Order order;
+};
+
+}
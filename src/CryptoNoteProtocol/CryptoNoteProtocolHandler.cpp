@@ -238,6 +238,10 @@ bool CryptoNoteProtocolHandler::process_payload_sync_data(const CORE_SYNC_DATA&
     } else {
       context.m_state = CryptoNoteConnectionContext::state_normal;
     }
+  } else if (hshd.pruned_height > get_current_blockchain_height()) {
+    logger(Logging::DEBUGGING) << context << "Peer is pruned up to height " << hshd.pruned_height
+                               << ", it can't provide blocks from height " << get_current_blockchain_height();
+    context.m_state = CryptoNoteConnectionContext::state_normal;
   } else {
     int64_t diff = static_cast<int64_t>(hshd.current_height) - static_cast<int64_t>(get_current_blockchain_height());
 
@@ -266,6 +270,7 @@ bool CryptoNoteProtocolHandler::process_payload_sync_data(const CORE_SYNC_DATA&
 bool CryptoNoteProtocolHandler::get_payload_sync_data(CORE_SYNC_DATA& hshd) {
   hshd.top_id = m_core.getTopBlockHash();
   hshd.current_height = m_core.getTopBlockIndex() + 1;
+  hshd.pruned_height = m_core.getPrunedBlockCount();
   return true;
 }
 
@@ -354,15 +359,22 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-    if (!m_core.addTransactionToPool(*tx_blob_it)) {
+  auto added = m_core.addTransactionsToPool(arg.txs);
+  size_t addedCount = 0;
+  for (size_t i = 0; i < arg.txs.size(); ++i) {
+    if (!added[i]) {
       logger(Logging::INFO) << context << "Tx verification failed";
-      tx_blob_it = arg.txs.erase(tx_blob_it);
     } else {
-      ++tx_blob_it;
+      if (addedCount != i) {
+        arg.txs[addedCount] = std::move(arg.txs[i]);
+      }
+
+      ++addedCount;
     }
   }
 
+  arg.txs.resize(addedCount);
+
   if (arg.txs.size()) {
     //TODO: add announce usage here
     relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
@@ -32,6 +32,7 @@
 #include "Common/Util.h"
 #include "crypto/hash.h"
 #include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreConfig.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/DatabaseBlockchainCache.h"
 #include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
@@ -163,6 +164,7 @@ int main(int argc, char* argv[])
     RpcServerConfig::initOptions(desc_cmd_sett);
     NetNodeConfig::initOptions(desc_cmd_sett);
     DataBaseConfig::initOptions(desc_cmd_sett);
+    CoreConfig::initOptions(desc_cmd_sett);
 
     po::options_description desc_options("Allowed options");
     desc_options.add(desc_cmd_only).add(desc_cmd_sett);
@@ -265,7 +267,7 @@ int main(int argc, char* argv[])
     database.init(dbConfig);
     Tools::ScopeExit dbShutdownOnExit([&database] () { database.shutdown(); });
 
-    if (!DatabaseBlockchainCache::checkDBSchemeVersion(database, logManager))
+    if (!DatabaseBlockchainCache::checkDBSchemeVersion(database, logManager, dbConfig.getRawBlocksInStorage()))
     {
       dbShutdownOnExit.cancel();
       database.shutdown();
@@ -276,6 +278,19 @@ int main(int argc, char* argv[])
       dbShutdownOnExit.resume();
     }
 
+    CoreConfig coreConfig;
+    coreConfig.init(vm);
+
+    uint32_t bulkWriteEndIndex = 0;
+    if (dbConfig.getBulkSync() && !checkpoints.getCheckpointHeights().empty()) {
+      bulkWriteEndIndex = checkpoints.getCheckpointHeights().back() + 1;
+    }
+
+    // core owns the storage, so it outlives the root cache reading raw blocks from it
+    auto mainChainStorage = createMappedMainChainStorage(data_dir_path.string(), currency);
+    const IMainChainStorage* rawBlocksStorage = dbConfig.getRawBlocksInStorage() ? mainChainStorage.get() : nullptr;
+    std::string keyOutputTableFilename = (data_dir_path / "keyoutputs.dat").string();
+
     System::Dispatcher dispatcher;
     logger(INFO) << "Initializing core...";
     CryptoNote::Core ccore(
@@ -283,8 +298,10 @@ int main(int argc, char* argv[])
       logManager,
       std::move(checkpoints),
       dispatcher,
-      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger())),
-      createSwappedMainChainStorage(data_dir_path.string(), currency));
+      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger(), bulkWriteEndIndex, rawBlocksStorage,
+        keyOutputTableFilename, dbConfig.getObjectCacheSize())),
+      std::move(mainChainStorage),
+      coreConfig);
 	
     ccore.load();
     logger(INFO) << "Core initialized OK";
@@ -82,10 +82,14 @@ namespace CryptoNote
   {
     uint32_t current_height;
     Crypto::Hash top_id;
+    uint32_t pruned_height; //peer has no transactions of blocks below it
 
     void serialize(ISerializer& s) {
       KV_MEMBER(current_height)
       KV_MEMBER(top_id)
+      if (!s(pruned_height, "pruned_height")) {
+        pruned_height = 0;
+      }
     }
   };
 
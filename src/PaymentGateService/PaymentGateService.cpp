@@ -201,7 +201,7 @@ void PaymentGateService::runInProcess(Logging::LoggerRef& log) {
     CryptoNote::Checkpoints(logger),
     *dispatcher,
     std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(database, log.getLogger())),
-    CryptoNote::createSwappedMainChainStorage(dbConfig.getDataDir(), currency));
+    CryptoNote::createMappedMainChainStorage(dbConfig.getDataDir(), currency));
 
   core.load();
 
@@ -249,6 +249,39 @@ void MemoryMappedFile::flush(uint8_t* data, uint64_t size) {
   }
 }
 
+void MemoryMappedFile::resize(uint64_t newSize, std::error_code& ec) {
+  assert(isOpened());
+  assert(newSize >= m_size);
+
+  int result = ::ftruncate(m_file, static_cast<off_t>(newSize));
+  if (result == -1) {
+    ec = std::error_code(errno, std::system_category());
+    return;
+  }
+
+  // the new mapping is made before the old one is dropped, so a failure leaves the file mapped
+  uint8_t* newData = reinterpret_cast<uint8_t*>(::mmap(nullptr, static_cast<size_t>(newSize), PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0));
+  if (newData == MAP_FAILED) {
+    ec = std::error_code(errno, std::system_category());
+    return;
+  }
+
+  result = ::munmap(m_data, static_cast<size_t>(m_size));
+  m_data = newData;
+  m_size = newSize;
+  ec = result == -1 ? std::error_code(errno, std::system_category()) : std::error_code();
+}
+
+void MemoryMappedFile::resize(uint64_t newSize) {
+  assert(isOpened());
+
+  std::error_code ec;
+  resize(newSize, ec);
+  if (ec) {
+    throw std::system_error(ec, "MemoryMappedFile::resize");
+  }
+}
+
 void MemoryMappedFile::swap(MemoryMappedFile& other) {
   std::swap(m_file, other.m_file);
   std::swap(m_path, other.m_path);
@@ -47,6 +47,10 @@ public:
   void flush(uint8_t* data, uint64_t size, std::error_code& ec);
   void flush(uint8_t* data, uint64_t size);
 
+  // extends the file and maps it again, pointers to the old mapping become invalid
+  void resize(uint64_t newSize, std::error_code& ec);
+  void resize(uint64_t newSize);
+
   void swap(MemoryMappedFile& other);
 
 private:
@@ -282,6 +282,47 @@ void MemoryMappedFile::flush(uint8_t* data, uint64_t size) {
   }
 }
 
+void MemoryMappedFile::resize(uint64_t newSize, std::error_code& ec) {
+  assert(isOpened());
+  assert(newSize >= m_size);
+
+  // a mapping larger than the file extends it, the new view is made before the old one is dropped,
+  // so a failure leaves the file mapped
+  HANDLE newMappingHandle = ::CreateFileMapping(m_fileHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(newSize >> 32),
+    static_cast<DWORD>(newSize & UINT64_C(0xffffffff)), NULL);
+  if (newMappingHandle == NULL) {
+    ec = std::error_code(::GetLastError(), std::system_category());
+    return;
+  }
+
+  uint8_t* newData = reinterpret_cast<uint8_t*>(::MapViewOfFile(newMappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+  if (newData == NULL) {
+    ec = std::error_code(::GetLastError(), std::system_category());
+    ::CloseHandle(newMappingHandle);
+    return;
+  }
+
+  BOOL result = ::UnmapViewOfFile(m_data);
+  if (result) {
+    result = ::CloseHandle(m_mappingHandle);
+  }
+
+  m_data = newData;
+  m_mappingHandle = newMappingHandle;
+  m_size = newSize;
+  ec = result ? std::error_code() : std::error_code(::GetLastError(), std::system_category());
+}
+
+void MemoryMappedFile::resize(uint64_t newSize) {
+  assert(isOpened());
+
+  std::error_code ec;
+  resize(newSize, ec);
+  if (ec) {
+    throw std::system_error(ec, "MemoryMappedFile::resize");
+  }
+}
+
 void MemoryMappedFile::swap(MemoryMappedFile& other) {
   std::swap(m_fileHandle, other.m_fileHandle);
   std::swap(m_mappingHandle, other.m_mappingHandle);
@@ -296,6 +296,36 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   };
 };
 
+struct COMMAND_RPC_GET_POOL_CHANGES_SINCE {
+  struct request {
+    Crypto::Hash tailBlockId;
+    uint64_t sequence; // sequence from the previous response, any value for the first request
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(sequence)
+    }
+  };
+
+  struct response {
+    bool isTailBlockActual;
+    bool isFullResync; // addedTxs holds the whole pool, transactions known before and not in it are deleted
+    uint64_t sequence;
+    std::vector<TransactionPrefixInfo> addedTxs;
+    std::vector<Crypto::Hash> deletedTxsIds;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(isTailBlockActual)
+      KV_MEMBER(isFullResync)
+      KV_MEMBER(sequence)
+      KV_MEMBER(addedTxs)
+      serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(status)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
   
@@ -33,6 +33,7 @@
 
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
+#include "System/RemoteContext.h"
 
 #undef ERROR
 
@@ -115,6 +116,7 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
   { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
   { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
+  { "/get_pool_changes_since.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_SINCE>(&RpcServer::onGetPoolChangesSince), false } },
   { "/get_blocks_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false } },
   { "/get_blocks_hashes_by_timestamps.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::onGetBlocksHashesByTimestamps), false } },
   { "/get_transaction_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES>(&RpcServer::onGetTransactionDetailsByHashes), false } },
@@ -344,6 +346,14 @@ bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::re
   return true;
 }
 
+bool RpcServer::onGetPoolChangesSince(const COMMAND_RPC_GET_POOL_CHANGES_SINCE::request& req, COMMAND_RPC_GET_POOL_CHANGES_SINCE::response& rsp) {
+  rsp.status = CORE_RPC_STATUS_OK;
+  rsp.sequence = req.sequence;
+  rsp.isTailBlockActual = m_core.getPoolChangesSince(req.tailBlockId, rsp.sequence, rsp.addedTxs, rsp.deletedTxsIds, rsp.isFullResync);
+
+  return true;
+}
+
 bool RpcServer::onGetBlocksDetailsByHashes(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES::request& req, COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES::response& rsp) {
   try {
     std::vector<BlockDetails> blockDetails;
@@ -461,10 +471,32 @@ bool RpcServer::on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request&
 
   std::vector<Hash> missed_txs;
   std::vector<BinaryArray> txs;
-  m_core.getTransactions(vh, txs, missed_txs);
 
+  // confirmed transactions are read from a data base snapshot on another thread, so blocks keep being processed meanwhile
+  std::vector<Hash> notStored;
+  auto snapshot = m_core.createReadSnapshot();
+  if (snapshot) {
+    System::RemoteContext<void>(m_dispatcher, [&] { snapshot->getRawTransactions(vh, txs, notStored); }).get();
+  } else {
+    notStored = vh;
+  }
+
+  if (!notStored.empty()) {
+    m_core.getTransactions(notStored, txs, missed_txs);
+  }
+
+  // transactions found by the snapshot and by the core are answered in the order they were requested
+  std::unordered_map<Hash, BinaryArray> foundTxs;
   for (auto& tx : txs) {
-    res.txs_as_hex.push_back(toHex(tx));
+    auto hash = getBinaryArrayHash(tx);
+    foundTxs.emplace(hash, std::move(tx));
+  }
+
+  for (const auto& hash : vh) {
+    auto it = foundTxs.find(hash);
+    if (it != foundTxs.end()) {
+      res.txs_as_hex.push_back(toHex(it->second));
+    }
   }
 
   for (const auto& miss_tx : missed_txs) {
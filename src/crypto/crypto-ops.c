@@ -16,6 +16,7 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "crypto-ops.h"
@@ -1603,6 +1604,37 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* Encodes count points sharing a single field inversion (Montgomery's trick).
+   scratch must have room for count field elements. */
+
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, fe *scratch, size_t count) {
+  fe recip;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+  fe_copy(scratch[0], h[0].Z);
+  for (i = 1; i < count; i++) {
+    fe_mul(scratch[i], scratch[i - 1], h[i].Z);
+  }
+  fe_invert(recip, scratch[count - 1]);
+  for (i = count - 1; i > 0; i--) {
+    fe_mul(y, recip, scratch[i - 1]);
+    fe_mul(recip, recip, h[i].Z);
+    fe_mul(x, h[i].X, y);
+    fe_mul(y, h[i].Y, y);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, recip);
+  fe_mul(y, h[0].Y, recip);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
 /* From sc_reduce.c */
 
 /*
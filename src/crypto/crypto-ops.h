@@ -93,6 +93,7 @@ void ge_sub(ge_p1p1 *, const ge_p3 *, const ge_cached *);
 /* From ge_tobytes.c */
 
 void ge_tobytes(unsigned char *, const ge_p2 *);
+void ge_tobytes_batch(unsigned char *, const ge_p2 *, fe *, size_t);
 
 /* From sc_reduce.c */
 
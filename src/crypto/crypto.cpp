@@ -23,6 +23,8 @@
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/Varint.h"
 #include "crypto.h"
@@ -443,4 +445,84 @@ namespace Crypto {
     sc_sub(reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sum));
     return sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) == 0;
   }
+
+  bool crypto_ops::check_ring_signatures(const RingSignatureEntry *entries, size_t count) {
+    struct RingMember {
+      ge_p3 point;
+      ge_p3 hashedPoint;
+    };
+
+    std::unordered_map<PublicKey, size_t> memberIndexes;
+    std::vector<RingMember> members;
+    std::vector<EllipticCurveScalar> sums(count);
+    std::vector<ge_p2> points;
+    size_t i, j;
+
+    size_t pointCount = 0;
+    for (i = 0; i < count; i++) {
+      pointCount += 2 * entries[i].pubs_count;
+    }
+    points.reserve(pointCount);
+
+    for (i = 0; i < count; i++) {
+      const RingSignatureEntry &entry = entries[i];
+      ge_p3 image_unp;
+      ge_dsmp image_pre;
+#if !defined(NDEBUG)
+      for (j = 0; j < entry.pubs_count; j++) {
+        assert(check_key(*entry.pubs[j]));
+      }
+#endif
+      if (ge_frombytes_vartime(&image_unp, reinterpret_cast<const unsigned char*>(entry.image)) != 0) {
+        return false;
+      }
+      ge_dsm_precomp(image_pre, &image_unp);
+      if (entry.checkKeyImage && ge_check_subgroup_precomp_vartime(image_pre) != 0) {
+        return false;
+      }
+      sc_0(reinterpret_cast<unsigned char*>(&sums[i]));
+      for (j = 0; j < entry.pubs_count; j++) {
+        const unsigned char *sig = reinterpret_cast<const unsigned char*>(&entry.sig[j]);
+        ge_p2 tmp2;
+        if (sc_check(sig) != 0 || sc_check(sig + 32) != 0) {
+          return false;
+        }
+        auto inserted = memberIndexes.emplace(*entry.pubs[j], members.size());
+        if (inserted.second) {
+          members.emplace_back();
+          if (ge_frombytes_vartime(&members.back().point, reinterpret_cast<const unsigned char*>(entry.pubs[j])) != 0) {
+            abort();
+          }
+          hash_to_ec(*entry.pubs[j], members.back().hashedPoint);
+        }
+        const RingMember &member = members[inserted.first->second];
+        ge_double_scalarmult_base_vartime(&tmp2, sig, &member.point, sig + 32);
+        points.push_back(tmp2);
+        ge_double_scalarmult_precomp_vartime(&tmp2, sig + 32, &member.hashedPoint, sig, image_pre);
+        points.push_back(tmp2);
+        sc_add(reinterpret_cast<unsigned char*>(&sums[i]), reinterpret_cast<unsigned char*>(&sums[i]), sig);
+      }
+    }
+
+    // Encoded points are laid out exactly like rs_comm::ab, two per ring member.
+    std::vector<EllipticCurvePoint> encoded(pointCount);
+    std::unique_ptr<fe[]> scratch(new fe[pointCount]);
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(encoded.data()), points.data(), scratch.get(), pointCount);
+
+    const EllipticCurvePoint *ab = encoded.data();
+    for (i = 0; i < count; i++) {
+      const RingSignatureEntry &entry = entries[i];
+      EllipticCurveScalar h;
+      std::vector<uint8_t> buf(rs_comm_size(entry.pubs_count));
+      memcpy(buf.data(), entry.prefix_hash, sizeof(Hash));
+      memcpy(buf.data() + sizeof(Hash), ab, 2 * entry.pubs_count * sizeof(EllipticCurvePoint));
+      ab += 2 * entry.pubs_count;
+      hash_to_scalar(buf.data(), buf.size(), h);
+      sc_sub(reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sums[i]));
+      if (sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
 }
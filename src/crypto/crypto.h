@@ -44,6 +44,17 @@ struct EllipticCurveScalar {
   uint8_t data[32];
 };
 
+/* One ring signature of a batch passed to check_ring_signatures.
+ */
+struct RingSignatureEntry {
+  const Hash *prefix_hash;
+  const KeyImage *image;
+  const PublicKey *const *pubs;
+  size_t pubs_count;
+  const Signature *sig;
+  bool checkKeyImage;
+};
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -92,6 +103,8 @@ struct EllipticCurveScalar {
       const PublicKey *const *, size_t, const Signature *, bool);
     friend bool check_ring_signature(const Hash &, const KeyImage &,
       const PublicKey *const *, size_t, const Signature *, bool);
+    static bool check_ring_signatures(const RingSignatureEntry *, size_t);
+    friend bool check_ring_signatures(const RingSignatureEntry *, size_t);
   };
 
   /* Generate a value filled with random bytes.
@@ -235,6 +248,13 @@ struct EllipticCurveScalar {
     return crypto_ops::check_ring_signature(prefix_hash, image, pubs, pubs_count, sig, checkKeyImage);
   }
 
+  /* Checks a batch of ring signatures, returns true only if all of them are valid.
+   * Ring members shared by several signatures are decoded once and all points are encoded with a single field inversion.
+   */
+  inline bool check_ring_signatures(const RingSignatureEntry *entries, size_t count) {
+    return crypto_ops::check_ring_signatures(entries, count);
+  }
+
   /* Variants with vector<const PublicKey *> parameters.
    */
   inline void generate_ring_signature(const Hash &prefix_hash, const KeyImage &image,
@@ -17,6 +17,9 @@
 
 #include "VectorMainChainStorage.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include <CryptoNoteCore/CryptoNoteTools.h>
 
 namespace CryptoNote {
@@ -26,10 +29,18 @@ void VectorMainChainStorage::pushBlock(const RawBlock& rawBlock) {
 }
 
 void VectorMainChainStorage::popBlock() {
+  if (storage.size() <= prunedBlockCount) {
+    throw std::runtime_error("Can't pop pruned block");
+  }
+
   storage.pop_back();
 }
 
 RawBlock VectorMainChainStorage::getBlockByIndex(uint32_t index) const {
+  if (index < prunedBlockCount) {
+    throw std::out_of_range("Block " + std::to_string(index) + " is pruned");
+  }
+
   return storage.at(index);
 }
 
@@ -37,8 +48,20 @@ uint32_t VectorMainChainStorage::getBlockCount() const {
   return static_cast<uint32_t>(storage.size());
 }
 
+void VectorMainChainStorage::pruneBlocks(uint32_t endIndex) {
+  endIndex = std::min(endIndex, getBlockCount());
+  for (; prunedBlockCount < endIndex; ++prunedBlockCount) {
+    storage[prunedBlockCount] = RawBlock();
+  }
+}
+
+uint32_t VectorMainChainStorage::getPrunedBlockCount() const {
+  return prunedBlockCount;
+}
+
 void VectorMainChainStorage::clear() {
   storage.clear();
+  prunedBlockCount = 0;
 }
 
 std::unique_ptr<IMainChainStorage> createVectorMainChainStorage(const Currency& currency) {
@@ -30,10 +30,13 @@ public:
   virtual void popBlock() override;
   virtual RawBlock getBlockByIndex(uint32_t index) const override;
   virtual uint32_t getBlockCount() const override;
+  virtual void pruneBlocks(uint32_t endIndex) override;
+  virtual uint32_t getPrunedBlockCount() const override;
   virtual void clear() override;
 
 private:
   std::vector<RawBlock> storage;
+  uint32_t prunedBlockCount = 0;
 };
 
 std::unique_ptr<IMainChainStorage> createVectorMainChainStorage(const Currency& currency);
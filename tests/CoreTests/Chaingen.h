@@ -229,6 +229,11 @@ public:
     return !blockWasNotAdded(err);
   }
 
+  // configuration of the core the events are replayed through, tests hide it to change the defaults
+  CryptoNote::CoreConfig coreConfig() const {
+    return CryptoNote::CoreConfig();
+  }
+
 protected:
   mutable Logging::ConsoleLogger m_logger;
   std::unique_ptr<CryptoNote::Currency> m_currency;
@@ -490,7 +495,8 @@ inline bool do_replay_events(std::vector<test_event_entry>& events, t_test_class
       CryptoNote::Checkpoints(logger),
       dispatcher,
       std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(database, logger)),
-      CryptoNote::createVectorMainChainStorage(validator.currency()));
+      CryptoNote::createVectorMainChainStorage(validator.currency()),
+      validator.coreConfig());
     c.load();
     return replay_events_through_core<t_test_class>(c, events, validator);
   } catch (std::exception& e) {
@@ -150,6 +150,7 @@ int main(int argc, char* argv[]) {
       GENERATE_AND_PLAY(gen_tx_output_with_zero_amount);
       GENERATE_AND_PLAY(gen_tx_signatures_are_invalid);
       GENERATE_AND_PLAY(GenerateTransactionWithZeroFee);
+      GENERATE_AND_PLAY(GenerateTransactionBatchForPool);
 
       GENERATE_AND_PLAY(gen_uint_overflow_1);
       GENERATE_AND_PLAY(gen_uint_overflow_2);
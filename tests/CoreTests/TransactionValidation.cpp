@@ -15,6 +15,8 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <unordered_set>
+
 #include "TransactionValidation.h"
 #include "TestGenerator.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -689,3 +691,74 @@ bool GenerateTransactionWithZeroFee::generate(std::vector<test_event_entry>& eve
 
   return true;
 }
+
+namespace {
+// room for two of the test transactions but not for three
+const uint64_t BATCH_TEST_POOL_MAX_SIZE = 600;
+}
+
+GenerateTransactionBatchForPool::GenerateTransactionBatchForPool() {
+  REGISTER_CALLBACK_METHOD(GenerateTransactionBatchForPool, checkBatches);
+}
+
+CryptoNote::CoreConfig GenerateTransactionBatchForPool::coreConfig() const {
+  CryptoNote::CoreConfig config;
+  config.setPoolMaxSize(BATCH_TEST_POOL_MAX_SIZE);
+  return config;
+}
+
+bool GenerateTransactionBatchForPool::generate(std::vector<test_event_entry>& events) const {
+  GENERATE_ACCOUNT(miner_account);
+  MAKE_GENESIS_BLOCK(events, blk_0, miner_account, ts_start);
+  events.push_back(miner_account);
+  MAKE_ACCOUNT(events, alice_account);
+  MAKE_ACCOUNT(events, bob_account);
+  MAKE_ACCOUNT(events, carol_account);
+  MAKE_NEXT_BLOCK(events, blk_1, blk_0, alice_account);
+  MAKE_NEXT_BLOCK(events, blk_2, blk_1, bob_account);
+  MAKE_NEXT_BLOCK(events, blk_3, blk_2, carol_account);
+  REWIND_BLOCKS(events, blk_3r, blk_3, miner_account);
+
+  DO_CALLBACK(events, "checkBatches");
+  return true;
+}
+
+bool GenerateTransactionBatchForPool::checkBatches(CryptoNote::Core& c, size_t ev_index,
+                                                   const std::vector<test_event_entry>& events) {
+  DEFINE_TESTS_ERROR_CONTEXT("GenerateTransactionBatchForPool::checkBatches");
+
+  const AccountBase& minerAccount = boost::get<AccountBase>(events[1]);
+  const AccountBase& aliceAccount = boost::get<AccountBase>(events[2]);
+  const AccountBase& bobAccount = boost::get<AccountBase>(events[3]);
+  const AccountBase& carolAccount = boost::get<AccountBase>(events[4]);
+  const BlockTemplate& head = boost::get<BlockTemplate>(events[ev_index - 1]);
+
+  auto makeTransaction = [&] (const AccountBase& from, uint64_t fee) {
+    Transaction tx;
+    construct_tx_to_key(m_logger, events, tx, head, from, minerAccount, MK_COINS(1), fee, 0);
+    return toBinaryArray(tx);
+  };
+
+  // the first spend of a key image wins even if the later one pays more, duplicates and garbage are rejected
+  auto aliceTransaction = makeTransaction(aliceAccount, 10 * m_currency->minimumFee());
+  auto aliceDoubleSpend = makeTransaction(aliceAccount, 20 * m_currency->minimumFee());
+  auto added = c.addTransactionsToPool({BinaryArray{1, 2, 3}, aliceTransaction, aliceTransaction, aliceDoubleSpend});
+  CHECK_TEST_CONDITION(added == std::vector<bool>({false, true, false, false}));
+  CHECK_EQ(1, c.getPoolTransactionCount());
+
+  // the pool takes one more transaction, so the better paying bob's one evicts carol's one of the same batch
+  auto carolTransaction = makeTransaction(carolAccount, 2 * m_currency->minimumFee());
+  auto bobTransaction = makeTransaction(bobAccount, 5 * m_currency->minimumFee());
+  CHECK_TEST_CONDITION(aliceTransaction.size() + carolTransaction.size() <= BATCH_TEST_POOL_MAX_SIZE);
+  CHECK_TEST_CONDITION(aliceTransaction.size() + bobTransaction.size() <= BATCH_TEST_POOL_MAX_SIZE);
+  CHECK_TEST_CONDITION(aliceTransaction.size() + carolTransaction.size() + bobTransaction.size() > BATCH_TEST_POOL_MAX_SIZE);
+
+  added = c.addTransactionsToPool({carolTransaction, bobTransaction});
+  CHECK_TEST_CONDITION(added == std::vector<bool>({false, true}));
+
+  auto poolHashes = c.getPoolTransactionHashes();
+  std::unordered_set<Crypto::Hash> expectedHashes{getBinaryArrayHash(aliceTransaction), getBinaryArrayHash(bobTransaction)};
+  CHECK_TEST_CONDITION(std::unordered_set<Crypto::Hash>(poolHashes.begin(), poolHashes.end()) == expectedHashes);
+
+  return true;
+}
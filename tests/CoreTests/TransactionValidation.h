@@ -122,3 +122,11 @@ struct GenerateTransactionWithZeroFee : public get_tx_validation_base
 {
   bool generate(std::vector<test_event_entry>& events) const;
 };
+
+struct GenerateTransactionBatchForPool : public get_tx_validation_base {
+  GenerateTransactionBatchForPool();
+
+  CryptoNote::CoreConfig coreConfig() const;
+  bool generate(std::vector<test_event_entry>& events) const;
+  bool checkBatches(CryptoNote::Core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+};
@@ -28,7 +28,7 @@
 #include "MultiTransactionTestBase.h"
 
 template<size_t a_ring_size>
-class test_check_ring_signature : private multi_tx_test_base<a_ring_size>
+class test_check_ring_signature : protected multi_tx_test_base<a_ring_size>
 {
   static_assert(0 < a_ring_size, "ring_size must be greater than 0");
 
@@ -64,8 +64,41 @@ public:
     return Crypto::check_ring_signature(m_tx_prefix_hash, txin.keyImage, this->m_public_key_ptrs, ring_size, m_tx.signatures[0].data(), true);
   }
 
-private:
+protected:
   CryptoNote::AccountBase m_alice;
   CryptoNote::Transaction m_tx;
   Crypto::Hash m_tx_prefix_hash;
 };
+
+template<size_t a_ring_size, size_t a_batch_size>
+class test_check_ring_signatures : private test_check_ring_signature<a_ring_size>
+{
+  static_assert(0 < a_batch_size, "batch_size must be greater than 0");
+
+public:
+  static const size_t loop_count = test_check_ring_signature<a_ring_size>::loop_count;
+  static const size_t ring_size = a_ring_size;
+  static const size_t batch_size = a_batch_size;
+
+  typedef test_check_ring_signature<a_ring_size> base_class;
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    const CryptoNote::KeyInput& txin = boost::get<CryptoNote::KeyInput>(this->m_tx.inputs[0]);
+    Crypto::RingSignatureEntry entry = { &this->m_tx_prefix_hash, &txin.keyImage, this->m_public_key_ptrs, ring_size, this->m_tx.signatures[0].data(), true };
+    m_entries.assign(batch_size, entry);
+
+    return true;
+  }
+
+  bool test()
+  {
+    return Crypto::check_ring_signatures(m_entries.data(), m_entries.size());
+  }
+
+private:
+  std::vector<Crypto::RingSignatureEntry> m_entries;
+};
@@ -0,0 +1,110 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DifficultyCache.h"
+
+#include "Logging/ConsoleLogger.h"
+
+// Per block cost of the next block difficulty calculation over a window of a_window blocks
+template<size_t a_window>
+class next_difficulty_test_base
+{
+public:
+  next_difficulty_test_base() : m_currency(CryptoNote::CurrencyBuilder(m_logger).difficultyWindow(a_window).currency())
+  {
+  }
+
+  bool init()
+  {
+    for (size_t i = 0; i < m_currency.difficultyBlocksCount(); ++i)
+    {
+      push_block();
+    }
+
+    return true;
+  }
+
+protected:
+  void push_block()
+  {
+    uint64_t index = m_timestamps.size();
+    m_timestamps.push_back(1000000 + index * m_currency.difficultyTarget() + (index * 7919) % 113);
+    m_cumulative_difficulties.push_back((index + 1) * 1000);
+  }
+
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::Currency m_currency;
+  std::vector<uint64_t> m_timestamps;
+  std::vector<CryptoNote::Difficulty> m_cumulative_difficulties;
+};
+
+// Window is rebuilt and sorted for every block
+template<size_t a_window>
+class test_next_difficulty : public next_difficulty_test_base<a_window>
+{
+public:
+  static const size_t loop_count = 100000;
+
+  bool test()
+  {
+    this->push_block();
+
+    size_t count = this->m_currency.difficultyBlocksCount();
+    std::vector<uint64_t> timestamps(this->m_timestamps.end() - count, this->m_timestamps.end());
+    std::vector<CryptoNote::Difficulty> cumulative_difficulties(this->m_cumulative_difficulties.end() - count, this->m_cumulative_difficulties.end());
+    return this->m_currency.nextDifficulty(std::move(timestamps), std::move(cumulative_difficulties)) != 0;
+  }
+};
+
+// Window is updated by DifficultyCache with every pushed block
+template<size_t a_window>
+class test_next_difficulty_cached : public next_difficulty_test_base<a_window>
+{
+public:
+  typedef next_difficulty_test_base<a_window> base_class;
+
+  static const size_t loop_count = 100000;
+
+  test_next_difficulty_cached() : m_cache(this->m_currency)
+  {
+  }
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    m_cache.load(static_cast<uint32_t>(this->m_timestamps.size()), this->m_timestamps, this->m_cumulative_difficulties);
+    return true;
+  }
+
+  bool test()
+  {
+    this->push_block();
+
+    m_cache.push(static_cast<uint32_t>(this->m_timestamps.size()), this->m_timestamps.back(), this->m_cumulative_difficulties.back());
+    return m_cache.getNextDifficulty() != 0;
+  }
+
+private:
+  CryptoNote::DifficultyCache m_cache;
+};
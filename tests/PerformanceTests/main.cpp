@@ -28,6 +28,7 @@
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "NextDifficulty.h"
 
 int main(int argc, char** argv)
 {
@@ -63,6 +64,11 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  TEST_PERFORMANCE2(test_check_ring_signatures, 1, 10);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 2, 10);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 10, 10);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 100, 10);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
@@ -72,6 +78,11 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE1(test_next_difficulty, 17);
+  TEST_PERFORMANCE1(test_next_difficulty_cached, 17);
+  TEST_PERFORMANCE1(test_next_difficulty, 720);
+  TEST_PERFORMANCE1(test_next_difficulty_cached, 720);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
@@ -19,6 +19,42 @@
 
 using namespace CryptoNote;
 
+namespace {
+
+void readState(const std::map<std::string, std::string>& state, IReadBatch& batch) {
+  auto keys = batch.getRawKeys();
+  std::vector<std::string> kvs;
+  std::vector<bool> states;
+  for (auto key : keys) {
+    auto it = state.find(key);
+    if (it != state.end()) {
+      kvs.push_back(it->second);
+      states.push_back(true);
+    } else {
+      kvs.push_back("");
+      states.push_back(false);
+    }
+  }
+
+  batch.submitRawResult(kvs, states);
+}
+
+class DataBaseMockSnapshot : public IDataBaseSnapshot {
+public:
+  explicit DataBaseMockSnapshot(const std::map<std::string, std::string>& state) : state(state) {
+  }
+
+  std::error_code read(IReadBatch& batch) override {
+    readState(state, batch);
+    return{};
+  }
+
+private:
+  const std::map<std::string, std::string> state;
+};
+
+}
+
 DataBaseMock::~DataBaseMock() {
 
 }
@@ -40,24 +76,22 @@ std::error_code DataBaseMock::writeSync(IWriteBatch& batch) {
 }
 
 std::error_code DataBaseMock::read(IReadBatch& batch) {
-  auto keys = batch.getRawKeys();
-  std::vector<std::string> kvs;
-  std::vector<bool> states;
-  for (auto key : keys) {
-    auto it = baseState.find(key);
-    if (it != baseState.end()) {
-      kvs.push_back(it->second);
-      states.push_back(true);
-    } else {
-      kvs.push_back("");
-      states.push_back(false);
-    }
-  }
+  ++readCount;
+  readState(baseState, batch);
+  return{};
+}
 
-  batch.submitRawResult(kvs, states);
+void DataBaseMock::beginBulkWrite() {
+}
+
+std::error_code DataBaseMock::endBulkWrite() {
   return{};
 }
 
+std::unique_ptr<IDataBaseSnapshot> DataBaseMock::createSnapshot() {
+  return std::unique_ptr<IDataBaseSnapshot>(new DataBaseMockSnapshot(baseState));
+}
+
 std::unordered_map<uint32_t, RawBlock> DataBaseMock::blocks() {
   BlockchainReadBatch req;
   for (int i = 0; i < 30; ++i) {
@@ -34,8 +34,12 @@ public:
   std::error_code write(IWriteBatch& batch) override;
   std::error_code writeSync(IWriteBatch& batch) override;
   std::error_code read(IReadBatch& batch) override;
+  void beginBulkWrite() override;
+  std::error_code endBulkWrite() override;
+  std::unique_ptr<IDataBaseSnapshot> createSnapshot() override;
   std::unordered_map<uint32_t, RawBlock> blocks();
 
   std::map<std::string, std::string> baseState;
+  size_t readCount = 0;
 };
 }
@@ -127,6 +127,12 @@ bool ICoreStub::getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::v
   return returnStatus;
 }
 
+bool ICoreStub::getPoolChangesSince(const Crypto::Hash& tailBlockId, uint64_t& sequence,
+          std::vector<CryptoNote::TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& fullResync) const {
+  fullResync = true;
+  return getPoolChangesLite(tailBlockId, {}, addedTxs, deletedTxsIds);
+}
+
 bool ICoreStub::queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockFullInfo>& entries) const {
   //stub
@@ -182,6 +188,10 @@ bool ICoreStub::removeMessageQueue(MessageQueue<BlockchainMessage>& messageQueue
 uint32_t ICoreStub::getTopBlockIndex() const {
   return topHeight;
 }
+
+uint32_t ICoreStub::getPrunedBlockCount() const {
+  return 0;
+}
   
 Crypto::Hash ICoreStub::getTopBlockHash() const {
   return topId;
@@ -287,6 +297,15 @@ bool ICoreStub::addTransactionToPool(const CryptoNote::BinaryArray& transactionB
   return true;
 }
 
+std::vector<bool> ICoreStub::addTransactionsToPool(const std::vector<CryptoNote::BinaryArray>& transactionBinaryArrays) {
+  std::vector<bool> added;
+  for (const auto& transactionBinaryArray : transactionBinaryArrays) {
+    added.push_back(addTransactionToPool(transactionBinaryArray));
+  }
+
+  return added;
+}
+
 std::vector<Crypto::Hash> ICoreStub::getPoolTransactionHashes() const {
   assert(false);
   return {};
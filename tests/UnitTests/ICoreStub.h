@@ -46,6 +46,7 @@ public:
   virtual uint32_t getTopBlockIndex() const override;
   virtual Crypto::Hash getTopBlockHash() const override;
   virtual uint64_t getBlockTimestampByIndex(uint32_t blockIndex) const override;
+  virtual uint32_t getPrunedBlockCount() const override;
   virtual CryptoNote::BlockTemplate getBlockByIndex(uint32_t index) const override;
 
   virtual CryptoNote::Difficulty getDifficultyForNextBlock() const override;
@@ -57,6 +58,7 @@ public:
   virtual void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<CryptoNote::RawBlock>& blocks, std::vector<Crypto::Hash>& missedHashes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
   virtual bool addTransactionToPool(const CryptoNote::BinaryArray& transactionBinaryArray) override;
+  virtual std::vector<bool> addTransactionsToPool(const std::vector<CryptoNote::BinaryArray>& transactionBinaryArrays) override;
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
   virtual bool getBlockTemplate(CryptoNote::BlockTemplate& b, const CryptoNote::AccountPublicAddress& adr, const CryptoNote::BinaryArray& extraNonce, CryptoNote::Difficulty& difficulty, uint32_t& height) const override;
 
@@ -70,6 +72,8 @@ public:
   virtual bool getPoolChanges(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds, std::vector<CryptoNote::BinaryArray>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) const override;
   virtual bool getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds,
           std::vector<CryptoNote::TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) const override;
+  virtual bool getPoolChangesSince(const Crypto::Hash& tailBlockId, uint64_t& sequence,
+          std::vector<CryptoNote::TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, bool& fullResync) const override;
   virtual bool queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockFullInfo>& entries) const override;
   virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
@@ -0,0 +1,89 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include "Common/Math.h"
+#include "Common/RollingMedian.h"
+
+#include <deque>
+#include <random>
+
+using namespace Common;
+
+namespace {
+
+uint64_t referenceMedian(const std::deque<uint64_t>& window) {
+  std::vector<uint64_t> values(window.begin(), window.end());
+  return medianValue(values);
+}
+
+}
+
+TEST(RollingMedianTests, emptyWindowReturnsDefault) {
+  RollingMedian<uint64_t> median(10);
+  ASSERT_EQ(0, median.median());
+  ASSERT_EQ(0, median.size());
+}
+
+TEST(RollingMedianTests, averagesTwoMiddleValues) {
+  RollingMedian<uint64_t> median(10);
+  median.push(10);
+  median.push(20);
+  ASSERT_EQ(15, median.median());
+  median.push(1);
+  ASSERT_EQ(10, median.median());
+}
+
+TEST(RollingMedianTests, evictsOldestValue) {
+  RollingMedian<uint64_t> median(3);
+  median.push(100);
+  median.push(1);
+  median.push(2);
+  median.push(3);
+  ASSERT_EQ(3, median.size());
+  ASSERT_EQ(2, median.median());
+}
+
+TEST(RollingMedianTests, clearResetsWindow) {
+  RollingMedian<uint64_t> median(3);
+  median.push(5);
+  median.push(7);
+  median.clear();
+  ASSERT_EQ(0, median.size());
+  median.push(9);
+  ASSERT_EQ(9, median.median());
+}
+
+TEST(RollingMedianTests, matchesFullSortWithDuplicates) {
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<uint64_t> distribution(0, 20);
+
+  for (size_t windowSize : {1, 2, 7, 100}) {
+    RollingMedian<uint64_t> median(windowSize);
+    std::deque<uint64_t> window;
+    for (size_t i = 0; i < 1000; ++i) {
+      uint64_t value = distribution(generator);
+      median.push(value);
+      window.push_back(value);
+      if (window.size() > windowSize) {
+        window.pop_front();
+      }
+
+      ASSERT_EQ(referenceMedian(window), median.median());
+    }
+  }
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+
+#include "CryptoNoteCore/BlockImportPipeline.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class MainChainStorageStub : public IMainChainStorage {
+public:
+  explicit MainChainStorageStub(uint32_t blockCount) : blockCount(blockCount) {
+  }
+
+  virtual void pushBlock(const RawBlock&) override {
+    ++blockCount;
+  }
+
+  virtual void popBlock() override {
+    --blockCount;
+  }
+
+  virtual RawBlock getBlockByIndex(uint32_t index) const override {
+    RawBlock block;
+    block.block.push_back(static_cast<uint8_t>(index));
+    return block;
+  }
+
+  virtual uint32_t getBlockCount() const override {
+    return blockCount;
+  }
+
+  virtual void pruneBlocks(uint32_t) override {
+  }
+
+  virtual uint32_t getPrunedBlockCount() const override {
+    return 0;
+  }
+
+  virtual void clear() override {
+    blockCount = 0;
+  }
+
+private:
+  uint32_t blockCount;
+};
+
+void prepareStub(PreparedBlock& block) {
+  if (block.index % 7 == 0) {
+    std::this_thread::yield();
+  }
+
+  block.cumulativeSize = block.rawBlock.block.at(0);
+  block.transactionsExtracted = true;
+}
+
+}
+
+TEST(BlockImportPipeline, deliversBlocksInOrder) {
+  MainChainStorageStub storage(1000);
+  BlockImportPipeline pipeline(storage, 10, storage.getBlockCount(), 4, &prepareStub);
+
+  for (uint32_t i = 10; i < storage.getBlockCount(); ++i) {
+    auto block = pipeline.next();
+    ASSERT_EQ(i, block->index);
+    ASSERT_TRUE(block->transactionsExtracted);
+    ASSERT_EQ(static_cast<uint8_t>(i), block->cumulativeSize);
+  }
+}
+
+TEST(BlockImportPipeline, worksWithoutThreadCount) {
+  MainChainStorageStub storage(100);
+  BlockImportPipeline pipeline(storage, 0, storage.getBlockCount(), 0, &prepareStub);
+
+  for (uint32_t i = 0; i < storage.getBlockCount(); ++i) {
+    ASSERT_EQ(i, pipeline.next()->index);
+  }
+}
+
+TEST(BlockImportPipeline, rethrowsPrepareError) {
+  MainChainStorageStub storage(100);
+  BlockImportPipeline pipeline(storage, 0, storage.getBlockCount(), 2, [] (PreparedBlock& block) {
+    if (block.index == 50) {
+      throw std::runtime_error("corrupted block");
+    }
+  });
+
+  for (uint32_t i = 0; i < 50; ++i) {
+    ASSERT_EQ(i, pipeline.next()->index);
+  }
+
+  ASSERT_THROW(pipeline.next(), std::runtime_error);
+}
+
+TEST(BlockImportPipeline, canBeDestroyedBeforeAllBlocksAreTaken) {
+  MainChainStorageStub storage(100000);
+  BlockImportPipeline pipeline(storage, 0, storage.getBlockCount(), 3, &prepareStub);
+
+  ASSERT_EQ(0, pipeline.next()->index);
+}
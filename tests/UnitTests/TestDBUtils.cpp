@@ -0,0 +1,41 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/DBUtils.h"
+
+using namespace CryptoNote;
+
+TEST(DBUtils, getKeyPrefixReturnsPrefixOfSerializedKey) {
+  Crypto::Hash hash = {};
+  hash.data[0] = 1;
+
+  ASSERT_EQ(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, DB::getKeyPrefix(DB::serializeKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, hash)));
+  ASSERT_EQ(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, DB::getKeyPrefix(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(10))));
+  ASSERT_EQ(DB::KEY_OUTPUT_KEY_PREFIX, DB::getKeyPrefix(DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(1), uint32_t(2)))));
+  ASSERT_EQ(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX,
+    DB::getKeyPrefix(DB::serializeKey(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::TRANSACTIONS_COUNT_KEY)));
+}
+
+TEST(DBUtils, getKeyPrefixReturnsEmptyStringForOtherKeys) {
+  ASSERT_EQ("", DB::getKeyPrefix(""));
+  ASSERT_EQ("", DB::getKeyPrefix("last_block_index"));
+  ASSERT_EQ("", DB::getKeyPrefix(DB::serialize(uint32_t(10), DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX)));
+
+  std::string key = DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(10));
+  ASSERT_EQ("", DB::getKeyPrefix(key.substr(0, 12)));
+}
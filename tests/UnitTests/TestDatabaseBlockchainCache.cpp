@@ -17,11 +17,19 @@
 
 #include "gtest/gtest.h"
 
+#include <numeric>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+
 #include "crypto/crypto.h"
 
 #include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/BlockchainReadSnapshot.h"
 #include <CryptoNoteCore/DatabaseBlockchainCache.h>
 #include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/IMainChainStorage.h"
+#include "CryptoNoteCore/TransactionExtra.h"
 #include "CryptoNoteCore/TransactionValidatiorState.h"
 #include "DataBaseMock.h"
 #include <CryptoNoteCore/DBUtils.h>
@@ -42,6 +50,20 @@ Hash randomBlockHash() {
   return hash;
 }
 
+class MainChainStorageStub : public IMainChainStorage {
+public:
+  virtual void pushBlock(const RawBlock& rawBlock) override { blocks.push_back(rawBlock); }
+  virtual void popBlock() override { blocks.pop_back(); }
+  virtual RawBlock getBlockByIndex(uint32_t index) const override { assert(index >= prunedBlockCount); return blocks.at(index); }
+  virtual uint32_t getBlockCount() const override { return static_cast<uint32_t>(blocks.size()); }
+  virtual void pruneBlocks(uint32_t endIndex) override { prunedBlockCount = std::max(prunedBlockCount, endIndex); }
+  virtual uint32_t getPrunedBlockCount() const override { return prunedBlockCount; }
+  virtual void clear() override { blocks.clear(); prunedBlockCount = 0; }
+
+  std::vector<RawBlock> blocks;
+  uint32_t prunedBlockCount = 0;
+};
+
 class DatabaseBlockchainCacheTests : public ::testing::Test {
 public:
   DatabaseBlockchainCacheTests()
@@ -186,3 +208,420 @@ TEST_F(DatabaseBlockchainCacheTests, RawBlocksWithTxsSerialization) {
   ASSERT_EQ(deserializedRawBlock.block, rawBlock.block);
   ASSERT_EQ(deserializedRawBlock.transactions, rawBlock.transactions);
 }
+
+TEST_F(DatabaseBlockchainCacheTests, ReadSnapshotDoesNotSeeNewBlocks) {
+  BlockchainReadSnapshot snapshot(database.createSnapshot(), blockchain.getTopBlockIndex());
+
+  generator.generateEmptyBlocks(1);
+  TransactionValidatorState state;
+  auto& block = generator.getBlockchain().back();
+  blockchain.pushBlock(CachedBlock{block}, {}, state, 0, 0, 0, { toBinaryArray(block), {} });
+
+  std::vector<BinaryArray> transactions;
+  std::vector<Hash> missedHashes;
+  snapshot.getRawTransactions({ getObjectHash(block.baseTransaction) }, transactions, missedHashes);
+
+  ASSERT_EQ(blockchain.getTopBlockIndex() - 1, snapshot.getTopBlockIndex());
+  ASSERT_EQ(generatedBlockHashes.back(), snapshot.getTopBlockHash());
+  ASSERT_TRUE(transactions.empty());
+  ASSERT_EQ(std::vector<Hash>({ getObjectHash(block.baseTransaction) }), missedHashes);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, ReadSnapshotReturnsTransactions) {
+  BlockchainReadSnapshot snapshot(database.createSnapshot(), blockchain.getTopBlockIndex());
+
+  auto& baseTransaction = generator.getBlockchain()[1].baseTransaction;
+  Hash missingHash = randomBlockHash();
+
+  std::vector<BinaryArray> transactions;
+  std::vector<Hash> missedHashes;
+  snapshot.getRawTransactions({ getObjectHash(baseTransaction), missingHash }, transactions, missedHashes);
+
+  ASSERT_EQ(std::vector<BinaryArray>({ toBinaryArray(baseTransaction) }), transactions);
+  ASSERT_EQ(std::vector<Hash>({ missingHash }), missedHashes);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, ReadSnapshotMissesTransactionsOfPrunedBlocks) {
+  Transaction transaction;
+  transaction.version = CURRENT_TRANSACTION_VERSION;
+  transaction.unlockTime = 0;
+  transaction.extra = { 1, 2, 3 };
+  CachedTransaction cachedTransaction(transaction);
+
+  generator.generateEmptyBlocks(1);
+  auto block = generator.getBlockchain().back();
+  block.transactionHashes.push_back(cachedTransaction.getTransactionHash());
+  blockchain.pushBlock(CachedBlock{block}, { cachedTransaction }, TransactionValidatorState(), 0, 0, 0,
+                       { toBinaryArray(block), { cachedTransaction.getTransactionBinaryArray() } });
+
+  std::vector<Hash> hashes { cachedTransaction.getTransactionHash(), getObjectHash(block.baseTransaction) };
+  std::vector<BinaryArray> transactions;
+  std::vector<Hash> missedHashes;
+  BlockchainReadSnapshot(database.createSnapshot(), blockchain.getTopBlockIndex()).getRawTransactions(hashes, transactions, missedHashes);
+  ASSERT_EQ(std::vector<BinaryArray>({ cachedTransaction.getTransactionBinaryArray(), toBinaryArray(block.baseTransaction) }), transactions);
+  ASSERT_TRUE(missedHashes.empty());
+
+  blockchain.pruneBlocks(blockchain.getTopBlockIndex() + 1);
+
+  transactions.clear();
+  BlockchainReadSnapshot snapshot(database.createSnapshot(), blockchain.getTopBlockIndex());
+  ASSERT_NO_THROW(snapshot.getRawTransactions(hashes, transactions, missedHashes));
+  ASSERT_EQ(std::vector<BinaryArray>({ toBinaryArray(block.baseTransaction) }), transactions);
+  ASSERT_EQ(std::vector<Hash>({ cachedTransaction.getTransactionHash() }), missedHashes);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, ReadSnapshotDoesNotSeeSplitBlocks) {
+  auto& baseTransaction = generator.getBlockchain().back().baseTransaction;
+  auto child = blockchain.split(blockchain.getTopBlockIndex());
+
+  BlockchainReadSnapshot snapshot(database.createSnapshot(), blockchain.getTopBlockIndex());
+
+  std::vector<BinaryArray> transactions;
+  std::vector<Hash> missedHashes;
+  snapshot.getRawTransactions({ getObjectHash(baseTransaction) }, transactions, missedHashes);
+
+  ASSERT_EQ(generatedBlockHashes[generatedBlockHashes.size() - 2], snapshot.getTopBlockHash());
+  ASSERT_TRUE(transactions.empty());
+  ASSERT_EQ(std::vector<Hash>({ getObjectHash(baseTransaction) }), missedHashes);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, RawBlocksInStorageAreNotWrittenToDatabase) {
+  DataBaseMock storageDatabase;
+  MainChainStorageStub storage;
+  storage.pushBlock({ toBinaryArray(currency.genesisBlock()), {} });
+
+  DatabaseBlockchainCache cache(currency, storageDatabase, blockchainCacheFactory, logger, 0, &storage);
+  for (auto& block : generator.getBlockchain()) {
+    TransactionValidatorState state;
+    storage.pushBlock({ toBinaryArray(block), {} });
+    cache.pushBlock(CachedBlock{block}, {}, state, 0, 0, 0, { toBinaryArray(block), {} });
+  }
+
+  ASSERT_TRUE(storageDatabase.blocks().empty());
+  ASSERT_EQ(storage.getBlockCount(), cache.getBlockCount());
+  ASSERT_EQ(toBinaryArray(generator.getBlockchain().back()), cache.getBlockByIndex(cache.getTopBlockIndex()).block);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, RawBlocksAreRemovedFromDatabaseWhenKeptInStorage) {
+  MainChainStorageStub storage;
+  for (uint32_t i = 0; i <= blockchain.getTopBlockIndex(); ++i) {
+    storage.pushBlock(blockchain.getBlockByIndex(i));
+  }
+
+  DatabaseBlockchainCache cache(currency, database, blockchainCacheFactory, logger, 0, &storage);
+
+  ASSERT_TRUE(database.blocks().empty());
+  ASSERT_EQ(storage.blocks.back().block, cache.getBlockByIndex(cache.getTopBlockIndex()).block);
+  ASSERT_TRUE(DatabaseBlockchainCache::checkDBSchemeVersion(database, logger, true));
+  ASSERT_FALSE(DatabaseBlockchainCache::checkDBSchemeVersion(database, logger, false));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, TruncateDoesNotNeedRawBlocks) {
+  MainChainStorageStub storage;
+  for (uint32_t i = 0; i <= blockchain.getTopBlockIndex(); ++i) {
+    storage.pushBlock(blockchain.getBlockByIndex(i));
+  }
+
+  DatabaseBlockchainCache cache(currency, database, blockchainCacheFactory, logger, 0, &storage);
+
+  // storage lost its tail, as it may after a crash
+  storage.popBlock();
+  storage.popBlock();
+  cache.truncate(storage.getBlockCount());
+
+  ASSERT_EQ(storage.getBlockCount(), cache.getBlockCount());
+  ASSERT_EQ(generatedBlockHashes[generatedBlockHashes.size() - 3], cache.getTopBlockHash());
+  ASSERT_FALSE(cache.hasBlock(generatedBlockHashes.back()));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, PrunedBlocksAreReadFromDatabase) {
+  MainChainStorageStub storage;
+  for (uint32_t i = 0; i <= blockchain.getTopBlockIndex(); ++i) {
+    storage.pushBlock(blockchain.getBlockByIndex(i));
+  }
+
+  {
+    DatabaseBlockchainCache cache(currency, database, blockchainCacheFactory, logger, 0, &storage);
+    cache.pruneBlocks(3);
+    storage.pruneBlocks(cache.getPrunedBlockCount());
+
+    ASSERT_EQ(3, cache.getPrunedBlockCount());
+    ASSERT_EQ(3, database.blocks().size());
+    ASSERT_EQ(storage.blocks[1].block, cache.getBlockByIndex(1).block);
+    ASSERT_EQ(storage.blocks[3].block, cache.getBlockByIndex(3).block);
+    ASSERT_ANY_THROW(cache.truncate(2));
+  }
+
+  DatabaseBlockchainCache cache(currency, database, blockchainCacheFactory, logger, 0, &storage);
+  ASSERT_EQ(3, cache.getPrunedBlockCount());
+  ASSERT_EQ(storage.blocks[2].block, cache.getBlockByIndex(2).block);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SpentKeyImageFilterAnswersMissingKeyImages) {
+  KeyImage spentKeyImage;
+  reinterpret_cast<Hash&>(spentKeyImage) = randomBlockHash();
+  KeyImage missingKeyImage;
+  reinterpret_cast<Hash&>(missingKeyImage) = randomBlockHash();
+
+  generator.generateEmptyBlocks(1);
+  TransactionValidatorState state;
+  state.spentKeyImages.insert(spentKeyImage);
+  auto& block = generator.getBlockchain().back();
+  blockchain.pushBlock(CachedBlock{block}, {}, state, 0, 0, 0, { toBinaryArray(block), {} });
+
+  ASSERT_TRUE(blockchain.checkIfSpent(spentKeyImage));
+  ASSERT_FALSE(blockchain.checkIfSpent(spentKeyImage, blockchain.getTopBlockIndex() - 1));
+  ASSERT_FALSE(blockchain.checkIfSpent(missingKeyImage));
+
+  const auto& statistics = blockchain.getSpentKeyImageFilterStatistics();
+  ASSERT_EQ(3, statistics.lookups);
+  ASSERT_EQ(1, statistics.filteredOut + statistics.falsePositives);
+
+  DatabaseBlockchainCache reloaded(currency, database, blockchainCacheFactory, logger);
+  ASSERT_TRUE(reloaded.checkIfSpent(spentKeyImage));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, KeyOutputTableReturnsSameOutputsAsDatabase) {
+  const std::string tableFileName = "DatabaseBlockchainCacheTestsKeyOutputs.dat";
+  boost::filesystem::remove(tableFileName);
+
+  {
+    DatabaseBlockchainCache cache(currency, database, blockchainCacheFactory, logger, 0, nullptr, tableFileName);
+    uint32_t topBlockIndex = cache.getTopBlockIndex();
+
+    for (const auto& amountCount : countOutputsForAmount()) {
+      auto amount = amountCount.first;
+      ASSERT_EQ(blockchain.getKeyOutputsCountForAmount(amount, topBlockIndex), cache.getKeyOutputsCountForAmount(amount, topBlockIndex));
+      ASSERT_EQ(blockchain.getKeyOutputsCountForAmount(amount, 2), cache.getKeyOutputsCountForAmount(amount, 2));
+
+      std::vector<uint32_t> globalIndexes(amountCount.second);
+      std::iota(globalIndexes.begin(), globalIndexes.end(), 0);
+      Common::ArrayView<uint32_t> indexesView(globalIndexes.data(), globalIndexes.size());
+
+      std::vector<PublicKey> expectedKeys;
+      std::vector<PublicKey> keys;
+      ASSERT_EQ(blockchain.extractKeyOutputKeys(amount, 0, indexesView, expectedKeys), cache.extractKeyOutputKeys(amount, 0, indexesView, keys));
+      ASSERT_EQ(expectedKeys, keys);
+
+      std::vector<PackedOutIndex> expectedIndexes;
+      std::vector<PackedOutIndex> outIndexes;
+      ASSERT_EQ(ExtractOutputKeysResult::SUCCESS, blockchain.extractKeyOtputIndexes(amount, indexesView, expectedIndexes));
+      ASSERT_EQ(ExtractOutputKeysResult::SUCCESS, cache.extractKeyOtputIndexes(amount, indexesView, outIndexes));
+      ASSERT_EQ(expectedIndexes.size(), outIndexes.size());
+      for (size_t i = 0; i < outIndexes.size(); ++i) {
+        ASSERT_EQ(expectedIndexes[i].packedValue, outIndexes[i].packedValue);
+      }
+
+      auto randomOuts = cache.getRandomOutsByAmount(amount, amountCount.second, topBlockIndex);
+      ASSERT_EQ(blockchain.getRandomOutsByAmount(amount, amountCount.second, topBlockIndex).size(), randomOuts.size());
+    }
+
+    cache.truncate(topBlockIndex - 1);
+  }
+
+  DatabaseBlockchainCache reloaded(currency, database, blockchainCacheFactory, logger, 0, nullptr, tableFileName);
+  DatabaseBlockchainCache withoutTable(currency, database, blockchainCacheFactory, logger);
+  ASSERT_EQ(withoutTable.getTopBlockIndex(), reloaded.getTopBlockIndex());
+  for (const auto& amountCount : countOutputsForAmount()) {
+    ASSERT_EQ(withoutTable.getKeyOutputsCountForAmount(amountCount.first, withoutTable.getTopBlockIndex() + 1),
+      reloaded.getKeyOutputsCountForAmount(amountCount.first, reloaded.getTopBlockIndex() + 1));
+  }
+
+  boost::filesystem::remove(tableFileName);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, PrefetchedKeyInputsAreCheckedWithoutDatabaseReads) {
+  KeyImage spentKeyImage;
+  reinterpret_cast<Hash&>(spentKeyImage) = randomBlockHash();
+
+  generator.generateEmptyBlocks(1);
+  TransactionValidatorState state;
+  state.spentKeyImages.insert(spentKeyImage);
+  auto& block = generator.getBlockchain().back();
+  blockchain.pushBlock(CachedBlock{block}, {}, state, 0, 0, 0, { toBinaryArray(block), {} });
+
+  auto amount = countOutputsForAmount().begin()->first;
+  KeyInput spendingInput { amount, { 0 }, spentKeyImage };
+  KeyInput input { amount, { 0, 1 }, KeyImage() };
+  blockchain.prefetchKeyInputs({ &spendingInput, &input });
+
+  size_t readCount = database.readCount;
+  ASSERT_TRUE(blockchain.checkIfSpent(spentKeyImage));
+  ASSERT_FALSE(blockchain.checkIfSpent(spentKeyImage, blockchain.getTopBlockIndex() - 1));
+
+  std::vector<PublicKey> keys;
+  std::vector<uint32_t> globalIndexes { 0, 1 };
+  auto result = blockchain.extractKeyOutputKeys(amount, blockchain.getTopBlockIndex(), { globalIndexes.data(), globalIndexes.size() }, keys);
+  ASSERT_EQ(readCount, database.readCount);
+
+  DatabaseBlockchainCache reloaded(currency, database, blockchainCacheFactory, logger);
+  std::vector<PublicKey> expectedKeys;
+  ASSERT_EQ(reloaded.extractKeyOutputKeys(amount, reloaded.getTopBlockIndex(), { globalIndexes.data(), globalIndexes.size() }, expectedKeys), result);
+  ASSERT_EQ(expectedKeys, keys);
+
+  generator.generateEmptyBlocks(1);
+  auto& nextBlock = generator.getBlockchain().back();
+  blockchain.pushBlock(CachedBlock{nextBlock}, {}, TransactionValidatorState(), 0, 0, 0, { toBinaryArray(nextBlock), {} });
+
+  readCount = database.readCount;
+  ASSERT_TRUE(blockchain.checkIfSpent(spentKeyImage));
+  ASSERT_LT(readCount, database.readCount);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, ObjectCacheAvoidsRepeatedDatabaseReads) {
+  DatabaseBlockchainCache cached(currency, database, blockchainCacheFactory, logger, 0, nullptr, "", 1024 * 1024);
+  auto transactionHash = CachedTransaction(generator.getBlockchain().back().baseTransaction).getTransactionHash();
+  auto blockIndex = cached.getBlockIndexContainingTx(transactionHash);
+  auto coins = cached.getAlreadyGeneratedCoins(blockIndex);
+
+  size_t readCount = database.readCount;
+  ASSERT_EQ(blockIndex, cached.getBlockIndexContainingTx(transactionHash));
+  ASSERT_TRUE(cached.hasTransaction(transactionHash));
+  ASSERT_EQ(coins, cached.getAlreadyGeneratedCoins(blockIndex));
+  ASSERT_EQ(readCount, database.readCount);
+
+  auto statistics = cached.getObjectCacheStatistics();
+  ASSERT_EQ(2, statistics.transactions.hits);
+  ASSERT_EQ(1, statistics.transactions.misses);
+  ASSERT_LT(0, statistics.blockInfos.hits);
+
+  cached.truncate(blockIndex);
+  ASSERT_FALSE(cached.hasTransaction(transactionHash));
+  ASSERT_LT(readCount, database.readCount);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SplitLeavesBlocksInDatabaseAndHidesTheirTimestamps) {
+  const uint64_t timestamp = 1000000;
+  DataBaseMock splitDatabase;
+  DatabaseBlockchainCache cache(currency, splitDatabase, blockchainCacheFactory, logger);
+  std::vector<Hash> blockHashes;
+  // genesis block is pushed by the constructor
+  for (auto it = generator.getBlockchain().begin() + 1; it != generator.getBlockchain().end(); ++it) {
+    auto block = *it;
+    block.timestamp = timestamp;
+    TransactionValidatorState state;
+    auto cachedBlock = CachedBlock{block};
+    blockHashes.push_back(cachedBlock.getBlockHash());
+    cache.pushBlock(cachedBlock, {}, state, 1, 0, 1, { toBinaryArray(block), {} });
+  }
+
+  auto databaseState = splitDatabase.baseState;
+  uint32_t splitIndex = static_cast<uint32_t>(blockHashes.size() - 2);
+  auto child = cache.split(splitIndex);
+
+  ASSERT_EQ(databaseState, splitDatabase.baseState);
+  ASSERT_EQ(splitIndex - 1, cache.getTopBlockIndex());
+  ASSERT_EQ(blockHashes[splitIndex - 2], cache.getTopBlockHash());
+  ASSERT_FALSE(cache.hasBlock(blockHashes.back()));
+  ASSERT_EQ(std::vector<Hash>(blockHashes.begin(), blockHashes.begin() + splitIndex - 1), cache.getBlockHashesByTimestamps(timestamp, 1));
+
+  ASSERT_EQ(splitIndex, child->getStartBlockIndex());
+  ASSERT_EQ(3, child->getBlockCount());
+  ASSERT_EQ(blockHashes.back(), child->getTopBlockHash());
+  ASSERT_TRUE(child->hasBlock(blockHashes.back()));
+  ASSERT_FALSE(child->hasBlock(blockHashes.front()));
+  ASSERT_EQ(blockHashes, child->getBlockHashesByTimestamps(timestamp, 1));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SplitBlocksArePushedBackWithoutWritesAndDeletedOnSave) {
+  DataBaseMock splitDatabase;
+  DatabaseBlockchainCache cache(currency, splitDatabase, blockchainCacheFactory, logger);
+  std::vector<BlockTemplate> blocks(generator.getBlockchain().begin() + 1, generator.getBlockchain().end());
+  for (auto& block : blocks) {
+    cache.pushBlock(CachedBlock{block}, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(block), {} });
+  }
+
+  auto databaseState = splitDatabase.baseState;
+  uint32_t splitIndex = static_cast<uint32_t>(blocks.size() - 2);
+  auto child = cache.split(splitIndex);
+
+  auto& mergedBlock = blocks[splitIndex - 1];
+  cache.pushBlock(CachedBlock{mergedBlock}, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(mergedBlock), {} });
+  ASSERT_EQ(databaseState, splitDatabase.baseState);
+  ASSERT_EQ(splitIndex, cache.getTopBlockIndex());
+  ASSERT_TRUE(cache.hasBlock(CachedBlock{mergedBlock}.getBlockHash()));
+
+  cache.save();
+  ASSERT_NE(databaseState, splitDatabase.baseState);
+  ASSERT_EQ(splitIndex, cache.getTopBlockIndex());
+
+  DatabaseBlockchainCache reloaded(currency, splitDatabase, blockchainCacheFactory, logger);
+  ASSERT_EQ(splitIndex, reloaded.getTopBlockIndex());
+  ASSERT_FALSE(reloaded.hasBlock(CachedBlock{blocks.back()}.getBlockHash()));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SplitSegmentPushReplacesBlocksAboveItsTop) {
+  DataBaseMock splitDatabase;
+  DatabaseBlockchainCache cache(currency, splitDatabase, blockchainCacheFactory, logger);
+  std::vector<BlockTemplate> blocks(generator.getBlockchain().begin() + 1, generator.getBlockchain().end());
+  for (auto& block : blocks) {
+    cache.pushBlock(CachedBlock{block}, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(block), {} });
+  }
+
+  uint32_t splitIndex = static_cast<uint32_t>(blocks.size() - 2);
+  auto child = cache.split(splitIndex);
+  auto grandChild = child->split(splitIndex + 1);
+  ASSERT_EQ(splitIndex, child->getTopBlockIndex());
+  ASSERT_EQ(2, grandChild->getBlockCount());
+
+  child->deleteChild(grandChild.get());
+
+  auto block = blocks[splitIndex];
+  block.timestamp += 1;
+  auto cachedBlock = CachedBlock{block};
+  child->pushBlock(cachedBlock, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(block), {} });
+
+  ASSERT_EQ(splitIndex + 1, child->getTopBlockIndex());
+  ASSERT_EQ(cachedBlock.getBlockHash(), child->getTopBlockHash());
+  ASSERT_TRUE(child->hasBlock(cachedBlock.getBlockHash()));
+  ASSERT_FALSE(child->hasBlock(CachedBlock{blocks.back()}.getBlockHash()));
+  ASSERT_EQ(toBinaryArray(block), child->getBlockByIndex(splitIndex + 1).block);
+  ASSERT_EQ(splitIndex - 1, cache.getTopBlockIndex());
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SplitBlocksReplacedInStorageLoseTheirPaymentIds) {
+  DataBaseMock storageDatabase;
+  MainChainStorageStub storage;
+  storage.pushBlock({ toBinaryArray(currency.genesisBlock()), {} });
+  DatabaseBlockchainCache cache(currency, storageDatabase, blockchainCacheFactory, logger, 0, &storage);
+
+  Hash paymentId = randomBlockHash();
+  BinaryArray extraNonce;
+  setPaymentIdToTransactionExtraNonce(extraNonce, paymentId);
+
+  std::vector<BlockTemplate> blocks(generator.getBlockchain().begin() + 1, generator.getBlockchain().end());
+  std::vector<Hash> paymentTransactions;
+  Hash previousBlockHash = cache.getTopBlockHash();
+  for (auto& block : blocks) {
+    block.previousBlockHash = previousBlockHash;
+    ASSERT_TRUE(addExtraNonceToTransactionExtra(block.baseTransaction.extra, extraNonce));
+    paymentTransactions.push_back(getObjectHash(block.baseTransaction));
+    previousBlockHash = CachedBlock{block}.getBlockHash();
+
+    storage.pushBlock({ toBinaryArray(block), {} });
+    cache.pushBlock(CachedBlock{block}, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(block), {} });
+  }
+
+  // data base returns them in no particular order
+  auto getPaymentTransactions = [&cache, &paymentId] () {
+    auto hashes = cache.getTransactionHashesByPaymentId(paymentId);
+    return std::unordered_set<Hash>(hashes.begin(), hashes.end());
+  };
+
+  ASSERT_EQ(std::unordered_set<Hash>(paymentTransactions.begin(), paymentTransactions.end()), getPaymentTransactions());
+
+  uint32_t splitIndex = static_cast<uint32_t>(blocks.size() - 1);
+  auto child = cache.split(splitIndex);
+
+  // another chain becomes the main one, as Core::switchMainChainStorage does
+  auto alternativeBlock = generator.getBlockchain()[splitIndex];
+  alternativeBlock.previousBlockHash = cache.getTopBlockHash();
+  storage.popBlock();
+  storage.popBlock();
+  storage.pushBlock({ toBinaryArray(alternativeBlock), {} });
+
+  cache.pushBlock(CachedBlock{alternativeBlock}, {}, TransactionValidatorState(), 1, 0, 1, { toBinaryArray(alternativeBlock), {} });
+
+  ASSERT_EQ(splitIndex, cache.getTopBlockIndex());
+  ASSERT_EQ(std::unordered_set<Hash>(paymentTransactions.begin(), paymentTransactions.begin() + splitIndex - 1), getPaymentTransactions());
+}
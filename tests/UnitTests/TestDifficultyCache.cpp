@@ -0,0 +1,126 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DifficultyCache.h"
+#include "Logging/ConsoleLogger.h"
+
+using namespace CryptoNote;
+
+namespace {
+const size_t TEST_DIFFICULTY_WINDOW = 30;
+const size_t TEST_DIFFICULTY_CUT = 5;
+const size_t TEST_DIFFICULTY_LAG = 3;
+
+class DifficultyCacheTest : public ::testing::Test {
+public:
+  DifficultyCacheTest() :
+    currency(CurrencyBuilder(logger).
+      difficultyWindow(TEST_DIFFICULTY_WINDOW).
+      difficultyCut(TEST_DIFFICULTY_CUT).
+      difficultyLag(TEST_DIFFICULTY_LAG).
+      currency()),
+    generator(42) {
+  }
+
+  // appends a block with a timestamp jittered around the difficulty target
+  void pushBlock() {
+    uint64_t lastTimestamp = timestamps.empty() ? 1000000 : timestamps.back();
+    std::uniform_int_distribution<int64_t> timeShift(-static_cast<int64_t>(currency.difficultyTarget()), 3 * currency.difficultyTarget());
+    std::uniform_int_distribution<Difficulty> difficulty(1, 1000);
+
+    timestamps.push_back(lastTimestamp + timeShift(generator));
+    cumulativeDifficulties.push_back((cumulativeDifficulties.empty() ? 0 : cumulativeDifficulties.back()) + difficulty(generator));
+  }
+
+  Difficulty expectedDifficulty() const {
+    size_t count = std::min(timestamps.size(), currency.difficultyBlocksCount());
+    return currency.nextDifficulty(std::vector<uint64_t>(timestamps.end() - count, timestamps.end()),
+      std::vector<Difficulty>(cumulativeDifficulties.end() - count, cumulativeDifficulties.end()));
+  }
+
+protected:
+  Logging::ConsoleLogger logger;
+  Currency currency;
+  std::mt19937 generator;
+  std::vector<uint64_t> timestamps;
+  std::vector<Difficulty> cumulativeDifficulties;
+};
+}
+
+TEST_F(DifficultyCacheTest, isNotLoadedInitially) {
+  DifficultyCache cache(currency);
+  ASSERT_FALSE(cache.isLoaded(0));
+}
+
+TEST_F(DifficultyCacheTest, emptyWindowGivesMinimalDifficulty) {
+  DifficultyCache cache(currency);
+  cache.load(0, {}, {});
+  ASSERT_TRUE(cache.isLoaded(0));
+  ASSERT_EQ(1, cache.getNextDifficulty());
+}
+
+TEST_F(DifficultyCacheTest, pushedBlocksGiveSameDifficultyAsFullRecalculation) {
+  DifficultyCache cache(currency);
+  cache.load(0, {}, {});
+
+  for (uint32_t blockIndex = 1; blockIndex < 200; ++blockIndex) {
+    pushBlock();
+    cache.push(blockIndex, timestamps.back(), cumulativeDifficulties.back());
+
+    ASSERT_TRUE(cache.isLoaded(blockIndex));
+    ASSERT_EQ(expectedDifficulty(), cache.getNextDifficulty());
+  }
+}
+
+TEST_F(DifficultyCacheTest, loadedWindowGivesSameDifficultyAsFullRecalculation) {
+  for (size_t i = 0; i < 100; ++i) {
+    pushBlock();
+  }
+
+  size_t count = currency.difficultyBlocksCount();
+  DifficultyCache cache(currency);
+  cache.load(100, std::vector<uint64_t>(timestamps.end() - count, timestamps.end()),
+    std::vector<Difficulty>(cumulativeDifficulties.end() - count, cumulativeDifficulties.end()));
+
+  ASSERT_EQ(expectedDifficulty(), cache.getNextDifficulty());
+
+  pushBlock();
+  cache.push(101, timestamps.back(), cumulativeDifficulties.back());
+  ASSERT_EQ(expectedDifficulty(), cache.getNextDifficulty());
+}
+
+TEST_F(DifficultyCacheTest, pushOfNonSequentialBlockResetsCache) {
+  DifficultyCache cache(currency);
+  cache.load(10, {}, {});
+  cache.push(12, 1000, 1);
+
+  ASSERT_FALSE(cache.isLoaded(10));
+  ASSERT_FALSE(cache.isLoaded(12));
+}
+
+TEST_F(DifficultyCacheTest, resetUnloadsCache) {
+  DifficultyCache cache(currency);
+  cache.load(10, {}, {});
+  cache.reset();
+
+  ASSERT_FALSE(cache.isLoaded(10));
+}
@@ -771,6 +771,37 @@ TEST_F(FileMappedVectorTest, insertCanIncreaseCapacity) {
   ASSERT_LT(initialCapacity, vec.capacity());
 }
 
+TEST_F(FileMappedVectorTest, insertToBackKeepsCapacityIfElementsFit) {
+  createTestFile(TEST_FILE_NAME);
+
+  {
+    FileMappedVector<char> vec(TEST_FILE_NAME);
+    std::string str = "xyz";
+    auto it = vec.insert(vec.end(), str.begin(), str.end());
+    ASSERT_EQ(vec.cbegin() + TEST_VECTOR_SIZE, it);
+    ASSERT_EQ(TEST_VECTOR_CAPACITY, vec.capacity());
+  }
+
+  FileMappedVector<char> vec(TEST_FILE_NAME, FileMappedVectorOpenMode::OPEN);
+  ASSERT_EQ(TEST_VECTOR_SIZE + 3, vec.size());
+  ASSERT_TRUE(std::equal(vec.begin(), vec.end() - 3, TEST_VECTOR_DATA.begin()));
+  ASSERT_EQ("xyz", std::string(vec.end() - 3, vec.end()));
+}
+
+TEST_F(FileMappedVectorTest, eraseFromBackKeepsCapacity) {
+  createTestFile(TEST_FILE_NAME);
+
+  {
+    FileMappedVector<char> vec(TEST_FILE_NAME);
+    vec.erase(vec.begin() + 2, vec.end());
+    ASSERT_EQ(TEST_VECTOR_CAPACITY, vec.capacity());
+  }
+
+  FileMappedVector<char> vec(TEST_FILE_NAME, FileMappedVectorOpenMode::OPEN);
+  ASSERT_EQ(2, vec.size());
+  ASSERT_TRUE(std::equal(vec.begin(), vec.end(), TEST_VECTOR_DATA.begin()));
+}
+
 TEST_F(FileMappedVectorTest, insertReturnsIteratorPointsToFirstInsertedElement) {
   createTestFile(TEST_FILE_NAME);
   FileMappedVector<char> vec(TEST_FILE_NAME);
@@ -840,6 +871,26 @@ TEST_F(FileMappedVectorTest, pushBackCanIncreaseCapacity) {
   ASSERT_LT(initialCapacity, vec.capacity());
 }
 
+TEST_F(FileMappedVectorTest, insertWithGrowthStepExtendsFileInPlace) {
+  createTestFileWithPrefixAndSuffix(TEST_FILE_NAME);
+
+  {
+    FileMappedVector<char> vec(TEST_FILE_NAME, FileMappedVectorOpenMode::OPEN, TEST_FILE_PREFIX.size());
+    vec.setGrowthStep(100);
+    vec.insert(vec.cend(), TEST_VECTOR_DATA.begin(), TEST_VECTOR_DATA.end());
+
+    ASSERT_FALSE(boost::filesystem::exists(TEST_FILE_NAME_BAK));
+    ASSERT_EQ(TEST_VECTOR_CAPACITY + 100, vec.capacity());
+    ASSERT_EQ(TEST_FILE_SUFFIX, std::string(vec.suffix(), vec.suffix() + vec.suffixSize()));
+  }
+
+  FileMappedVector<char> vec(TEST_FILE_NAME, FileMappedVectorOpenMode::OPEN, TEST_FILE_PREFIX.size());
+  ASSERT_EQ(TEST_VECTOR_CAPACITY + 100, vec.capacity());
+  ASSERT_EQ(TEST_VECTOR_DATA + TEST_VECTOR_DATA, std::string(vec.data(), vec.size()));
+  ASSERT_EQ(TEST_FILE_PREFIX, std::string(vec.prefix(), vec.prefix() + vec.prefixSize()));
+  ASSERT_EQ(TEST_FILE_SUFFIX, std::string(vec.suffix(), vec.suffix() + vec.suffixSize()));
+}
+
 TEST_F(FileMappedVectorTest, pushBackFlushesDataToDiskImmediately) {
   char c = Crypto::rand<char>();
 
@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "CryptoNoteCore/KeyImageFilter.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+std::vector<Crypto::KeyImage> makeKeyImages(size_t count, uint32_t seed) {
+  std::mt19937 generator(seed);
+  std::vector<Crypto::KeyImage> keyImages(count);
+  for (auto& keyImage : keyImages) {
+    for (auto& byte : keyImage.data) {
+      byte = static_cast<uint8_t>(generator());
+    }
+  }
+
+  return keyImages;
+}
+
+}
+
+TEST(KeyImageFilterTest, hasNoFalseNegatives) {
+  KeyImageFilter filter(1000);
+  auto keyImages = makeKeyImages(1000, 1);
+  for (const auto& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  ASSERT_EQ(1000, filter.getCount());
+  for (const auto& keyImage : keyImages) {
+    ASSERT_TRUE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(KeyImageFilterTest, falsePositiveRateIsLowAtCapacity) {
+  KeyImageFilter filter(10000);
+  for (const auto& keyImage : makeKeyImages(10000, 2)) {
+    filter.add(keyImage);
+  }
+
+  size_t falsePositives = 0;
+  for (const auto& keyImage : makeKeyImages(100000, 3)) {
+    if (filter.mayContain(keyImage)) {
+      ++falsePositives;
+    }
+  }
+
+  ASSERT_LT(falsePositives, 1000);
+}
+
+TEST(KeyImageFilterTest, resetClearsFilter) {
+  KeyImageFilter filter(100);
+  auto keyImages = makeKeyImages(100, 4);
+  for (const auto& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  filter.reset(200);
+
+  ASSERT_EQ(0, filter.getCount());
+  ASSERT_EQ(200, filter.getCapacity());
+  for (const auto& keyImage : keyImages) {
+    ASSERT_FALSE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(KeyImageFilterStatisticsTest, falsePositiveRateCountsAbsentKeyImagesOnly) {
+  KeyImageFilterStatistics statistics;
+  ASSERT_EQ(0, statistics.getFalsePositiveRate());
+
+  statistics.lookups = 10;
+  statistics.filteredOut = 3;
+  statistics.falsePositives = 1;
+  ASSERT_DOUBLE_EQ(0.25, statistics.getFalsePositiveRate());
+}
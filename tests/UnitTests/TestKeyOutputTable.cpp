@@ -0,0 +1,162 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/KeyOutputTable.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string TABLE_FILE_NAME = "KeyOutputTableTest.dat";
+
+KeyOutputTableEntry makeEntry(uint64_t amount, uint32_t blockIndex, uint16_t outputIndex) {
+  KeyOutputTableEntry entry;
+  entry.amount = amount;
+  entry.publicKey = Crypto::PublicKey();
+  entry.publicKey.data[0] = static_cast<uint8_t>(blockIndex);
+  entry.publicKey.data[1] = static_cast<uint8_t>(outputIndex);
+  entry.location.blockIndex = blockIndex;
+  entry.location.transactionIndex = 0;
+  entry.location.outputIndex = outputIndex;
+  entry.unlockTime = blockIndex + 10;
+  return entry;
+}
+
+// block i has outputs of amounts 1 and 2, and an output of amount 3 if i is even
+std::vector<KeyOutputTableEntry> makeBlock(uint32_t blockIndex) {
+  std::vector<KeyOutputTableEntry> entries { makeEntry(1, blockIndex, 0), makeEntry(2, blockIndex, 1) };
+  if (blockIndex % 2 == 0) {
+    entries.push_back(makeEntry(3, blockIndex, 2));
+  }
+
+  return entries;
+}
+
+class KeyOutputTableTest : public ::testing::Test {
+protected:
+  virtual void SetUp() override {
+    boost::filesystem::remove(TABLE_FILE_NAME);
+  }
+
+  virtual void TearDown() override {
+    boost::filesystem::remove(TABLE_FILE_NAME);
+  }
+};
+
+}
+
+TEST_F(KeyOutputTableTest, findsOutputsByGlobalIndex) {
+  KeyOutputTable table(TABLE_FILE_NAME);
+  for (uint32_t i = 0; i < 5; ++i) {
+    table.pushBlock(i, makeBlock(i));
+  }
+
+  ASSERT_EQ(5, table.getBlockCount());
+  ASSERT_EQ(5, table.getOutputCount(1));
+  ASSERT_EQ(3, table.getOutputCount(3));
+  ASSERT_EQ(0, table.getOutputCount(4));
+
+  const KeyOutputTableEntry* entry = table.find(3, 2);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(4, entry->location.blockIndex);
+  ASSERT_EQ(2, entry->location.outputIndex);
+  ASSERT_EQ(14, entry->unlockTime);
+  ASSERT_EQ(makeEntry(3, 4, 2).publicKey, entry->publicKey);
+
+  ASSERT_EQ(nullptr, table.find(3, 3));
+  ASSERT_EQ(nullptr, table.find(4, 0));
+}
+
+TEST_F(KeyOutputTableTest, truncateRemovesBlockOutputs) {
+  KeyOutputTable table(TABLE_FILE_NAME);
+  for (uint32_t i = 0; i < 5; ++i) {
+    table.pushBlock(i, makeBlock(i));
+  }
+
+  table.truncate(3);
+  ASSERT_EQ(3, table.getBlockCount());
+  ASSERT_EQ(3, table.getOutputCount(2));
+  ASSERT_EQ(2, table.getOutputCount(3));
+
+  table.pushBlock(3, { makeEntry(3, 3, 0) });
+  ASSERT_EQ(3, table.getOutputCount(3));
+  ASSERT_EQ(3, table.find(3, 2)->location.blockIndex);
+}
+
+TEST_F(KeyOutputTableTest, keepsFlushedBlocksAfterReopening) {
+  {
+    KeyOutputTable table(TABLE_FILE_NAME);
+    for (uint32_t i = 0; i < 3; ++i) {
+      table.pushBlock(i, makeBlock(i));
+    }
+  }
+
+  KeyOutputTable table(TABLE_FILE_NAME);
+  ASSERT_EQ(3, table.getBlockCount());
+  ASSERT_EQ(3, table.getOutputCount(1));
+  ASSERT_EQ(2, table.getOutputCount(3));
+  ASSERT_EQ(2, table.find(3, 1)->location.blockIndex);
+}
+
+TEST_F(KeyOutputTableTest, truncateBelowFlushedBlocksIsKeptAfterReopening) {
+  {
+    KeyOutputTable table(TABLE_FILE_NAME);
+    for (uint32_t i = 0; i < 4; ++i) {
+      table.pushBlock(i, makeBlock(i));
+    }
+
+    table.flush();
+    table.truncate(1);
+    ASSERT_EQ(1, table.getBlockCount());
+  }
+
+  KeyOutputTable table(TABLE_FILE_NAME);
+  ASSERT_EQ(1, table.getBlockCount());
+  ASSERT_EQ(1, table.getOutputCount(2));
+}
+
+TEST_F(KeyOutputTableTest, dropsRowsWrittenAfterFlushWhenReopening) {
+  {
+    KeyOutputTable table(TABLE_FILE_NAME);
+    for (uint32_t i = 0; i < 2; ++i) {
+      table.pushBlock(i, makeBlock(i));
+    }
+  }
+
+  // a row lost on power failure may come back zero filled, so it looks like an output of block 0
+  {
+    // the table header holds flushed block and row counts
+    Common::FileMappedVector<KeyOutputTableEntry> entries(TABLE_FILE_NAME, Common::FileMappedVectorOpenMode::OPEN, 2 * sizeof(uint32_t));
+    KeyOutputTableEntry zeroEntry;
+    std::memset(&zeroEntry, 0, sizeof(zeroEntry));
+    entries.push_back(zeroEntry);
+  }
+
+  KeyOutputTable table(TABLE_FILE_NAME);
+  ASSERT_EQ(2, table.getBlockCount());
+  ASSERT_EQ(0, table.getOutputCount(0));
+
+  table.pushBlock(2, makeBlock(2));
+  ASSERT_EQ(3, table.getOutputCount(1));
+  ASSERT_EQ(2, table.find(1, 2)->location.blockIndex);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "CryptoNoteCore/LruCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// budget that fits exactly count values without dynamic size
+size_t budgetFor(size_t count) {
+  LruCache<uint32_t, uint64_t> probe(1024);
+  probe.insert(0, 0);
+  return probe.getByteSize() * count;
+}
+
+}
+
+TEST(LruCacheTest, evictsLeastRecentlyUsedValues) {
+  LruCache<uint32_t, uint64_t> cache(budgetFor(3));
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(3, 30);
+  ASSERT_NE(nullptr, cache.find(1));
+
+  cache.insert(4, 40);
+  ASSERT_EQ(3, cache.getCount());
+  ASSERT_EQ(nullptr, cache.find(2));
+  ASSERT_EQ(10, *cache.find(1));
+  ASSERT_EQ(30, *cache.find(3));
+  ASSERT_EQ(40, *cache.find(4));
+}
+
+TEST(LruCacheTest, accountsDynamicSizeOfValues) {
+  LruCache<uint32_t, std::string> cache(1024, [](const std::string& value) { return value.size(); });
+  cache.insert(1, std::string(600, 'a'));
+  cache.insert(2, std::string(600, 'b'));
+  ASSERT_EQ(1, cache.getCount());
+  ASSERT_EQ(nullptr, cache.find(1));
+  ASSERT_LE(cache.getByteSize(), 1024);
+
+  cache.insert(3, std::string(2048, 'c'));
+  ASSERT_EQ(nullptr, cache.find(3));
+  ASSERT_NE(nullptr, cache.find(2));
+}
+
+TEST(LruCacheTest, countsHitsAndMisses) {
+  LruCache<uint32_t, uint64_t> cache(budgetFor(2));
+  cache.insert(1, 10);
+  cache.find(1);
+  cache.find(1);
+  cache.find(2);
+
+  ASSERT_EQ(2, cache.getStatistics().hits);
+  ASSERT_EQ(1, cache.getStatistics().misses);
+  ASSERT_DOUBLE_EQ(2.0 / 3, cache.getStatistics().getHitRate());
+
+  cache.clear();
+  ASSERT_EQ(0, cache.getCount());
+  ASSERT_EQ(0, cache.getByteSize());
+  ASSERT_EQ(nullptr, cache.find(1));
+}
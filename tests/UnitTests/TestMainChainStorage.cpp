@@ -0,0 +1,231 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/SwappedVector.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string BLOCKS_FILE_NAME = "MainChainStorageTestBlocks.dat";
+const std::string INDEXES_FILE_NAME = "MainChainStorageTestIndexes.dat";
+const std::string SWAPPED_BLOCKS_FILE_NAME = "MainChainStorageTestBlocks.bin";
+const std::string SWAPPED_INDEXES_FILE_NAME = "MainChainStorageTestIndexes.bin";
+
+RawBlock makeBlock(uint8_t value) {
+  RawBlock block;
+  block.block.assign(10 + value, value);
+  block.transactions.push_back(BinaryArray(value, value));
+  return block;
+}
+
+class MainChainStorageTest : public ::testing::Test {
+protected:
+  virtual void SetUp() override {
+    clean();
+  }
+
+  virtual void TearDown() override {
+    clean();
+  }
+
+  void clean() {
+    for (auto& fileName : { BLOCKS_FILE_NAME, INDEXES_FILE_NAME, SWAPPED_BLOCKS_FILE_NAME, SWAPPED_INDEXES_FILE_NAME,
+                            BLOCKS_FILE_NAME + ".import", INDEXES_FILE_NAME + ".import" }) {
+      boost::filesystem::remove(fileName);
+    }
+  }
+};
+
+}
+
+TEST_F(MainChainStorageTest, returnsPushedBlocks) {
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  storage.pushBlock(makeBlock(1));
+  storage.pushBlock(makeBlock(2));
+
+  ASSERT_EQ(2, storage.getBlockCount());
+  ASSERT_EQ(makeBlock(1).block, storage.getBlockByIndex(0).block);
+  ASSERT_EQ(makeBlock(2).block, storage.getBlockByIndex(1).block);
+  ASSERT_EQ(makeBlock(2).transactions, storage.getBlockByIndex(1).transactions);
+  ASSERT_THROW(storage.getBlockByIndex(2), std::out_of_range);
+}
+
+TEST_F(MainChainStorageTest, popBlockRemovesLastBlock) {
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  storage.pushBlock(makeBlock(1));
+  storage.pushBlock(makeBlock(2));
+  storage.popBlock();
+  storage.pushBlock(makeBlock(3));
+
+  ASSERT_EQ(2, storage.getBlockCount());
+  ASSERT_EQ(makeBlock(1).block, storage.getBlockByIndex(0).block);
+  ASSERT_EQ(makeBlock(3).block, storage.getBlockByIndex(1).block);
+}
+
+TEST_F(MainChainStorageTest, keepsBlocksAfterReopening) {
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    for (uint8_t i = 0; i < 100; ++i) {
+      storage.pushBlock(makeBlock(i));
+    }
+
+    storage.popBlock();
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  ASSERT_EQ(99, storage.getBlockCount());
+  for (uint8_t i = 0; i < 99; ++i) {
+    ASSERT_EQ(makeBlock(i).block, storage.getBlockByIndex(i).block);
+  }
+}
+
+TEST_F(MainChainStorageTest, dropsBlocksDataNotCoveredByIndex) {
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    storage.pushBlock(makeBlock(1));
+    storage.pushBlock(makeBlock(2));
+  }
+
+  {
+    // interrupted popBlock: index entry is removed, block data isn't
+    Common::FileMappedVector<uint64_t> indexes(INDEXES_FILE_NAME);
+    indexes.pop_back();
+  }
+
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    ASSERT_EQ(1, storage.getBlockCount());
+    storage.pushBlock(makeBlock(3));
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  ASSERT_EQ(2, storage.getBlockCount());
+  ASSERT_EQ(makeBlock(3).block, storage.getBlockByIndex(1).block);
+}
+
+TEST_F(MainChainStorageTest, importsSwappedStorage) {
+  {
+    SwappedVector<RawBlock> swappedStorage;
+    ASSERT_TRUE(swappedStorage.open(SWAPPED_BLOCKS_FILE_NAME, SWAPPED_INDEXES_FILE_NAME, 10));
+    swappedStorage.push_back(makeBlock(1));
+    swappedStorage.push_back(makeBlock(2));
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME, SWAPPED_BLOCKS_FILE_NAME, SWAPPED_INDEXES_FILE_NAME);
+  ASSERT_EQ(2, storage.getBlockCount());
+  ASSERT_EQ(makeBlock(2).block, storage.getBlockByIndex(1).block);
+  ASSERT_FALSE(boost::filesystem::exists(SWAPPED_BLOCKS_FILE_NAME));
+  ASSERT_FALSE(boost::filesystem::exists(SWAPPED_INDEXES_FILE_NAME));
+}
+
+TEST_F(MainChainStorageTest, restartsInterruptedImport) {
+  {
+    SwappedVector<RawBlock> swappedStorage;
+    ASSERT_TRUE(swappedStorage.open(SWAPPED_BLOCKS_FILE_NAME, SWAPPED_INDEXES_FILE_NAME, 10));
+    swappedStorage.push_back(makeBlock(1));
+    swappedStorage.push_back(makeBlock(2));
+  }
+
+  // storage files written partially and files of an unfinished import
+  for (auto& suffix : { std::string(), std::string(".import") }) {
+    MainChainStorage storage(BLOCKS_FILE_NAME + suffix, INDEXES_FILE_NAME + suffix);
+    storage.pushBlock(makeBlock(3));
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME, SWAPPED_BLOCKS_FILE_NAME, SWAPPED_INDEXES_FILE_NAME);
+  ASSERT_EQ(2, storage.getBlockCount());
+  ASSERT_EQ(makeBlock(1).block, storage.getBlockByIndex(0).block);
+  ASSERT_EQ(makeBlock(2).block, storage.getBlockByIndex(1).block);
+  ASSERT_FALSE(boost::filesystem::exists(SWAPPED_BLOCKS_FILE_NAME));
+  ASSERT_FALSE(boost::filesystem::exists(BLOCKS_FILE_NAME + ".import"));
+}
+
+TEST_F(MainChainStorageTest, pruneBlocksDropsOldBlocksOnly) {
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    for (uint8_t i = 0; i < 10; ++i) {
+      storage.pushBlock(makeBlock(i));
+    }
+
+    uint64_t sizeBefore = boost::filesystem::file_size(BLOCKS_FILE_NAME);
+    storage.pruneBlocks(6);
+    ASSERT_LT(boost::filesystem::file_size(BLOCKS_FILE_NAME), sizeBefore);
+
+    ASSERT_EQ(10, storage.getBlockCount());
+    ASSERT_EQ(6, storage.getPrunedBlockCount());
+    ASSERT_THROW(storage.getBlockByIndex(5), std::out_of_range);
+    ASSERT_EQ(makeBlock(6).block, storage.getBlockByIndex(6).block);
+
+    storage.popBlock();
+    storage.pushBlock(makeBlock(20));
+    storage.pruneBlocks(3);
+    ASSERT_EQ(6, storage.getPrunedBlockCount());
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  ASSERT_EQ(10, storage.getBlockCount());
+  ASSERT_EQ(6, storage.getPrunedBlockCount());
+  ASSERT_EQ(makeBlock(8).transactions, storage.getBlockByIndex(8).transactions);
+  ASSERT_EQ(makeBlock(20).block, storage.getBlockByIndex(9).block);
+}
+
+TEST_F(MainChainStorageTest, prunedBlocksCantBePopped) {
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  storage.pushBlock(makeBlock(1));
+  storage.pushBlock(makeBlock(2));
+  storage.pruneBlocks(1);
+
+  storage.popBlock();
+  ASSERT_THROW(storage.popBlock(), std::runtime_error);
+
+  storage.clear();
+  ASSERT_EQ(0, storage.getPrunedBlockCount());
+  storage.pushBlock(makeBlock(3));
+  ASSERT_EQ(makeBlock(3).block, storage.getBlockByIndex(0).block);
+}
+
+TEST_F(MainChainStorageTest, dropsBytesLeftByInterruptedGrowth) {
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    storage.pushBlock(makeBlock(1));
+    storage.pushBlock(makeBlock(2));
+    storage.pruneBlocks(1);
+  }
+
+  // interrupted growth: the file is extended, the capacity isn't updated
+  uint64_t fileSize = boost::filesystem::file_size(BLOCKS_FILE_NAME);
+  boost::filesystem::resize_file(BLOCKS_FILE_NAME, fileSize + 1000);
+
+  {
+    MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+    ASSERT_EQ(fileSize, boost::filesystem::file_size(BLOCKS_FILE_NAME));
+    ASSERT_EQ(1, storage.getPrunedBlockCount());
+    storage.pushBlock(makeBlock(3));
+  }
+
+  MainChainStorage storage(BLOCKS_FILE_NAME, INDEXES_FILE_NAME);
+  ASSERT_EQ(3, storage.getBlockCount());
+  ASSERT_EQ(1, storage.getPrunedBlockCount());
+  ASSERT_EQ(makeBlock(2).block, storage.getBlockByIndex(1).block);
+  ASSERT_EQ(makeBlock(3).block, storage.getBlockByIndex(2).block);
+}
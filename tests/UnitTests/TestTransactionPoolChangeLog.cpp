@@ -0,0 +1,90 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/ConsoleLogger.h"
+#include "TransactionPoolTestUtils.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t CHANGE_LOG_CAPACITY = 4;
+
+Crypto::Hash getHash(uint8_t id) {
+  return createPoolTestTransaction(id).getTransactionHash();
+}
+
+class TransactionPoolChangeLogTest : public ::testing::Test {
+public:
+  TransactionPoolChangeLogTest() : pool(logger, 0, CHANGE_LOG_CAPACITY) {
+  }
+
+  bool push(uint8_t id) {
+    auto transaction = createPoolTestTransaction(id);
+    auto state = createPoolTestState(transaction);
+
+    std::vector<Crypto::Hash> evictedTransactions;
+    return pool.pushTransaction(std::move(transaction), std::move(state), evictedTransactions);
+  }
+
+  Logging::ConsoleLogger logger;
+  TransactionPool pool;
+};
+
+}
+
+TEST_F(TransactionPoolChangeLogTest, returnsLastChangeOfEachTransaction) {
+  ASSERT_TRUE(push(1));
+  uint64_t sequence = pool.getChangeSequence();
+
+  ASSERT_TRUE(push(2));
+  ASSERT_TRUE(push(3));
+  ASSERT_TRUE(pool.removeTransaction(getHash(1)));
+  ASSERT_TRUE(pool.removeTransaction(getHash(2)));
+  ASSERT_EQ(sequence + 4, pool.getChangeSequence());
+
+  std::vector<Crypto::Hash> added;
+  std::vector<Crypto::Hash> deleted;
+  ASSERT_TRUE(pool.getChangesSince(sequence, added, deleted));
+  ASSERT_EQ(std::vector<Crypto::Hash>{ getHash(3) }, added);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ getHash(1), getHash(2) }), deleted);
+
+  added.clear();
+  deleted.clear();
+  ASSERT_TRUE(pool.getChangesSince(pool.getChangeSequence(), added, deleted));
+  ASSERT_TRUE(added.empty());
+  ASSERT_TRUE(deleted.empty());
+}
+
+TEST_F(TransactionPoolChangeLogTest, failsWhenChangesLeftTheLog) {
+  uint64_t sequence = pool.getChangeSequence();
+  for (uint8_t id = 1; id <= CHANGE_LOG_CAPACITY + 1; ++id) {
+    ASSERT_TRUE(push(id));
+  }
+
+  std::vector<Crypto::Hash> added;
+  std::vector<Crypto::Hash> deleted;
+  ASSERT_FALSE(pool.getChangesSince(sequence, added, deleted));
+  ASSERT_FALSE(pool.getChangesSince(pool.getChangeSequence() + 1, added, deleted));
+
+  ASSERT_TRUE(pool.getChangesSince(sequence + 1, added, deleted));
+  ASSERT_EQ(CHANGE_LOG_CAPACITY, added.size());
+  ASSERT_EQ(getHash(2), added.front());
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionPoolCleaner.h"
+#include "Logging/ConsoleLogger.h"
+#include "TransactionPoolTestUtils.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t TIMEOUT = 100;
+
+// the pool stamps transactions with the real time, the cleaner is moved ahead of it
+class FakeTimeProvider : public ITimeProvider {
+public:
+  explicit FakeTimeProvider(time_t& offset) : offset(offset) {
+  }
+
+  virtual time_t now() override {
+    return time(nullptr) + offset;
+  }
+
+private:
+  time_t& offset;
+};
+
+class TransactionPoolCleanerTest : public ::testing::Test {
+public:
+  TransactionPoolCleanerTest() :
+    offset(0),
+    pool(std::unique_ptr<ITransactionPool>(new TransactionPool(logger)),
+         std::unique_ptr<ITimeProvider>(new FakeTimeProvider(offset)), logger, TIMEOUT) {
+  }
+
+  bool push(uint8_t id) {
+    auto transaction = createPoolTestTransaction(id);
+    auto state = createPoolTestState(transaction);
+
+    std::vector<Crypto::Hash> evictedTransactions;
+    return pool.pushTransaction(std::move(transaction), std::move(state), evictedTransactions);
+  }
+
+  Logging::ConsoleLogger logger;
+  time_t offset;
+  TransactionPoolCleanWrapper pool;
+};
+
+}
+
+TEST_F(TransactionPoolCleanerTest, deletesTransactionsWhenTheyExpire) {
+  ASSERT_TRUE(push(1));
+  ASSERT_TRUE(push(2));
+
+  offset = TIMEOUT - 10;
+  ASSERT_TRUE(pool.clean().empty());
+  ASSERT_EQ(2, pool.getTransactionCount());
+
+  offset = TIMEOUT + 10;
+  ASSERT_EQ(2, pool.clean().size());
+  ASSERT_EQ(0, pool.getTransactionCount());
+  ASSERT_TRUE(pool.getTransactionHashesReceivedBefore(std::numeric_limits<uint64_t>::max()).empty());
+}
+
+TEST_F(TransactionPoolCleanerTest, forgetsDeletedTransactionsAfterTimeout) {
+  ASSERT_TRUE(push(1));
+
+  offset = TIMEOUT + 10;
+  ASSERT_EQ(1, pool.clean().size());
+  ASSERT_FALSE(push(1));
+
+  offset += TIMEOUT;
+  ASSERT_TRUE(pool.clean().empty());
+  ASSERT_TRUE(push(1));
+}
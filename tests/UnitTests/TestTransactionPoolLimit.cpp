@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/ConsoleLogger.h"
+#include "TransactionPoolTestUtils.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class TransactionPoolLimitTest : public ::testing::Test {
+public:
+  TransactionPoolLimitTest() :
+    transactionSize(createPoolTestTransaction(0, 0).getTransactionBinaryArray().size()),
+    pool(logger, 2 * transactionSize) {
+  }
+
+  bool push(uint64_t fee, uint8_t id, std::vector<Crypto::Hash>& evictedTransactions) {
+    auto transaction = createPoolTestTransaction(id, fee);
+    auto state = createPoolTestState(transaction);
+    return pool.pushTransaction(std::move(transaction), std::move(state), evictedTransactions);
+  }
+
+  Logging::ConsoleLogger logger;
+  size_t transactionSize;
+  TransactionPool pool;
+};
+
+}
+
+TEST_F(TransactionPoolLimitTest, evictsLeastProfitableTransactions) {
+  std::vector<Crypto::Hash> evictedTransactions;
+  ASSERT_TRUE(push(10, 1, evictedTransactions));
+  ASSERT_TRUE(push(20, 2, evictedTransactions));
+  ASSERT_TRUE(evictedTransactions.empty());
+
+  ASSERT_TRUE(push(30, 3, evictedTransactions));
+  ASSERT_EQ(std::vector<Crypto::Hash>{ createPoolTestTransaction(1, 10).getTransactionHash() }, evictedTransactions);
+  ASSERT_EQ(2, pool.getTransactionCount());
+  ASSERT_EQ(2 * transactionSize, pool.getTransactionsSize());
+  ASSERT_FALSE(pool.checkIfTransactionPresent(createPoolTestTransaction(1, 10).getTransactionHash()));
+  ASSERT_EQ(0, pool.getPoolTransactionValidationState().spentKeyImages.count(
+    boost::get<KeyInput>(createPoolTestTransaction(1, 10).getTransaction().inputs[0]).keyImage));
+}
+
+TEST_F(TransactionPoolLimitTest, rejectsTransactionNotMoreProfitableThanPool) {
+  std::vector<Crypto::Hash> evictedTransactions;
+  ASSERT_TRUE(push(10, 1, evictedTransactions));
+  ASSERT_TRUE(push(20, 2, evictedTransactions));
+
+  ASSERT_FALSE(push(10, 3, evictedTransactions));
+  ASSERT_FALSE(push(5, 4, evictedTransactions));
+  ASSERT_TRUE(evictedTransactions.empty());
+  ASSERT_EQ(2, pool.getTransactionCount());
+}
+
+TEST_F(TransactionPoolLimitTest, visitsTransactionsByFeePerByte) {
+  std::vector<Crypto::Hash> evictedTransactions;
+  ASSERT_TRUE(push(10, 1, evictedTransactions));
+  ASSERT_TRUE(push(20, 2, evictedTransactions));
+
+  std::vector<uint64_t> fees;
+  pool.forEachTransaction(true, [&fees](const CachedTransaction& transaction) {
+    fees.push_back(transaction.getTransactionFee());
+    return true;
+  });
+
+  ASSERT_EQ(std::vector<uint64_t>({ 20, 10 }), fees);
+
+  fees.clear();
+  pool.forEachTransaction(false, [&fees](const CachedTransaction& transaction) {
+    fees.push_back(transaction.getTransactionFee());
+    return false;
+  });
+
+  ASSERT_EQ(std::vector<uint64_t>({ 10 }), fees);
+}
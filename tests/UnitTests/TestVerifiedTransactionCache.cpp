@@ -0,0 +1,80 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/VerifiedTransactionCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint8_t value) {
+  Crypto::Hash hash = {};
+  hash.data[0] = value;
+  return hash;
+}
+
+// transactions are told apart by their input count
+VerifiedTransaction makeTransaction(size_t inputCount) {
+  VerifiedTransaction transaction;
+  transaction.keyImagesChecked = true;
+  transaction.outputKeys.resize(inputCount);
+  for (auto& keys : transaction.outputKeys) {
+    keys.push_back(Crypto::PublicKey());
+  }
+
+  return transaction;
+}
+
+}
+
+TEST(VerifiedTransactionCache, findsAddedTransaction) {
+  VerifiedTransactionCache cache(10);
+  cache.add(makeHash(1), makeTransaction(5));
+
+  const VerifiedTransaction* transaction = cache.find(makeHash(1));
+  ASSERT_NE(nullptr, transaction);
+  ASSERT_EQ(5, transaction->outputKeys.size());
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+}
+
+TEST(VerifiedTransactionCache, evictsOldestTransaction) {
+  VerifiedTransactionCache cache(2);
+  cache.add(makeHash(1), makeTransaction(1));
+  cache.add(makeHash(2), makeTransaction(2));
+  cache.add(makeHash(1), makeTransaction(3));
+  cache.add(makeHash(3), makeTransaction(4));
+
+  ASSERT_EQ(2, cache.size());
+  ASSERT_NE(nullptr, cache.find(makeHash(1)));
+  ASSERT_EQ(3, cache.find(makeHash(1))->outputKeys.size());
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+  ASSERT_NE(nullptr, cache.find(makeHash(3)));
+}
+
+TEST(VerifiedTransactionCache, removeAndClear) {
+  VerifiedTransactionCache cache(10);
+  cache.add(makeHash(1), makeTransaction(1));
+  cache.add(makeHash(2), makeTransaction(2));
+
+  cache.remove(makeHash(1));
+  ASSERT_EQ(nullptr, cache.find(makeHash(1)));
+  ASSERT_EQ(1, cache.size());
+
+  cache.clear();
+  ASSERT_EQ(0, cache.size());
+}
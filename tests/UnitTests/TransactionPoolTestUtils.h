@@ -0,0 +1,54 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/TransactionValidatiorState.h"
+
+namespace CryptoNote {
+
+const uint64_t POOL_TEST_OUTPUT_AMOUNT = 1000;
+
+// Transaction with a single key input and output which is distinguished by its key image. All such transactions
+// have the same size, so the fee defines the fee per byte. Signatures aren't valid, the pool doesn't check them
+inline CachedTransaction createPoolTestTransaction(uint8_t id, uint64_t fee = 10) {
+  KeyInput input = KeyInput();
+  input.amount = POOL_TEST_OUTPUT_AMOUNT + fee;
+  input.keyImage.data[0] = id;
+  input.outputIndexes = { 0 };
+
+  TransactionOutput output;
+  output.amount = POOL_TEST_OUTPUT_AMOUNT;
+  output.target = KeyOutput{ Crypto::PublicKey() };
+
+  Transaction transaction;
+  transaction.version = 1;
+  transaction.unlockTime = 0;
+  transaction.inputs.push_back(input);
+  transaction.outputs.push_back(output);
+  transaction.signatures.push_back({ Crypto::Signature() });
+  return CachedTransaction(std::move(transaction));
+}
+
+inline TransactionValidatorState createPoolTestState(const CachedTransaction& transaction) {
+  TransactionValidatorState state;
+  state.spentKeyImages.insert(boost::get<KeyInput>(transaction.getTransaction().inputs[0]).keyImage);
+  return state;
+}
+
+}
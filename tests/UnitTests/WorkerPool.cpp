@@ -0,0 +1,86 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include "Common/WorkerPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace Common;
+
+TEST(WorkerPoolTests, runsEveryJobOnce) {
+  WorkerPool pool(3);
+  std::vector<std::atomic<int>> counters(1000);
+  for (auto& counter : counters) {
+    counter = 0;
+  }
+
+  ASSERT_TRUE(pool.run(counters.size(), [&] (size_t i) { ++counters[i]; return true; }));
+  for (auto& counter : counters) {
+    ASSERT_EQ(1, counter);
+  }
+}
+
+TEST(WorkerPoolTests, canBeReused) {
+  WorkerPool pool(2);
+  for (int i = 0; i < 100; ++i) {
+    std::atomic<size_t> sum(0);
+    ASSERT_TRUE(pool.run(10, [&] (size_t j) { sum += j; return true; }));
+    ASSERT_EQ(45, sum);
+  }
+}
+
+TEST(WorkerPoolTests, runsSeriallyWithoutThreads) {
+  WorkerPool pool(0);
+  std::vector<size_t> order;
+  ASSERT_TRUE(pool.run(5, [&] (size_t i) { order.push_back(i); return true; }));
+  ASSERT_EQ(std::vector<size_t>({0, 1, 2, 3, 4}), order);
+}
+
+TEST(WorkerPoolTests, stopsOnFirstFailure) {
+  WorkerPool pool(0);
+  size_t executed = 0;
+  ASSERT_FALSE(pool.run(10, [&] (size_t i) { ++executed; return i != 3; }));
+  ASSERT_EQ(4, executed);
+}
+
+TEST(WorkerPoolTests, reportsFailureFromWorkerThread) {
+  WorkerPool pool(3);
+  std::atomic<size_t> executed(0);
+  ASSERT_FALSE(pool.run(100000, [&] (size_t i) { ++executed; return i != 10; }));
+  ASSERT_LT(executed, 100000);
+}
+
+TEST(WorkerPoolTests, rethrowsJobException) {
+  WorkerPool pool(2);
+  ASSERT_THROW(pool.run(100, [] (size_t i) -> bool {
+    if (i == 50) {
+      throw std::runtime_error("job failed");
+    }
+
+    return true;
+  }), std::runtime_error);
+
+  ASSERT_TRUE(pool.run(100, [] (size_t) { return true; }));
+}
+
+TEST(WorkerPoolTests, emptyRunSucceeds) {
+  WorkerPool pool(2);
+  ASSERT_TRUE(pool.run(0, [] (size_t) { return false; }));
+}
@@ -254,6 +254,14 @@ int main(int argc, char *argv[]) {
       if (expected != actual) {
         goto error;
       }
+      {
+        Crypto::RingSignatureEntry entries[2];
+        entries[0] = { &prefix_hash, &image, pubs.data(), pubs_count, sigs.data(), true };
+        entries[1] = entries[0];
+        if (check_ring_signatures(entries, 1) != expected || check_ring_signatures(entries, 2) != expected) {
+          goto error;
+        }
+      }
     } else {
       throw ios_base::failure("Unknown function: " + cmd);
     }